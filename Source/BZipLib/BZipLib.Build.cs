@@ -13,7 +13,9 @@ public class BZipLib : ModuleRules
             new string[]
             {
                 "Core",
-                "zlib"
+                "zlib",
+                "zstd",
+                "liblzma"
             });
 
         PrivateDependencyModuleNames.AddRange(
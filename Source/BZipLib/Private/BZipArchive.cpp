@@ -2,8 +2,204 @@
 /// Petr Benes - https://bitbucket.org/wbenny/ziplib
 
 #include "BZipArchive.h"
+#include "detail/Zip64ExtendedInformationExtraField.h"
 #include "streams/serialization.h"
+#include "streams/memstream.h"
+#include "streams/spillstream.h"
+#include "utils/sha1_utils.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/ScopeExit.h"
+#include "Async/Async.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <tuple>
+
+namespace
+{
+	/**
+	 * \brief Finds the end of central directory record in the tail of the archive.
+	 *        Prefers the last signature whose comment length reaches exactly the end of the file,
+	 *        otherwise falls back to the last signature found.
+	 */
+	const uint8* FindEndOfCentralDirectory(const uint8* tail, size_t tailSize)
+	{
+		const size_t EOCDB_SIZE = detail::EndOfCentralDirectoryBlockBase::SIZE_IN_BYTES;
+		const size_t COMMENT_LENGTH_OFFSET = EOCDB_SIZE - sizeof(uint16);
+		const uint8 SIGNATURE_FIRST_BYTE = detail::EndOfCentralDirectoryBlock::SignatureConstant & 0xff;
+
+		const uint8* lastCandidate = nullptr;
+		const uint8* lastValidCandidate = nullptr;
+
+		if (tailSize < EOCDB_SIZE)
+		{
+			return nullptr;
+		}
+
+		// memchr is vectorized by the C runtime, so only the few
+		// positions starting with 'P' are compared as whole words
+		const uint8* cursor = tail;
+		const uint8* lastStart = tail + tailSize - EOCDB_SIZE;
+
+		while (cursor <= lastStart)
+		{
+			cursor = static_cast<const uint8*>(memchr(cursor, SIGNATURE_FIRST_BYTE, static_cast<size_t>(lastStart - cursor) + 1));
+
+			if (cursor == nullptr)
+			{
+				break;
+			}
+
+			uint32 signature;
+			memcpy(&signature, cursor, sizeof(signature));
+
+			if (signature == detail::EndOfCentralDirectoryBlock::SignatureConstant)
+			{
+				uint16 commentLength;
+				memcpy(&commentLength, cursor + COMMENT_LENGTH_OFFSET, sizeof(commentLength));
+
+				lastCandidate = cursor;
+
+				if (static_cast<size_t>(tail + tailSize - cursor) == EOCDB_SIZE + commentLength)
+				{
+					lastValidCandidate = cursor;
+				}
+			}
+
+			++cursor;
+		}
+
+		return lastValidCandidate != nullptr ? lastValidCandidate : lastCandidate;
+	}
+
+	// fixed part of the central directory file header, see ZipCentralDirectoryFileHeaderBase
+	const size_t CDFH_SIZE = detail::ZipCentralDirectoryFileHeaderBase::SIZE_IN_BYTES;
+	const size_t CDFH_FILENAME_LENGTH_OFFSET = 28;
+	const size_t CDFH_EXTRA_FIELD_LENGTH_OFFSET = 30;
+	const size_t CDFH_FILE_COMMENT_LENGTH_OFFSET = 32;
+
+	const size_t ZIP64_EOCDL_SIZE = detail::Zip64EndOfCentralDirectoryLocator::SIZE_IN_BYTES;
+	const size_t ZIP64_EOCDB_SIZE = detail::Zip64EndOfCentralDirectoryBlock::SIZE_IN_BYTES;
+
+	// version 4.5 of the specification introduced ZIP64
+	const uint16 ZIP64_VERSION_NEEDED = 45;
+
+	const uint32 LAZY_SLOT_EMPTY = MAX_uint32;
+	const uint32 LAZY_SLOT_REMOVED = MAX_uint32 - 1;
+
+	size_t ReadFromStream(std::istream& stream, uint64 offset, void* buffer, size_t size)
+	{
+		stream.clear();
+		stream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+		stream.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+
+		size_t n = static_cast<size_t>(stream.gcount());
+
+		// reaching the end must not fail the next read
+		stream.clear();
+		return n;
+	}
+
+	// how many entries per worker the parallel compression may run ahead of the writer
+	const int32 PARALLEL_COMPRESSION_ENTRIES_PER_WORKER = 2;
+
+	/**
+	 * \brief State shared by the workers and the writer of the parallel WriteToStream.
+	 */
+	struct ParallelCompressionState
+	{
+		std::mutex Mutex;
+		std::condition_variable Condition;
+
+		int32 Window = 0;
+		int32 NextToClaim = 0;
+		int32 NextToWrite = 0;
+		bool IsComplete = false;   //< no more entries are added
+
+		TArray<BZipArchiveEntry*> Entries;   //< the archive may add entries while they are compressed
+		TArray<bool> NeedsCompression;
+		TArray<bool> IsDone;
+		TArray<TSharedPtr<spillstream>> Buffers;
+
+		std::exception_ptr Failure;   //< of the first entry whose compression failed, rethrown by the writer
+
+		/**
+		 * \brief Takes the next entry to compress, waiting while the compression is too far ahead of the writer,
+		 *        or while the next entries are not added yet.
+		 *
+		 * \return INDEX_NONE when there is nothing left to compress.
+		 */
+		int32 Claim(BZipArchiveEntry*& entry)
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+
+			for (;;)
+			{
+				while (NextToClaim < NeedsCompression.Num() && !NeedsCompression[NextToClaim])
+				{
+					NextToClaim++;
+				}
+
+				if (NextToClaim >= NeedsCompression.Num() && IsComplete)
+				{
+					return INDEX_NONE;
+				}
+
+				if (NextToClaim < NeedsCompression.Num() && NextToClaim < NextToWrite + Window)
+				{
+					entry = Entries[NextToClaim];
+					return NextToClaim++;
+				}
+
+				Condition.wait(lock);
+			}
+		}
+
+		/**
+		 * \brief Lets the workers finish their entries and stop claiming new ones, the lock must be held.
+		 */
+		void Stop()
+		{
+			NextToClaim = NeedsCompression.Num();
+			IsComplete = true;
+			Condition.notify_all();
+		}
+
+		void Cancel()
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			this->Stop();
+		}
+
+		/**
+		 * \brief Lets the workers stop once they have compressed all the entries.
+		 */
+		void Complete()
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			IsComplete = true;
+			Condition.notify_all();
+		}
+	};
+
+	bool IsValidRawFilename(const uint8* filename, size_t length)
+	{
+		// the filename must not be empty after the normalization
+		for (size_t i = 0; i < length; i++)
+		{
+			if (filename[i] != '/' && filename[i] != '\\')
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
 
 #define CALL_CONST_METHOD(expression) \
   const_cast<      std::remove_pointer<std::remove_const<decltype(expression)>::type>::type*>( \
@@ -21,24 +217,18 @@ TSharedPtr<BZipArchive> BZipArchive::Create(TSharedPtr<BZipArchive>&& other)
 {
 	TSharedPtr<BZipArchive> result(new BZipArchive());
 
-	result->_endOfCentralDirectoryBlock = other->_endOfCentralDirectoryBlock;
-	result->_entries = std::move(other->_entries);
-	result->_zipStream = other->_zipStream;
-	result->_owningStream = other->_owningStream;
-
-	// clean "other"
-	other->_zipStream = nullptr;
-	other->_owningStream = false;
+	*result = std::move(*other);
 
 	return result;
 }
 
-TSharedPtr<BZipArchive> BZipArchive::Create(std::istream& stream)
+TSharedPtr<BZipArchive> BZipArchive::Create(std::istream& stream, EntryLoadingMode loadingMode /* = EntryLoadingMode::Eager */)
 {
 	TSharedPtr<BZipArchive> result(new BZipArchive());
 
 	result->_zipStream = &stream;
 	result->_owningStream = false;
+	result->_entryLoadingMode = loadingMode;
 
 	result->ReadEndOfCentralDirectory();
 	result->EnsureCentralDirectoryRead();
@@ -46,12 +236,13 @@ TSharedPtr<BZipArchive> BZipArchive::Create(std::istream& stream)
 	return result;
 }
 
-TSharedPtr<BZipArchive> BZipArchive::Create(std::istream* stream, bool takeOwnership)
+TSharedPtr<BZipArchive> BZipArchive::Create(std::istream* stream, bool takeOwnership, EntryLoadingMode loadingMode /* = EntryLoadingMode::Eager */)
 {
 	TSharedPtr<BZipArchive> result(new BZipArchive());
 
 	result->_zipStream = stream;
 	result->_owningStream = stream != nullptr ? takeOwnership : false;
+	result->_entryLoadingMode = loadingMode;
 
 	if (stream != nullptr)
 	{
@@ -62,9 +253,78 @@ TSharedPtr<BZipArchive> BZipArchive::Create(std::istream* stream, bool takeOwner
 	return result;
 }
 
+TSharedPtr<BZipArchive> BZipArchive::CreateFromFile(const FString& path, EntryLoadingMode loadingMode /* = EntryLoadingMode::Eager */)
+{
+	std::ifstream* zipFile = new std::ifstream();
+	zipFile->open(TCHAR_TO_UTF8(*path), std::ios::binary);
+
+	if (!zipFile->is_open())
+	{
+		delete zipFile;
+		return nullptr;
+	}
+
+	TSharedPtr<BZipArchive> result = BZipArchive::Create(zipFile, true, loadingMode);
+
+	// from now on the entries read through the pool of handles
+	result->_filePath = path;
+
+	return result;
+}
+
+TSharedPtr<BZipArchive> BZipArchive::CreateFromMemory(TArrayView<const uint8> data, EntryLoadingMode loadingMode /* = EntryLoadingMode::Eager */)
+{
+	TSharedPtr<BZipArchive> result(new BZipArchive());
+
+	result->SetMemory(data.GetData(), static_cast<uint64>(data.Num()));
+	result->_entryLoadingMode = loadingMode;
+
+	result->ReadEndOfCentralDirectory();
+	result->EnsureCentralDirectoryRead();
+
+	return result;
+}
+
+TSharedPtr<BZipArchive> BZipArchive::OpenMapped(const FString& path, EntryLoadingMode loadingMode /* = EntryLoadingMode::Eager */)
+{
+	TUniquePtr<IMappedFileHandle> mappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*path));
+
+	if (!mappedFile.IsValid())
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<IMappedFileRegion> mappedRegion(mappedFile->MapRegion());
+
+	if (!mappedRegion.IsValid())
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<BZipArchive> result(new BZipArchive());
+
+	result->SetMemory(mappedRegion->GetMappedPtr(), static_cast<uint64>(mappedRegion->GetMappedSize()));
+	result->_mappedFile = std::move(mappedFile);
+	result->_mappedRegion = std::move(mappedRegion);
+	result->_entryLoadingMode = loadingMode;
+
+	result->ReadEndOfCentralDirectory();
+	result->EnsureCentralDirectoryRead();
+
+	return result;
+}
+
 BZipArchive::BZipArchive()
-	: _zipStream(nullptr)
+	: _hasZip64EndOfCentralDirectory(false)
+	, _entryNameIndex(0, utils::entry_name_hash(true), utils::entry_name_equal(true))
+	, _hasDuplicateEntryNames(false)
+	, _deduplicateEntries(false)
+	, _entryLoadingMode(EntryLoadingMode::Eager)
+	, _lazyEntriesCount(0)
+	, _zipStream(nullptr)
 	, _owningStream(false)
+	, _memoryData(nullptr)
+	, _memorySize(0)
 {
 
 }
@@ -77,13 +337,39 @@ BZipArchive::~BZipArchive()
 BZipArchive& BZipArchive::operator = (BZipArchive&& other)
 {
 	_endOfCentralDirectoryBlock = other._endOfCentralDirectoryBlock;
+	_zip64EndOfCentralDirectoryBlock = other._zip64EndOfCentralDirectoryBlock;
+	_hasZip64EndOfCentralDirectory = other._hasZip64EndOfCentralDirectory;
 	_entries = std::move(other._entries);
+	_entryNameIndex = std::move(other._entryNameIndex);
+	_hasDuplicateEntryNames = other._hasDuplicateEntryNames;
+	_deduplicateEntries = other._deduplicateEntries;
+	_entryLoadingMode = other._entryLoadingMode;
+	_centralDirectory = std::move(other._centralDirectory);
+	_centralDirectoryView = other._centralDirectoryView;
+	_centralDirectoryRecordOffsets = std::move(other._centralDirectoryRecordOffsets);
+	_lazyNameTable = std::move(other._lazyNameTable);
+	_lazyEntriesCount = other._lazyEntriesCount;
 	_zipStream = other._zipStream;
 	_owningStream = other._owningStream;
+	_mappedFile = std::move(other._mappedFile);
+	_mappedRegion = std::move(other._mappedRegion);
+	_memoryData = other._memoryData;
+	_memorySize = other._memorySize;
+	_filePath = std::move(other._filePath);
+	_readHandles = std::move(other._readHandles);
+	this->AdoptEntries();
 
 	// clean "other"
+	other._entries.Empty();
+	other._entryNameIndex.clear();
+	other._hasDuplicateEntryNames = false;
+	other.ReleaseCentralDirectory();
 	other._zipStream = nullptr;
 	other._owningStream = false;
+	other._memoryData = nullptr;
+	other._memorySize = 0;
+	other._filePath.Empty();
+	other._readHandles.Empty();
 
 	return *this;
 }
@@ -97,6 +383,13 @@ TSharedPtr<BZipArchiveEntry> BZipArchive::CreateEntry(const FString& fileName)
 		if ((result = BZipArchiveEntry::CreateNew(this, fileName)) != nullptr)
 		{
 			_entries.Add(result);
+			this->IndexEntry(result.Get());
+
+			// new entries have no record in the central directory
+			if (_centralDirectoryRecordOffsets.Num() > 0)
+			{
+				_centralDirectoryRecordOffsets.Add(MAX_uint32);
+			}
 		}
 	}
 
@@ -115,13 +408,24 @@ void BZipArchive::SetComment(const FString& comment)
 
 TSharedPtr<BZipArchiveEntry> BZipArchive::GetEntry(const FString& entryName)
 {
-	for (int32 i = 0; i < _entries.Num(); i++)
+	std::string normalizedName = utils::string::normalize_entry_name(TCHAR_TO_UTF8(*entryName));
+	BZipArchiveEntry* entry = this->FindIndexedEntry(normalizedName);
+
+	if (entry != nullptr)
+	{
+		return entry->AsShared();
+	}
+
+	if (_lazyEntriesCount > 0)
 	{
-		if (_entries[i].IsValid() && _entries[i]->GetFullName() == entryName)
+		int32 index = this->FindLazyEntry(normalizedName);
+
+		if (index != INDEX_NONE)
 		{
-			return _entries[i];
+			return this->MaterializeEntry(index);
 		}
 	}
+
 	return nullptr;
 }
 
@@ -129,11 +433,35 @@ TSharedPtr<BZipArchiveEntry> BZipArchive::GetEntry(int32 index)
 {
 	if (index >= 0 && index < _entries.Num())
 	{
-		return _entries[index];
+		return this->MaterializeEntry(index);
 	}
 	return nullptr;
 }
 
+void BZipArchive::SetIgnoreCaseInEntryNames(bool ignoreCase)
+{
+	if (ignoreCase != this->IsIgnoringCaseInEntryNames())
+	{
+		_entryNameIndex = EntryNameIndex(0, utils::entry_name_hash(ignoreCase), utils::entry_name_equal(ignoreCase));
+		this->RebuildEntryNameIndex();
+	}
+}
+
+bool BZipArchive::IsIgnoringCaseInEntryNames() const
+{
+	return _entryNameIndex.hash_function().IgnoreCase;
+}
+
+void BZipArchive::SetEntryDeduplication(bool deduplicate)
+{
+	_deduplicateEntries = deduplicate;
+}
+
+bool BZipArchive::IsDeduplicatingEntries() const
+{
+	return _deduplicateEntries;
+}
+
 int32 BZipArchive::GetEntriesCount() const
 {
 	return _entries.Num();
@@ -141,13 +469,16 @@ int32 BZipArchive::GetEntriesCount() const
 
 TSharedPtr<BZipArchiveEntry> BZipArchive::RemoveEntry(const FString& entryName)
 {
-	for (int32 i = 0; i < _entries.Num(); i++)
+	TSharedPtr<BZipArchiveEntry> entry = this->GetEntry(entryName);
+
+	if (entry != nullptr)
 	{
-		if (_entries[i].IsValid() && _entries[i]->GetFullName() == entryName)
+		for (int32 i = 0; i < _entries.Num(); i++)
 		{
-			TSharedPtr<BZipArchiveEntry> Removed = _entries[i];
-			_entries.RemoveAt(i);
-			return Removed;
+			if (_entries[i] == entry)
+			{
+				return this->RemoveEntry(i);
+			}
 		}
 	}
 	return nullptr;
@@ -155,9 +486,23 @@ TSharedPtr<BZipArchiveEntry> BZipArchive::RemoveEntry(const FString& entryName)
 
 TSharedPtr<BZipArchiveEntry> BZipArchive::RemoveEntry(int32 index)
 {
-	if (index >= _entries.Num()) return nullptr;
-	TSharedPtr<BZipArchiveEntry> Removed = _entries[index];
+	if (index < 0 || index >= _entries.Num()) return nullptr;
+	TSharedPtr<BZipArchiveEntry> Removed = this->MaterializeEntry(index);
+	if (!Removed.IsValid() && _lazyEntriesCount > 0)
+	{
+		// a malformed record is dropped as it is
+		this->RemoveLazyEntry(index);
+		return nullptr;
+	}
 	_entries.RemoveAt(index);
+	if (_centralDirectoryRecordOffsets.Num() > 0)
+	{
+		_centralDirectoryRecordOffsets.RemoveAt(index);
+	}
+	if (Removed.IsValid())
+	{
+		this->UnindexEntry(Removed.Get(), Removed->_centralDirectoryFileHeader.Filename);
+	}
 	return Removed;
 }
 
@@ -165,17 +510,63 @@ bool BZipArchive::EnsureCentralDirectoryRead()
 {
 	detail::ZipCentralDirectoryFileHeader zipCentralDirectoryFileHeader;
 
-	_zipStream->seekg(_endOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber, std::ios::beg);
+	const uint64 sizeOfCentralDirectory = this->GetSizeOfCentralDirectory();
+	const uint64 offsetOfCentralDirectory = this->GetOffsetOfCentralDirectory();
 
-	while (zipCentralDirectoryFileHeader.Deserialize(*_zipStream))
+	// do not trust the count blindly, every record takes at least CDFH_SIZE bytes
+	const int32 numberOfEntries = static_cast<int32>(std::min<uint64>(this->GetNumberOfEntriesInCentralDirectory(), sizeOfCentralDirectory / CDFH_SIZE));
+
+	_entries.Reserve(_entries.Num() + numberOfEntries);
+
+	// in the lazy mode the entries are indexed one by one as they are materialized
+	if (_entryLoadingMode == EntryLoadingMode::Eager)
+	{
+		_entryNameIndex.reserve(_entryNameIndex.size() + numberOfEntries);
+	}
+
+	// read the whole central directory at once and parse it in the memory,
+	// unless it does not fit into a single buffer
+	if (sizeOfCentralDirectory > 0 && sizeOfCentralDirectory <= static_cast<uint64>(MAX_int32))
 	{
-		TSharedPtr<BZipArchiveEntry> newEntry;
+		TArray<uint8> centralDirectory;
+		const uint8* begin = this->ReadBlock(offsetOfCentralDirectory, static_cast<size_t>(sizeOfCentralDirectory), centralDirectory);
 
-		if ((newEntry = BZipArchiveEntry::CreateExisting(this, zipCentralDirectoryFileHeader)) != nullptr)
+		if (begin != nullptr)
 		{
-			_entries.Add(newEntry);
+			if (_entryLoadingMode == EntryLoadingMode::Lazy)
+			{
+				// memory backed archives keep pointing into their memory
+				_centralDirectory = std::move(centralDirectory);
+				_centralDirectoryView = TArrayView<const uint8>(begin, static_cast<int32>(sizeOfCentralDirectory));
+				this->AddLazyEntries();
+				return true;
+			}
+
+			const uint8* cursor = begin;
+			const uint8* end = cursor + sizeOfCentralDirectory;
+
+			while (zipCentralDirectoryFileHeader.Deserialize(cursor, end))
+			{
+				this->AddExistingEntry(zipCentralDirectoryFileHeader);
+
+				// ensure clearing of the CDFH struct
+				zipCentralDirectoryFileHeader = detail::ZipCentralDirectoryFileHeader();
+			}
+
+			return true;
 		}
 
+		// the size in the end of central directory block is not trustworthy,
+		// fall back to reading header by header
+	}
+
+	_zipStream->clear();
+	_zipStream->seekg(static_cast<std::streamoff>(offsetOfCentralDirectory), std::ios::beg);
+
+	while (zipCentralDirectoryFileHeader.Deserialize(*_zipStream))
+	{
+		this->AddExistingEntry(zipCentralDirectoryFileHeader);
+
 		// ensure clearing of the CDFH struct
 		zipCentralDirectoryFileHeader = detail::ZipCentralDirectoryFileHeader();
 	}
@@ -183,88 +574,1001 @@ bool BZipArchive::EnsureCentralDirectoryRead()
 	return true;
 }
 
+void BZipArchive::AddExistingEntry(detail::ZipCentralDirectoryFileHeader& cd)
+{
+	TSharedPtr<BZipArchiveEntry> newEntry;
+
+	if ((newEntry = BZipArchiveEntry::CreateExisting(this, cd)) != nullptr)
+	{
+		_entries.Add(newEntry);
+		this->IndexEntry(newEntry.Get());
+	}
+}
+
 bool BZipArchive::ReadEndOfCentralDirectory()
 {
-	const int EOCDB_SIZE = 22; // sizeof(EndOfCentralDirectoryBlockBase);
-	const int SIGNATURE_SIZE = 4;  // sizeof(std::declval<EndOfCentralDirectoryBlockBase>().Signature);
-	const int MIN_SHIFT = (EOCDB_SIZE - SIGNATURE_SIZE);
+	const size_t EOCDB_SIZE = detail::EndOfCentralDirectoryBlockBase::SIZE_IN_BYTES;
+	const size_t MAX_COMMENT_SIZE = 0xffff;
+
+	uint64 fileSize = _memorySize;
+
+	if (!this->IsMemoryBacked())
+	{
+		_zipStream->seekg(0, std::ios::end);
+		std::streamoff endPosition = _zipStream->tellg();
+		fileSize = endPosition > 0 ? static_cast<uint64>(endPosition) : 0;
+	}
+
+	if (fileSize < EOCDB_SIZE)
+	{
+		return false;
+	}
+
+	// the record is somewhere within the last 64 KB + 22 bytes, read them at once
+	const size_t tailSize = static_cast<size_t>(std::min<uint64>(fileSize, EOCDB_SIZE + MAX_COMMENT_SIZE));
+	const uint64 offsetOfTail = fileSize - tailSize;
+
+	TArray<uint8> tailStorage;
+	const uint8* tail = this->ReadBlock(offsetOfTail, tailSize, tailStorage);
+
+	if (tail == nullptr)
+	{
+		return false;
+	}
+
+	const uint8* endOfCentralDirectory = FindEndOfCentralDirectory(tail, tailSize);
+
+	if (endOfCentralDirectory == nullptr)
+	{
+		return false;
+	}
+
+	const uint64 offsetOfEndOfCentralDirectory = offsetOfTail + static_cast<uint64>(endOfCentralDirectory - tail);
+
+	if (!_endOfCentralDirectoryBlock.Deserialize(endOfCentralDirectory, tail + tailSize))
+	{
+		return false;
+	}
+
+	_hasZip64EndOfCentralDirectory = this->ReadZip64EndOfCentralDirectory(offsetOfEndOfCentralDirectory);
+
+	return true;
+}
+
+bool BZipArchive::ReadZip64EndOfCentralDirectory(uint64 offsetOfEndOfCentralDirectory)
+{
+	// the ZIP64 locator precedes the end of central directory record
+	if (offsetOfEndOfCentralDirectory < ZIP64_EOCDL_SIZE)
+	{
+		return false;
+	}
+
+	TArray<uint8> locatorStorage;
+	const uint8* locator = this->ReadBlock(offsetOfEndOfCentralDirectory - ZIP64_EOCDL_SIZE, ZIP64_EOCDL_SIZE, locatorStorage);
 
-	_zipStream->seekg(-MIN_SHIFT, std::ios::end);
+	detail::Zip64EndOfCentralDirectoryLocator zip64Locator;
 
-	if (this->SeekToSignature(detail::EndOfCentralDirectoryBlock::SignatureConstant, SeekDirection::Backward))
+	if (locator == nullptr || !zip64Locator.Deserialize(locator, locator + ZIP64_EOCDL_SIZE))
 	{
-		_endOfCentralDirectoryBlock.Deserialize(*_zipStream);
-		return true;
+		return false;
 	}
 
-	return false;
+	TArray<uint8> recordStorage;
+	const uint8* record = this->ReadBlock(zip64Locator.RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord, ZIP64_EOCDB_SIZE, recordStorage);
+
+	return record != nullptr && _zip64EndOfCentralDirectoryBlock.Deserialize(record, record + ZIP64_EOCDB_SIZE);
+}
+
+void BZipArchive::SetMemory(const uint8* data, uint64 size)
+{
+	_memoryData = data;
+	_memorySize = size;
+
+	// the stream is kept for the code paths which are not memory aware
+	_zipStream = new imemstream(const_cast<char*>(reinterpret_cast<const char*>(data)), static_cast<size_t>(size));
+	_owningStream = true;
 }
 
-bool BZipArchive::SeekToSignature(uint32 signature, SeekDirection direction)
+bool BZipArchive::IsMemoryBacked() const
 {
-	std::streampos streamPosition = _zipStream->tellg();
-	uint32 buffer = 0;
-	int appendix = static_cast<int>(direction == SeekDirection::Backward ? 0 - 1 : 1);
+	return _memoryData != nullptr;
+}
 
-	while (!_zipStream->eof() && !_zipStream->fail())
+const uint8* BZipArchive::ReadBlock(uint64 offset, size_t size, TArray<uint8>& storage)
+{
+	if (this->IsMemoryBacked())
 	{
-		deserialize(*_zipStream, buffer);
+		// no copy, point directly into the memory
+		return offset <= _memorySize && size <= _memorySize - offset ? _memoryData + offset : nullptr;
+	}
+
+	storage.SetNumUninitialized(static_cast<int32>(size));
+
+	return this->read_at(offset, storage.GetData(), size) == size ? storage.GetData() : nullptr;
+}
 
-		if (buffer == signature)
+size_t BZipArchive::read_at(uint64_t offset, void* buffer, size_t size)
+{
+	if (this->IsMemoryBacked())
+	{
+		if (offset >= _memorySize)
 		{
-			_zipStream->seekg(streamPosition, std::ios::beg);
-			return true;
+			return 0;
 		}
 
-		streamPosition += appendix;
-		_zipStream->seekg(streamPosition, std::ios::beg);
+		size_t n = static_cast<size_t>(std::min<uint64>(size, _memorySize - offset));
+		memcpy(buffer, _memoryData + offset, n);
+		return n;
 	}
 
-	return false;
+	if (!_filePath.IsEmpty())
+	{
+		std::istream* handle = this->AcquireReadHandle();
+
+		if (handle == nullptr)
+		{
+			return 0;
+		}
+
+		size_t n = ReadFromStream(*handle, offset, buffer, size);
+		this->ReleaseReadHandle(handle);
+		return n;
+	}
+
+	if (_zipStream == nullptr)
+	{
+		return 0;
+	}
+
+	// a stream given by the caller has a single position, serialize on it
+	FScopeLock lock(&_readLock);
+	return ReadFromStream(*_zipStream, offset, buffer, size);
 }
 
-void BZipArchive::WriteToStream(std::ostream& stream)
+std::istream* BZipArchive::AcquireReadHandle()
 {
-	auto startPosition = stream.tellp();
-
-	for (auto& entry : _entries)
 	{
-		entry->SerializeLocalFileHeader(stream);
+		FScopeLock lock(&_readLock);
+
+		if (_readHandles.Num() > 0)
+		{
+			return _readHandles.Pop();
+		}
 	}
 
-	auto offsetOfStartOfCDFH = stream.tellp() - startPosition;
-	for (auto& entry : _entries)
+	// every thread reading at the same time gets its own handle,
+	// the pool then keeps them until the archive is destroyed
+	std::ifstream* handle = new std::ifstream();
+	handle->open(TCHAR_TO_UTF8(*_filePath), std::ios::binary);
+
+	if (!handle->is_open())
 	{
-		entry->SerializeCentralDirectoryFileHeader(stream);
+		delete handle;
+		return nullptr;
 	}
 
-	_endOfCentralDirectoryBlock.NumberOfThisDisk = 0;
-	_endOfCentralDirectoryBlock.NumberOfTheDiskWithTheStartOfTheCentralDirectory = 0;
+	return handle;
+}
 
-	_endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory = static_cast<uint16>(_entries.Num());
-	_endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectoryOnThisDisk = static_cast<uint16>(_entries.Num());
+void BZipArchive::ReleaseReadHandle(std::istream* handle)
+{
+	FScopeLock lock(&_readLock);
+	_readHandles.Add(handle);
+}
 
-	_endOfCentralDirectoryBlock.SizeOfCentralDirectory = static_cast<uint32>(stream.tellp() - offsetOfStartOfCDFH);
-	_endOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber = static_cast<uint32>(offsetOfStartOfCDFH);
-	_endOfCentralDirectoryBlock.Serialize(stream);
+uint64 BZipArchive::GetNumberOfEntriesInCentralDirectory() const
+{
+	// the ZIP64 record is authoritative only for the fields saturated in the classic record
+	return _hasZip64EndOfCentralDirectory && _endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory == detail::Zip64ExtendedInformationExtraField::SaturatedValue16
+		? _zip64EndOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory
+		: _endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory;
 }
 
-void BZipArchive::Swap(TSharedPtr<BZipArchive> other)
+uint64 BZipArchive::GetSizeOfCentralDirectory() const
 {
-	//if (this == other) return;
-	if (other == nullptr) return;
+	return _hasZip64EndOfCentralDirectory && _endOfCentralDirectoryBlock.SizeOfCentralDirectory == detail::Zip64ExtendedInformationExtraField::SaturatedValue32
+		? _zip64EndOfCentralDirectoryBlock.SizeOfCentralDirectory
+		: _endOfCentralDirectoryBlock.SizeOfCentralDirectory;
+}
 
-	std::swap(_endOfCentralDirectoryBlock, other->_endOfCentralDirectoryBlock);
-	std::swap(_entries, other->_entries);
-	std::swap(_zipStream, other->_zipStream);
-	std::swap(_owningStream, other->_owningStream);
+uint64 BZipArchive::GetOffsetOfCentralDirectory() const
+{
+	return _hasZip64EndOfCentralDirectory && _endOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber == detail::Zip64ExtendedInformationExtraField::SaturatedValue32
+		? _zip64EndOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber
+		: _endOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber;
 }
 
-void BZipArchive::InternalDestroy()
+/**
+ * \brief Identical entries found by FindDuplicateEntries, and the compressed data of their first copies.
+ */
+struct BZipArchive::DuplicateEntries
 {
-	if (_owningStream && _zipStream != nullptr)
+	TArray<int32> OriginalOf;        //< index of the first copy of the entry, INDEX_NONE for the first copies
+	TArray<int32> LastDuplicateOf;   //< index of the last copy of the first copies, INDEX_NONE without copies
+	TArray<TSharedPtr<spillstream>> CompressedData;   //< of the first copies, until their last copy is written
+
+	bool HasDuplicates(int32 index) const
 	{
-		delete _zipStream;
-		_zipStream = nullptr;
+		return LastDuplicateOf[index] != INDEX_NONE;
+	}
+
+	bool IsDuplicate(int32 index) const
+	{
+		return OriginalOf[index] != INDEX_NONE;
+	}
+
+	/**
+	 * \brief The entries added while the archive is written are not deduplicated, their copies could not be known.
+	 */
+	void AddUniqueEntries(int32 numberOfEntries)
+	{
+		while (OriginalOf.Num() < numberOfEntries)
+		{
+			OriginalOf.Add(INDEX_NONE);
+			LastDuplicateOf.Add(INDEX_NONE);
+			CompressedData.AddDefaulted();
+		}
+	}
+};
+
+void BZipArchive::FindDuplicateEntries(DuplicateEntries& duplicates)
+{
+	const int32 numberOfEntries = _entries.Num();
+
+	duplicates.OriginalOf.Init(INDEX_NONE, numberOfEntries);
+	duplicates.LastDuplicateOf.Init(INDEX_NONE, numberOfEntries);
+	duplicates.CompressedData.SetNum(numberOfEntries);
+
+	if (!_deduplicateEntries)
+	{
+		return;
+	}
+
+	// the size, the crc32 and the method sort out most of the entries, only the rest is hashed by SHA-1
+	typedef std::tuple<uint64, uint32, uint16> Prefilter;
+	std::map<Prefilter, TArray<int32>> candidates;
+
+	for (int32 i = 0; i < numberOfEntries; i++)
+	{
+		uint64 size;
+		uint32 crc32;
+
+		if (_entries[i]->HashInput(size, crc32, nullptr))
+		{
+			candidates[Prefilter(size, crc32, _entries[i]->GetCompressionMethod())].Add(i);
+		}
+	}
+
+	for (auto& candidate : candidates)
+	{
+		if (candidate.second.Num() < 2)
+		{
+			continue;
+		}
+
+		std::map<std::string, int32> originals;
+
+		for (int32 index : candidate.second)
+		{
+			uint64 size;
+			uint32 crc32;
+			uint8 digest[utils::sha1::DIGEST_SIZE];
+
+			if (!_entries[index]->HashInput(size, crc32, digest))
+			{
+				continue;
+			}
+
+			auto inserted = originals.emplace(std::string(reinterpret_cast<const char*>(digest), sizeof(digest)), index);
+
+			if (!inserted.second)
+			{
+				// the candidates are in the order of the entries, the first copy is written first
+				const int32 original = inserted.first->second;
+				duplicates.OriginalOf[index] = original;
+				duplicates.LastDuplicateOf[original] = index;
+			}
+		}
+	}
+}
+
+void BZipArchive::WriteDuplicateEntry(int32 index, std::ostream& stream, DuplicateEntries& duplicates)
+{
+	const int32 original = duplicates.OriginalOf[index];
+	TSharedPtr<spillstream>& compressedData = duplicates.CompressedData[original];
+	check(compressedData.IsValid());
+
+	compressedData->clear();
+	compressedData->seekg(0);
+
+	_entries[index]->ShareCompressedData(*_entries[original]);
+	_entries[index]->SerializeLocalFileHeader(stream, compressedData.Get());
+
+	if (duplicates.LastDuplicateOf[original] == index)
+	{
+		compressedData.Reset();
+	}
+}
+
+void BZipArchive::WriteToStream(std::ostream& stream)
+{
+	this->WriteToStreamSerially(stream, nullptr);
+}
+
+void BZipArchive::WriteToStream(std::ostream& stream, int32 numWorkers, uint64 spillThreshold /* = DEFAULT_SPILL_THRESHOLD */)
+{
+	this->WriteToStreamInParallel(stream, numWorkers, spillThreshold, nullptr);
+}
+
+bool BZipArchive::AddEntriesFromSource(const TFunction<bool()>& addEntries, DuplicateEntries& duplicates)
+{
+	const int32 numberOfEntries = _entries.Num();
+
+	// the source may add no entry and still have more to come
+	while (_entries.Num() == numberOfEntries)
+	{
+		if (!addEntries || !addEntries())
+		{
+			break;
+		}
+	}
+
+	duplicates.AddUniqueEntries(_entries.Num());
+	return _entries.Num() > numberOfEntries;
+}
+
+void BZipArchive::WriteToStreamSerially(std::ostream& stream, const TFunction<bool()>& addEntries)
+{
+	this->MaterializeAllEntries();
+
+	// the compressed data which do not fit in the memory share one temporary file
+	const std::shared_ptr<spill_file> spillFile = BZipArchiveEntry::CreateSpillFile();
+
+	DuplicateEntries duplicates;
+	this->FindDuplicateEntries(duplicates);
+
+	auto startPosition = stream.tellp();
+
+	for (int32 i = 0; i < _entries.Num() || this->AddEntriesFromSource(addEntries, duplicates); i++)
+	{
+		if (duplicates.IsDuplicate(i))
+		{
+			this->WriteDuplicateEntry(i, stream, duplicates);
+		}
+		else if (duplicates.HasDuplicates(i) || _entries[i]->NeedsStoreTrial(MAX_STORE_TRIAL_SIZE))
+		{
+			// the data are compressed aside, kept for the copies, and stored instead when the compression does not pay off,
+			// as the data written to the stream could not be taken back. The others are streamed, without the second copy
+			TSharedPtr<spillstream> buffer = MakeShareable<spillstream>(new spillstream(static_cast<size_t>(DEFAULT_SPILL_THRESHOLD), spillFile));
+
+			_entries[i]->Precompress(*buffer);
+			_entries[i]->SerializeLocalFileHeader(stream, buffer.Get());
+
+			if (duplicates.HasDuplicates(i))
+			{
+				duplicates.CompressedData[i] = buffer;
+			}
+		}
+		else
+		{
+			_entries[i]->SerializeLocalFileHeader(stream);
+		}
+	}
+
+	this->WriteCentralDirectory(stream, startPosition);
+}
+
+void BZipArchive::WriteToStreamInParallel(std::ostream& stream, int32 numWorkers, uint64 spillThreshold, const TFunction<bool()>& addEntries)
+{
+	if (numWorkers <= 0)
+	{
+		numWorkers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	}
+
+	if (numWorkers <= 1)
+	{
+		this->WriteToStreamSerially(stream, addEntries);
+		return;
+	}
+
+	this->MaterializeAllEntries();
+
+	// the compressed data which do not fit in the memory share one temporary file
+	const std::shared_ptr<spill_file> spillFile = BZipArchiveEntry::CreateSpillFile();
+
+	DuplicateEntries duplicates;
+	this->FindDuplicateEntries(duplicates);
+
+	auto startPosition = stream.tellp();
+
+	// the writer takes part in the compression too, it never waits for an entry nobody compresses
+	ParallelCompressionState state;
+	state.Window = numWorkers * PARALLEL_COMPRESSION_ENTRIES_PER_WORKER;
+	state.IsComplete = !addEntries;
+
+	// the entries added by the source while the archive is written join the compression
+	auto addToState = [this, &state, &duplicates]()
+	{
+		std::lock_guard<std::mutex> lock(state.Mutex);
+
+		for (int32 i = state.Entries.Num(); i < _entries.Num(); i++)
+		{
+			// the copies take the compressed data of their first copy
+			state.Entries.Add(_entries[i].Get());
+			state.NeedsCompression.Add(_entries[i]->NeedsCompression() && !duplicates.IsDuplicate(i));
+			state.IsDone.Add(false);
+			state.Buffers.AddDefaulted();
+		}
+
+		state.Condition.notify_all();
+	};
+
+	addToState();
+
+	auto compress = [&state, &spillFile, spillThreshold](int32 index, BZipArchiveEntry* entry)
+	{
+		TSharedPtr<spillstream> buffer;
+		std::exception_ptr failure;
+
+#if !PLATFORM_EXCEPTIONS_DISABLED
+		// the slot is reported as done in any case, the writer waits for it
+		try
+#endif
+		{
+			buffer = MakeShareable<spillstream>(new spillstream(static_cast<size_t>(spillThreshold), spillFile));
+
+			entry->Precompress(*buffer);
+		}
+#if !PLATFORM_EXCEPTIONS_DISABLED
+		catch (...)
+		{
+			failure = std::current_exception();
+			buffer.Reset();
+		}
+#endif
+
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.Buffers[index] = buffer;
+		state.IsDone[index] = true;
+
+		if (failure != nullptr && state.Failure == nullptr)
+		{
+			state.Failure = failure;
+			state.Stop();
+		}
+
+		state.Condition.notify_all();
+	};
+
+	TArray<TFuture<void>> workers;
+	for (int32 i = 1; i < numWorkers; i++)
+	{
+		workers.Add(Async(EAsyncExecution::ThreadPool, [&state, &compress]()
+		{
+			int32 index;
+			BZipArchiveEntry* entry;
+			while ((index = state.Claim(entry)) != INDEX_NONE)
+			{
+				compress(index, entry);
+			}
+		}));
+	}
+
+	// the workers use the state, they are stopped also when the writer leaves by an exception
+	ON_SCOPE_EXIT
+	{
+		state.Cancel();
+
+		for (auto& worker : workers)
+		{
+			worker.Wait();
+		}
+	};
+
+	for (int32 i = 0; i < _entries.Num() || this->AddEntriesFromSource(addEntries, duplicates); i++)
+	{
+		TSharedPtr<spillstream> buffer;
+
+		if (i == state.Entries.Num())
+		{
+			addToState();
+		}
+
+		if (duplicates.IsDuplicate(i))
+		{
+			this->WriteDuplicateEntry(i, stream, duplicates);
+		}
+		else
+		{
+			if (state.NeedsCompression[i])
+			{
+				std::unique_lock<std::mutex> lock(state.Mutex);
+
+				if (state.NextToClaim <= i)
+				{
+					// not taken by any worker yet
+					state.NextToClaim = i + 1;
+					lock.unlock();
+					compress(i, _entries[i].Get());
+					lock.lock();
+				}
+
+				state.Condition.wait(lock, [&state, i]() { return state.IsDone[i]; });
+
+				if (state.Failure != nullptr)
+				{
+					break;
+				}
+
+				buffer = std::move(state.Buffers[i]);
+			}
+
+			_entries[i]->SerializeLocalFileHeader(stream, buffer.Get());
+
+			// the compressed data are kept for the copies
+			if (duplicates.HasDuplicates(i) && buffer.IsValid())
+			{
+				duplicates.CompressedData[i] = buffer;
+			}
+		}
+
+		// release the buffer before letting the workers run further
+		buffer.Reset();
+
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.NextToWrite = i + 1;
+		state.Condition.notify_all();
+	}
+
+	state.Complete();
+
+	for (auto& worker : workers)
+	{
+		worker.Wait();
+	}
+
+	if (state.Failure != nullptr)
+	{
+		std::rethrow_exception(state.Failure);
+	}
+
+	this->WriteCentralDirectory(stream, startPosition);
+}
+
+void BZipArchive::WriteCentralDirectory(std::ostream& stream, std::ios::pos_type startPosition)
+{
+	auto startOfCentralDirectory = stream.tellp();
+	for (auto& entry : _entries)
+	{
+		entry->SerializeCentralDirectoryFileHeader(stream);
+	}
+
+	auto endOfCentralDirectory = stream.tellp();
+
+	const uint64 numberOfEntries = static_cast<uint64>(_entries.Num());
+	const uint64 sizeOfCentralDirectory = static_cast<uint64>(static_cast<std::streamoff>(endOfCentralDirectory - startOfCentralDirectory));
+	const uint64 offsetOfCentralDirectory = static_cast<uint64>(static_cast<std::streamoff>(startOfCentralDirectory - startPosition));
+
+	// the ZIP64 records are emitted only when a value does not fit into the classic record
+	const bool isZip64 =
+		numberOfEntries >= detail::Zip64ExtendedInformationExtraField::SaturatedValue16 ||
+		sizeOfCentralDirectory >= detail::Zip64ExtendedInformationExtraField::SaturatedValue32 ||
+		offsetOfCentralDirectory >= detail::Zip64ExtendedInformationExtraField::SaturatedValue32;
+
+	if (isZip64)
+	{
+		detail::Zip64EndOfCentralDirectoryLocator zip64Locator;
+		zip64Locator.RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord = static_cast<uint64>(static_cast<std::streamoff>(endOfCentralDirectory - startPosition));
+
+		_zip64EndOfCentralDirectoryBlock = detail::Zip64EndOfCentralDirectoryBlock();
+		_zip64EndOfCentralDirectoryBlock.VersionMadeBy = ZIP64_VERSION_NEEDED;
+		_zip64EndOfCentralDirectoryBlock.VersionNeededToExtract = ZIP64_VERSION_NEEDED;
+		_zip64EndOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectoryOnThisDisk = numberOfEntries;
+		_zip64EndOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory = numberOfEntries;
+		_zip64EndOfCentralDirectoryBlock.SizeOfCentralDirectory = sizeOfCentralDirectory;
+		_zip64EndOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber = offsetOfCentralDirectory;
+		_zip64EndOfCentralDirectoryBlock.Serialize(stream);
+
+		zip64Locator.Serialize(stream);
+	}
+
+	_hasZip64EndOfCentralDirectory = isZip64;
+
+	_endOfCentralDirectoryBlock.NumberOfThisDisk = 0;
+	_endOfCentralDirectoryBlock.NumberOfTheDiskWithTheStartOfTheCentralDirectory = 0;
+
+	const uint16 numberOfEntries16 = numberOfEntries < detail::Zip64ExtendedInformationExtraField::SaturatedValue16
+		? static_cast<uint16>(numberOfEntries)
+		: detail::Zip64ExtendedInformationExtraField::SaturatedValue16;
+
+	_endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectory = numberOfEntries16;
+	_endOfCentralDirectoryBlock.NumberOfEntriesInTheCentralDirectoryOnThisDisk = numberOfEntries16;
+
+	_endOfCentralDirectoryBlock.SizeOfCentralDirectory = detail::Zip64ExtendedInformationExtraField::Saturate32(sizeOfCentralDirectory);
+	_endOfCentralDirectoryBlock.OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber = detail::Zip64ExtendedInformationExtraField::Saturate32(offsetOfCentralDirectory);
+	_endOfCentralDirectoryBlock.Serialize(stream);
+}
+
+void BZipArchive::Swap(TSharedPtr<BZipArchive> other)
+{
+	//if (this == other) return;
+	if (other == nullptr) return;
+
+	std::swap(_endOfCentralDirectoryBlock, other->_endOfCentralDirectoryBlock);
+	std::swap(_zip64EndOfCentralDirectoryBlock, other->_zip64EndOfCentralDirectoryBlock);
+	std::swap(_hasZip64EndOfCentralDirectory, other->_hasZip64EndOfCentralDirectory);
+	std::swap(_entries, other->_entries);
+	std::swap(_entryNameIndex, other->_entryNameIndex);
+	std::swap(_hasDuplicateEntryNames, other->_hasDuplicateEntryNames);
+	std::swap(_deduplicateEntries, other->_deduplicateEntries);
+	std::swap(_entryLoadingMode, other->_entryLoadingMode);
+	std::swap(_centralDirectory, other->_centralDirectory);
+	std::swap(_centralDirectoryView, other->_centralDirectoryView);
+	std::swap(_centralDirectoryRecordOffsets, other->_centralDirectoryRecordOffsets);
+	std::swap(_lazyNameTable, other->_lazyNameTable);
+	std::swap(_lazyEntriesCount, other->_lazyEntriesCount);
+	std::swap(_zipStream, other->_zipStream);
+	std::swap(_owningStream, other->_owningStream);
+	std::swap(_mappedFile, other->_mappedFile);
+	std::swap(_mappedRegion, other->_mappedRegion);
+	std::swap(_memoryData, other->_memoryData);
+	std::swap(_memorySize, other->_memorySize);
+	std::swap(_filePath, other->_filePath);
+	std::swap(_readHandles, other->_readHandles);
+
+	this->AdoptEntries();
+	other->AdoptEntries();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// entry name index
+
+BZipArchiveEntry* BZipArchive::FindIndexedEntry(const std::string& normalizedName) const
+{
+	auto it = _entryNameIndex.find(normalizedName);
+	return it != _entryNameIndex.end() ? it->second : nullptr;
+}
+
+void BZipArchive::IndexEntry(BZipArchiveEntry* entry)
+{
+	// the first entry with the given name wins, the same way as the linear lookup did
+	if (!_entryNameIndex.emplace(entry->_centralDirectoryFileHeader.Filename, entry).second)
+	{
+		_hasDuplicateEntryNames = true;
+	}
+}
+
+void BZipArchive::UnindexEntry(BZipArchiveEntry* entry, const std::string& name)
+{
+	auto it = _entryNameIndex.find(name);
+
+	if (it == _entryNameIndex.end() || it->second != entry)
+	{
+		return;
+	}
+
+	_entryNameIndex.erase(it);
+
+	// promote the next entry of the same name, if there is any
+	if (_hasDuplicateEntryNames)
+	{
+		utils::entry_name_equal equals = _entryNameIndex.key_eq();
+
+		for (auto& other : _entries)
+		{
+			if (other.IsValid() && other.Get() != entry && equals(other->_centralDirectoryFileHeader.Filename, name))
+			{
+				_entryNameIndex.emplace(other->_centralDirectoryFileHeader.Filename, other.Get());
+				break;
+			}
+		}
+	}
+}
+
+void BZipArchive::ReindexEntry(BZipArchiveEntry* entry, const std::string& oldName)
+{
+	auto it = _entryNameIndex.find(oldName);
+
+	if (it != _entryNameIndex.end() && it->second == entry)
+	{
+		this->UnindexEntry(entry, oldName);
+		this->IndexEntry(entry);
+		return;
+	}
+
+	// entries which are not part of this archive (yet) are not indexed,
+	// except of the shadowed duplicates, which may become visible now
+	if (_hasDuplicateEntryNames)
+	{
+		for (auto& other : _entries)
+		{
+			if (other.Get() == entry)
+			{
+				this->IndexEntry(entry);
+				break;
+			}
+		}
+	}
+}
+
+void BZipArchive::RebuildEntryNameIndex()
+{
+	_entryNameIndex.clear();
+	_entryNameIndex.reserve(_entries.Num());
+	_hasDuplicateEntryNames = false;
+
+	for (auto& entry : _entries)
+	{
+		if (entry.IsValid())
+		{
+			this->IndexEntry(entry.Get());
+		}
+	}
+
+	// the lazy name table is hashed with the old case mode
+	_lazyNameTable.Empty();
+}
+
+void BZipArchive::AdoptEntries()
+{
+	// entries notify their owning archive about renames
+	for (auto& entry : _entries)
+	{
+		if (entry.IsValid())
+		{
+			entry->_archive = this;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// lazy loading of the entries
+
+void BZipArchive::AddLazyEntries()
+{
+	// walk the records only to find their offsets,
+	// the headers are parsed when the entry is materialized
+	const uint8* begin = _centralDirectoryView.GetData();
+	const uint8* end = begin + _centralDirectoryView.Num();
+	const uint8* cursor = begin;
+
+	while (static_cast<size_t>(end - cursor) >= CDFH_SIZE)
+	{
+		uint32 signature;
+		uint16 filenameLength, extraFieldLength, fileCommentLength;
+
+		memcpy(&signature, cursor, sizeof(signature));
+		memcpy(&filenameLength, cursor + CDFH_FILENAME_LENGTH_OFFSET, sizeof(filenameLength));
+		memcpy(&extraFieldLength, cursor + CDFH_EXTRA_FIELD_LENGTH_OFFSET, sizeof(extraFieldLength));
+		memcpy(&fileCommentLength, cursor + CDFH_FILE_COMMENT_LENGTH_OFFSET, sizeof(fileCommentLength));
+
+		size_t recordSize = CDFH_SIZE + filenameLength + extraFieldLength + fileCommentLength;
+
+		if (signature != detail::ZipCentralDirectoryFileHeader::SignatureConstant || static_cast<size_t>(end - cursor) < recordSize)
+		{
+			break;
+		}
+
+		// the same filter as BZipArchiveEntry::CreateExisting applies
+		if (IsValidRawFilename(cursor + CDFH_SIZE, filenameLength))
+		{
+			// keep the arrays parallel, the new entries have no record
+			if (_centralDirectoryRecordOffsets.Num() == 0)
+			{
+				_centralDirectoryRecordOffsets.Init(MAX_uint32, _entries.Num());
+			}
+
+			_entries.Add(nullptr);
+			_centralDirectoryRecordOffsets.Add(static_cast<uint32>(cursor - begin));
+			++_lazyEntriesCount;
+		}
+
+		cursor += recordSize;
+	}
+
+	if (_lazyEntriesCount == 0)
+	{
+		this->ReleaseCentralDirectory();
+	}
+}
+
+TSharedPtr<BZipArchiveEntry> BZipArchive::MaterializeEntry(int32 index)
+{
+	TSharedPtr<BZipArchiveEntry>& entry = _entries[index];
+
+	if (entry.IsValid() || _lazyEntriesCount == 0)
+	{
+		return entry;
+	}
+
+	uint32 recordOffset = _centralDirectoryRecordOffsets[index];
+
+	detail::ZipCentralDirectoryFileHeader zipCentralDirectoryFileHeader;
+	const uint8* cursor = _centralDirectoryView.GetData() + recordOffset;
+
+	if (zipCentralDirectoryFileHeader.Deserialize(cursor, _centralDirectoryView.GetData() + _centralDirectoryView.Num()))
+	{
+		entry = BZipArchiveEntry::CreateExisting(this, zipCentralDirectoryFileHeader);
+	}
+
+	TSharedPtr<BZipArchiveEntry> result = entry;
+
+	if (result.IsValid())
+	{
+		this->RemoveFromLazyNameTable(recordOffset);
+
+		// a record of the same name before this one keeps the name, even if it is materialized later
+		const int32 firstIndex = _lazyEntriesCount > 1 ? this->FindLazyEntry(result->_centralDirectoryFileHeader.Filename) : INDEX_NONE;
+
+		if (firstIndex != INDEX_NONE && firstIndex < index)
+		{
+			_hasDuplicateEntryNames = true;
+		}
+		else
+		{
+			this->IndexEntry(result.Get());
+		}
+
+		if (--_lazyEntriesCount == 0)
+		{
+			this->ReleaseCentralDirectory();
+		}
+	}
+
+	return result;
+}
+
+void BZipArchive::MaterializeAllEntries()
+{
+	for (int32 i = 0; i < _entries.Num() && _lazyEntriesCount > 0; i++)
+	{
+		if (!this->MaterializeEntry(i).IsValid())
+		{
+			// a malformed record, the eager loading would not have read it either
+			this->RemoveLazyEntry(i);
+			i--;
+		}
+	}
+}
+
+void BZipArchive::RemoveLazyEntry(int32 index)
+{
+	this->RemoveFromLazyNameTable(_centralDirectoryRecordOffsets[index]);
+
+	_entries.RemoveAt(index);
+	_centralDirectoryRecordOffsets.RemoveAt(index);
+
+	if (--_lazyEntriesCount == 0)
+	{
+		this->ReleaseCentralDirectory();
+	}
+}
+
+int32 BZipArchive::FindLazyEntry(const std::string& normalizedName)
+{
+	if (_lazyNameTable.Num() == 0)
+	{
+		this->BuildLazyNameTable();
+	}
+
+	const bool ignoreCase = this->IsIgnoringCaseInEntryNames();
+	const uint32 hash = static_cast<uint32>(utils::string::hash_entry_name(normalizedName, ignoreCase));
+	const uint32 mask = static_cast<uint32>(_lazyNameTable.Num() - 1);
+
+	for (uint32 i = hash & mask; _lazyNameTable[i].RecordOffset != LAZY_SLOT_EMPTY; i = (i + 1) & mask)
+	{
+		const LazyNameSlot& slot = _lazyNameTable[i];
+
+		if (slot.RecordOffset == LAZY_SLOT_REMOVED || slot.Hash != hash)
+		{
+			continue;
+		}
+
+		const uint8* record = _centralDirectoryView.GetData() + slot.RecordOffset;
+		uint16 filenameLength;
+		memcpy(&filenameLength, record + CDFH_FILENAME_LENGTH_OFFSET, sizeof(filenameLength));
+
+		std::string filename(reinterpret_cast<const char*>(record + CDFH_SIZE), filenameLength);
+
+		if (utils::string::equals_entry_name(utils::string::normalize_entry_name(filename.c_str()), normalizedName, ignoreCase))
+		{
+			// records are stored in the order of the entries, the new entries are at the end
+			return static_cast<int32>(std::lower_bound(
+				_centralDirectoryRecordOffsets.GetData(),
+				_centralDirectoryRecordOffsets.GetData() + _centralDirectoryRecordOffsets.Num(),
+				slot.RecordOffset) - _centralDirectoryRecordOffsets.GetData());
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void BZipArchive::BuildLazyNameTable()
+{
+	// keep the load factor at most 1/2
+	int32 capacity = 16;
+	while (capacity < 2 * _lazyEntriesCount)
+	{
+		capacity <<= 1;
+	}
+
+	_lazyNameTable.Init(LazyNameSlot{ 0, LAZY_SLOT_EMPTY }, capacity);
+
+	const bool ignoreCase = this->IsIgnoringCaseInEntryNames();
+
+	// inserted in the order of the entries, so the first of the duplicates is found first
+	for (int32 i = 0; i < _entries.Num(); i++)
+	{
+		if (!_entries[i].IsValid())
+		{
+			const uint8* record = _centralDirectoryView.GetData() + _centralDirectoryRecordOffsets[i];
+			uint16 filenameLength;
+			memcpy(&filenameLength, record + CDFH_FILENAME_LENGTH_OFFSET, sizeof(filenameLength));
+
+			uint32 hash = static_cast<uint32>(utils::string::hash_entry_name(reinterpret_cast<const char*>(record + CDFH_SIZE), filenameLength, ignoreCase));
+			this->InsertIntoLazyNameTable(hash, _centralDirectoryRecordOffsets[i]);
+		}
+	}
+}
+
+void BZipArchive::InsertIntoLazyNameTable(uint32 hash, uint32 recordOffset)
+{
+	const uint32 mask = static_cast<uint32>(_lazyNameTable.Num() - 1);
+	uint32 i = hash & mask;
+
+	while (_lazyNameTable[i].RecordOffset != LAZY_SLOT_EMPTY)
+	{
+		i = (i + 1) & mask;
+	}
+
+	_lazyNameTable[i] = LazyNameSlot{ hash, recordOffset };
+}
+
+void BZipArchive::RemoveFromLazyNameTable(uint32 recordOffset)
+{
+	if (_lazyNameTable.Num() == 0)
+	{
+		return;
+	}
+
+	const uint8* record = _centralDirectoryView.GetData() + recordOffset;
+	uint16 filenameLength;
+	memcpy(&filenameLength, record + CDFH_FILENAME_LENGTH_OFFSET, sizeof(filenameLength));
+
+	const uint32 hash = static_cast<uint32>(utils::string::hash_entry_name(reinterpret_cast<const char*>(record + CDFH_SIZE), filenameLength, this->IsIgnoringCaseInEntryNames()));
+	const uint32 mask = static_cast<uint32>(_lazyNameTable.Num() - 1);
+
+	for (uint32 i = hash & mask; _lazyNameTable[i].RecordOffset != LAZY_SLOT_EMPTY; i = (i + 1) & mask)
+	{
+		if (_lazyNameTable[i].RecordOffset == recordOffset)
+		{
+			// leave a tombstone, so the probing of the other names is not broken
+			_lazyNameTable[i].RecordOffset = LAZY_SLOT_REMOVED;
+			return;
+		}
+	}
+}
+
+void BZipArchive::ReleaseCentralDirectory()
+{
+	_centralDirectory.Empty();
+	_centralDirectoryView = TArrayView<const uint8>();
+	_centralDirectoryRecordOffsets.Empty();
+	_lazyNameTable.Empty();
+	_lazyEntriesCount = 0;
+}
+
+void BZipArchive::InternalDestroy()
+{
+	if (_owningStream && _zipStream != nullptr)
+	{
+		delete _zipStream;
+		_zipStream = nullptr;
+	}
+
+	for (std::istream* handle : _readHandles)
+	{
+		delete handle;
 	}
+	_readHandles.Empty();
 }
\ No newline at end of file
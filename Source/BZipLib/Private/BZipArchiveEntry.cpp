@@ -6,20 +6,36 @@
 #include "BZipFile.h"
 
 #include "detail/ZipLocalFileHeader.h"
+#include "detail/Zip64ExtendedInformationExtraField.h"
+#include "detail/WinZipAesExtraField.h"
 
 #include "methods/ZipMethodResolver.h"
+#include "methods/ZipMethodPool.h"
 
 #include "streams/zip_cryptostream.h"
+#include "streams/zip_aesstream.h"
 #include "streams/compression_encoder_stream.h"
 #include "streams/compression_decoder_stream.h"
-#include "streams/nullstream.h"
+#include "streams/spillstream.h"
+#include "streams/memstream.h"
+#include "streams/positionalstream.h"
 
+#include "utils/crc32_utils.h"
+#include "utils/sha1_utils.h"
 #include "utils/stream_utils.h"
+#include "utils/string_utils.h"
 #include "utils/time_utils.h"
 
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 #include <sstream>
+#include <cstring>
+#include <limits>
 
 namespace
 {
@@ -48,6 +64,32 @@ namespace
 	{
 		return (fullPath.Len() > 0 && fullPath[fullPath.Len() - 1] == '/');
 	}
+
+	// fixed part of the local file header, see ZipLocalFileHeaderBase
+	const size_t LFH_SIZE = detail::ZipLocalFileHeaderBase::SIZE_IN_BYTES;
+	const size_t LFH_FILENAME_LENGTH_OFFSET = 26;
+	const size_t LFH_EXTRA_FIELD_LENGTH_OFFSET = 28;
+
+	/**
+	 * \brief Input stream which keeps alive the whole chain of streams it reads from.
+	 */
+	class chained_istream : public std::istream
+	{
+	public:
+		chained_istream(const TSharedPtr<std::istream>& archiveStream, const TSharedPtr<std::istream>& encryptionStream, const TSharedPtr<std::istream>& outerStream)
+			: std::istream(outerStream->rdbuf())
+			, _archiveStream(archiveStream)
+			, _encryptionStream(encryptionStream)
+			, _outerStream(outerStream)
+		{
+
+		}
+
+	private:
+		TSharedPtr<std::istream> _archiveStream;
+		TSharedPtr<std::istream> _encryptionStream;
+		TSharedPtr<std::istream> _outerStream;
+	};
 }
 
 BZipArchiveEntry::BZipArchiveEntry()
@@ -62,10 +104,13 @@ BZipArchiveEntry::BZipArchiveEntry()
 	, _originallyInArchive(false)
 	, _isNewOrChanged(false)
 	, _hasLocalFileHeader(false)
+	, _hasInputFileFailed(false)
+	, _isMethodSelected(false)
 
 	, _offsetOfCompressedData(-1)
 	, _offsetOfSerializedLocalFileHeader(-1)
 
+	, _encryptionMethod(EncryptionMethod::ZipCrypto)
 {
 
 }
@@ -138,30 +183,15 @@ FString BZipArchiveEntry::GetFullName()
 
 void BZipArchiveEntry::SetFullName(const FString& fullName)
 {
-	FString filename = fullName.Replace(TEXT("\\"), TEXT("/"));
-	FString correctFilename;
-
-	bool isDirectory = IsDirectoryPath(filename);
-
-	// if slash is first char, remove it
-	while (filename.Len() > 0 && filename[0] == '/')
-	{
-		filename.RemoveAt(0);
-	}
-
-	// find multiply slashes
-	bool prevWasSlash = false;
-	for (std::string::size_type i = 0; i < filename.Len(); ++i)
-	{
-		if (filename[i] == '/' && prevWasSlash) continue;
-		prevWasSlash = (filename[i] == '/');
+	std::string oldFilename = _centralDirectoryFileHeader.Filename;
 
-		correctFilename += filename[i];
-	}
+	// replace backslashes, remove leading slashes and collapse the multiple ones
+	_centralDirectoryFileHeader.Filename = utils::string::normalize_entry_name(TCHAR_TO_UTF8(*fullName));
+	_name = BZipFile::GetFilenameFromPath(FString(UTF8_TO_TCHAR(_centralDirectoryFileHeader.Filename.c_str())));
 
-	_centralDirectoryFileHeader.Filename = std::string(TCHAR_TO_UTF8(*correctFilename));
-	_name = BZipFile::GetFilenameFromPath(correctFilename);
+	bool isDirectory = !_centralDirectoryFileHeader.Filename.empty() && _centralDirectoryFileHeader.Filename.back() == '/';
 
+	this->OnFullNameChanged(oldFilename);
 	this->SetAttributes(isDirectory ? Attributes::Directory : Attributes::Archive);
 }
 
@@ -227,11 +257,19 @@ BZipArchiveEntry::Attributes BZipArchiveEntry::GetAttributes() const
 
 uint16 BZipArchiveEntry::GetCompressionMethod() const
 {
+	detail::WinZipAesExtraField aesExtraField;
+
+	if (this->IsAesEncrypted() && aesExtraField.Deserialize(_centralDirectoryFileHeader.ExtraFields))
+	{
+		return aesExtraField.CompressionMethod;
+	}
+
 	return _centralDirectoryFileHeader.CompressionMethod;
 }
 
 void BZipArchiveEntry::SetAttributes(Attributes value)
 {
+	std::string oldFilename = _centralDirectoryFileHeader.Filename;
 	Attributes prevVal = this->GetAttributes();
 	Attributes newVal = prevVal | value;
 
@@ -262,11 +300,14 @@ void BZipArchiveEntry::SetAttributes(Attributes value)
 	if (!!(newVal & Attributes::Directory))
 	{
 		_centralDirectoryFileHeader.Crc32 = 0;
-		_centralDirectoryFileHeader.CompressedSize = 0;
-		_centralDirectoryFileHeader.UncompressedSize = 0;
+		_centralDirectoryFileHeader.CompressedSize64 = 0;
+		_centralDirectoryFileHeader.UncompressedSize64 = 0;
 	}
 
 	_centralDirectoryFileHeader.ExternalFileAttributes = static_cast<uint32>(newVal);
+
+	// the trailing slash might have been added or removed
+	this->OnFullNameChanged(oldFilename);
 }
 
 bool BZipArchiveEntry::IsPasswordProtected() const
@@ -279,9 +320,10 @@ const FString& BZipArchiveEntry::GetPassword() const
 	return _password;
 }
 
-void BZipArchiveEntry::SetPassword(const FString& password)
+void BZipArchiveEntry::SetPassword(const FString& password, EncryptionMethod encryptionMethod /* = EncryptionMethod::ZipCrypto */)
 {
 	_password = password;
+	_encryptionMethod = encryptionMethod;
 
 	// allow unset password only for empty files
 	if (!_originallyInArchive || (_hasLocalFileHeader && this->GetSize() == 0))
@@ -290,6 +332,29 @@ void BZipArchiveEntry::SetPassword(const FString& password)
 	}
 }
 
+BZipArchiveEntry::EncryptionMethod BZipArchiveEntry::GetEncryptionMethod() const
+{
+	// the data to compress are encrypted by the method set by SetPassword
+	if (this->HasCompressionStream())
+	{
+		return _encryptionMethod;
+	}
+
+	detail::WinZipAesExtraField aesExtraField;
+
+	if (this->IsAesEncrypted() && aesExtraField.Deserialize(_centralDirectoryFileHeader.ExtraFields))
+	{
+		switch (aesExtraField.Strength)
+		{
+			case 1: return EncryptionMethod::Aes128;
+			case 2: return EncryptionMethod::Aes192;
+			default: return EncryptionMethod::Aes256;
+		}
+	}
+
+	return EncryptionMethod::ZipCrypto;
+}
+
 uint32 BZipArchiveEntry::GetCrc32() const
 {
 	return _centralDirectoryFileHeader.Crc32;
@@ -297,12 +362,12 @@ uint32 BZipArchiveEntry::GetCrc32() const
 
 uint64 BZipArchiveEntry::GetSize() const
 {
-	return static_cast<uint64>(_centralDirectoryFileHeader.UncompressedSize);
+	return _centralDirectoryFileHeader.UncompressedSize64;
 }
 
 uint64 BZipArchiveEntry::GetCompressedSize() const
 {
-	return static_cast<uint64>(_centralDirectoryFileHeader.CompressedSize);
+	return _centralDirectoryFileHeader.CompressedSize64;
 }
 
 
@@ -332,8 +397,7 @@ std::istream* BZipArchiveEntry::GetRawStream()
 	{
 		if (_originallyInArchive)
 		{
-			auto offsetOfCompressedData = this->SeekToCompressedData();
-			_rawStream = MakeShareable<isubstream>(new isubstream(*_archive->_zipStream, offsetOfCompressedData, this->GetCompressedSize()));
+			_rawStream = this->OpenCompressedDataStream();
 		}
 		else
 		{
@@ -345,13 +409,46 @@ std::istream* BZipArchiveEntry::GetRawStream()
 }
 
 std::istream* BZipArchiveEntry::GetDecompressionStream()
+{
+	// there shouldn't be opened another stream
+	if (_archiveStream != nullptr || _encryptionStream != nullptr)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<std::istream> result = this->CreateDecompressionStream(_archiveStream, _encryptionStream, _compressionStream);
+
+	if (result == nullptr && _archiveStream != nullptr)
+	{
+		// properly delete the partially created streams
+		this->CloseDecompressionStream();
+	}
+
+	return result.Get();
+}
+
+TSharedPtr<std::istream> BZipArchiveEntry::OpenDecompressionStream()
+{
+	TSharedPtr<std::istream> archiveStream;
+	TSharedPtr<std::istream> encryptionStream;
+	TSharedPtr<std::istream> compressionStream;
+
+	TSharedPtr<std::istream> result = this->CreateDecompressionStream(archiveStream, encryptionStream, compressionStream);
+
+	if (result == nullptr)
+	{
+		return nullptr;
+	}
+
+	return MakeShareable<std::istream>(new chained_istream(archiveStream, encryptionStream, result));
+}
+
+TSharedPtr<std::istream> BZipArchiveEntry::CreateDecompressionStream(TSharedPtr<std::istream>& archiveStream, TSharedPtr<std::istream>& encryptionStream, TSharedPtr<std::istream>& compressionStream)
 {
 	TSharedPtr<std::istream> intermediateStream;
 
-	// there shouldn't be opened another stream
-	if (this->CanExtract() && _archiveStream == nullptr && _encryptionStream == nullptr)
+	if (this->CanExtract())
 	{
-		auto offsetOfCompressedData = this->SeekToCompressedData();
 		bool needsPassword = !!(this->GetGeneralPurposeBitFlag() & BitFlag::Encrypted);
 		bool needsDecompress = this->GetCompressionMethod() != StoreMethod::CompressionMethod;
 
@@ -361,38 +458,93 @@ std::istream* BZipArchiveEntry::GetDecompressionStream()
 			return nullptr;
 		}
 
-		// make correctly-ended sub stream of the input stream
-		intermediateStream = _archiveStream = MakeShareable<isubstream>(new isubstream(*_archive->_zipStream, offsetOfCompressedData, this->GetCompressedSize()));
+		// make correctly-ended sub stream of the input stream, the decoder reads it in place if it is in the memory
+		mem_streambuf<char, std::char_traits<char>>* memoryStreambuf = nullptr;
+		intermediateStream = archiveStream = this->OpenCompressedDataStream(&memoryStreambuf);
 
-		if (needsPassword)
+		if (needsPassword && this->IsAesEncrypted())
+		{
+			detail::WinZipAesExtraField aesExtraField;
+
+			if (!aesExtraField.Deserialize(_centralDirectoryFileHeader.ExtraFields))
+			{
+				return nullptr;
+			}
+
+			TSharedPtr<zip_aesstream> aesStream = MakeShareable<zip_aesstream>(new zip_aesstream(*intermediateStream, TCHAR_TO_UTF8(*_password), aesExtraField.GetKeyLength(), this->GetCompressedSize()));
+			bool hasCorrectPassword = aesStream->prepare_for_decryption();
+
+			// the caller deletes the stream, if the password is wrong
+			intermediateStream = encryptionStream = aesStream;
+
+			if (!hasCorrectPassword)
+			{
+				return nullptr;
+			}
+		}
+		else if (needsPassword)
 		{
 			TSharedPtr<zip_cryptostream> cryptoStream = MakeShareable<zip_cryptostream>(new zip_cryptostream(*intermediateStream, TCHAR_TO_UTF8(*_password)));
 			cryptoStream->set_final_byte(this->GetLastByteOfEncryptionHeader());
 			bool hasCorrectPassword = cryptoStream->prepare_for_decryption();
 
 			// set it here, because in case the hasCorrectPassword is false
-			// the method CloseDecompressionStream() will properly delete the stream
-			intermediateStream = _encryptionStream = cryptoStream;
+			// the caller will properly delete the stream
+			intermediateStream = encryptionStream = cryptoStream;
 
 			if (!hasCorrectPassword)
 			{
-				this->CloseDecompressionStream();
 				return nullptr;
 			}
 		}
 
 		if (needsDecompress)
 		{
-			TSharedPtr<ICompressionMethod> zipMethod = ZipMethodResolver::GetZipMethodInstance(this->GetCompressionMethod());
+			TSharedPtr<ICompressionMethod> zipMethod = ZipMethodPool::GetZipMethodInstance(this->GetCompressionMethod());
 
-			if (zipMethod != nullptr)
+			if (zipMethod != nullptr && memoryStreambuf != nullptr && encryptionStream == nullptr)
+			{
+				intermediateStream = compressionStream = MakeShareable<compression_decoder_stream>(new compression_decoder_stream(zipMethod->GetDecoder(), zipMethod->GetDecoderProperties(), *intermediateStream, *memoryStreambuf));
+			}
+			else if (zipMethod != nullptr)
 			{
-				intermediateStream = _compressionStream = MakeShareable<compression_decoder_stream>(new compression_decoder_stream(zipMethod->GetDecoder(), zipMethod->GetDecoderProperties(), *intermediateStream));
+				intermediateStream = compressionStream = MakeShareable<compression_decoder_stream>(new compression_decoder_stream(zipMethod->GetDecoder(), zipMethod->GetDecoderProperties(), *intermediateStream));
 			}
 		}
 	}
 
-	return intermediateStream.Get();
+	return intermediateStream;
+}
+
+TArrayView<const uint8> BZipArchiveEntry::GetRawDataView()
+{
+	if (!_originallyInArchive || _isNewOrChanged)
+	{
+		return TArrayView<const uint8>();
+	}
+
+	uint64 length;
+	const uint8* data = this->GetCompressedDataInMemory(length);
+
+	if (data == nullptr || length != this->GetCompressedSize() || length > static_cast<uint64>(MAX_int32))
+	{
+		return TArrayView<const uint8>();
+	}
+
+	return TArrayView<const uint8>(data, static_cast<int32>(length));
+}
+
+bool BZipArchiveEntry::TryGetStoredDataView(TArrayView<const uint8>& view)
+{
+	view = TArrayView<const uint8>();
+
+	if (this->GetCompressionMethod() != StoreMethod::CompressionMethod || this->IsPasswordProtected() || this->GetCompressedSize() != this->GetSize())
+	{
+		return false;
+	}
+
+	view = this->GetRawDataView();
+	return view.Num() == static_cast<int64>(this->GetSize());
 }
 
 bool BZipArchiveEntry::IsRawStreamOpened() const
@@ -405,6 +557,22 @@ bool BZipArchiveEntry::IsDecompressionStreamOpened() const
 	return _compressionStream != nullptr;
 }
 
+bool BZipArchiveEntry::AuthenticateDecompressionStream()
+{
+	if (_archiveStream == nullptr)
+	{
+		return false;
+	}
+
+	if (_encryptionStream == nullptr || !this->IsAesEncrypted())
+	{
+		return true;
+	}
+
+	// the encryption stream of an AES entry is always created by CreateDecompressionStream as zip_aesstream
+	return static_cast<zip_aesstream*>(_encryptionStream.Get())->authenticate();
+}
+
 void BZipArchiveEntry::CloseRawStream()
 {
 	_rawStream.Reset();
@@ -422,7 +590,7 @@ bool BZipArchiveEntry::SetCompressionStream(std::istream& stream, TSharedPtr<ICo
 {
 	// if _inputStream is set, we already have some stream to compress
 	// so we discard it
-	if (_inputStream != nullptr)
+	if (this->HasCompressionStream())
 	{
 		this->UnloadCompressionData();
 	}
@@ -430,15 +598,24 @@ bool BZipArchiveEntry::SetCompressionStream(std::istream& stream, TSharedPtr<ICo
 	_isNewOrChanged = true;
 
 	_inputStream = &stream;
-	_compressionMethod = method;
 	_compressionMode = mode;
-	this->SetCompressionMethod(method->GetZipMethodDescriptor().GetCompressionMethod());
+	_isMethodSelected = false;
+	this->ApplyCompressionMethod(method);
 
 	if (_inputStream != nullptr && _compressionMode == CompressionMode::Immediate)
 	{
-		_immediateBuffer = MakeShareable<std::stringstream>(new std::stringstream());
+		auto position = _inputStream->tellg();
+
+		// only the budget shared by the entries limits the memory
+		_immediateBuffer = MakeShareable<spillstream>(new spillstream(std::numeric_limits<size_t>::max(), GetImmediateModeSpillFile(), &GetImmediateModeBudget()));
 		this->InternalCompressStream(*_inputStream, *_immediateBuffer);
 
+		if (this->FallBackToStore(*_inputStream, position))
+		{
+			_immediateBuffer->truncate(0);
+			this->InternalCompressStream(*_inputStream, *_immediateBuffer);
+		}
+
 		// we have everything we need, let's act like we were loaded from archive :)
 		_isNewOrChanged = false;
 		_inputStream = nullptr;
@@ -447,6 +624,54 @@ bool BZipArchiveEntry::SetCompressionStream(std::istream& stream, TSharedPtr<ICo
 	return true;
 }
 
+bool BZipArchiveEntry::SetCompressionFile(const FString& filePath, TSharedPtr<ICompressionMethod> method /* = DeflateMethod::Create() */)
+{
+	if (this->HasCompressionStream())
+	{
+		this->UnloadCompressionData();
+	}
+
+	_isNewOrChanged = true;
+
+	// the file is opened once the data are compressed
+	_inputFilePath = filePath;
+	_hasInputFileFailed = false;
+	_compressionMode = CompressionMode::Deferred;
+	_isMethodSelected = false;
+	this->ApplyCompressionMethod(method);
+
+	return true;
+}
+
+bool BZipArchiveEntry::SetCompressionFile(const FString& filePath, TSharedPtr<const ZipMethodSelector> methodSelector)
+{
+	// until the file is opened, the method is the one of its name
+	this->SetCompressionFile(filePath, methodSelector->SelectMethod(filePath));
+	_isMethodSelected = true;
+
+	if (methodSelector->NeedsSample(filePath))
+	{
+		_methodSelector = methodSelector;
+	}
+
+	return true;
+}
+
+bool BZipArchiveEntry::HasInputFileFailed() const
+{
+	return _hasInputFileFailed;
+}
+
+void BZipArchiveEntry::SetImmediateModeMemoryBudget(uint64 budget)
+{
+	GetImmediateModeBudget().set_limit(budget);
+}
+
+uint64 BZipArchiveEntry::GetImmediateModeMemoryBudget()
+{
+	return GetImmediateModeBudget().get_limit();
+}
+
 void BZipArchiveEntry::UnsetCompressionStream()
 {
 	if (!this->HasCompressionStream())
@@ -503,19 +728,19 @@ void BZipArchiveEntry::SetVersionMadeBy(uint16 value)
 	_centralDirectoryFileHeader.VersionMadeBy = value;
 }
 
-int32 BZipArchiveEntry::GetOffsetOfLocalHeader() const
+uint64 BZipArchiveEntry::GetOffsetOfLocalHeader() const
 {
-	return _centralDirectoryFileHeader.RelativeOffsetOfLocalHeader;
+	return _centralDirectoryFileHeader.RelativeOffsetOfLocalHeader64;
 }
 
-void BZipArchiveEntry::SetOffsetOfLocalHeader(int32 value)
+void BZipArchiveEntry::SetOffsetOfLocalHeader(uint64 value)
 {
-	_centralDirectoryFileHeader.RelativeOffsetOfLocalHeader = static_cast<int32>(value);
+	_centralDirectoryFileHeader.RelativeOffsetOfLocalHeader64 = value;
 }
 
 bool BZipArchiveEntry::HasCompressionStream() const
 {
-	return _inputStream != nullptr;
+	return _inputStream != nullptr || !_inputFilePath.IsEmpty();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -525,10 +750,30 @@ void BZipArchiveEntry::FetchLocalFileHeader()
 {
 	if (!_hasLocalFileHeader && _originallyInArchive && _archive != nullptr)
 	{
-		_archive->_zipStream->seekg(this->GetOffsetOfLocalHeader(), std::ios::beg);
-		_localFileHeader.Deserialize(*_archive->_zipStream);
+		// positional reads leave the archive stream untouched, the fixed part
+		// of the header is read first to learn the size of the whole header
+		const uint64 offset = this->GetOffsetOfLocalHeader();
+
+		TArray<uint8> storage;
+		const uint8* header = _archive->ReadBlock(offset, LFH_SIZE, storage);
+
+		if (header != nullptr)
+		{
+			uint16 filenameLength;
+			uint16 extraFieldLength;
+			memcpy(&filenameLength, header + LFH_FILENAME_LENGTH_OFFSET, sizeof(filenameLength));
+			memcpy(&extraFieldLength, header + LFH_EXTRA_FIELD_LENGTH_OFFSET, sizeof(extraFieldLength));
 
-		_offsetOfCompressedData = _archive->_zipStream->tellg();
+			const size_t headerSize = LFH_SIZE + filenameLength + extraFieldLength;
+			header = _archive->ReadBlock(offset, headerSize, storage);
+
+			const uint8* cursor = header;
+
+			if (header != nullptr && _localFileHeader.Deserialize(cursor, header + headerSize))
+			{
+				_offsetOfCompressedData = static_cast<std::streamoff>(offset + static_cast<uint64>(cursor - header));
+			}
+		}
 	}
 
 	// sync data
@@ -536,6 +781,15 @@ void BZipArchiveEntry::FetchLocalFileHeader()
 	_hasLocalFileHeader = true;
 }
 
+void BZipArchiveEntry::OnFullNameChanged(const std::string& oldFilename)
+{
+	// keep the name index of the owning archive in sync
+	if (_archive != nullptr && oldFilename != _centralDirectoryFileHeader.Filename)
+	{
+		_archive->ReindexEntry(this, oldFilename);
+	}
+}
+
 void BZipArchiveEntry::CheckFilenameCorrection()
 {
 	// this forces recheck of the filename.
@@ -568,6 +822,9 @@ void BZipArchiveEntry::SyncCDFH_with_LFH()
 
 std::ios::pos_type BZipArchiveEntry::GetOffsetOfCompressedData()
 {
+	// concurrent streams of the same entry may ask at the same time
+	FScopeLock lock(&_localFileHeaderLock);
+
 	if (!_hasLocalFileHeader)
 	{
 		this->FetchLocalFileHeader();
@@ -576,21 +833,62 @@ std::ios::pos_type BZipArchiveEntry::GetOffsetOfCompressedData()
 	return _offsetOfCompressedData;
 }
 
-std::ios::pos_type BZipArchiveEntry::SeekToCompressedData()
+const uint8* BZipArchiveEntry::GetCompressedDataInMemory(uint64& length)
+{
+	length = 0;
+
+	if (_archive == nullptr || !_archive->IsMemoryBacked())
+	{
+		return nullptr;
+	}
+
+	// the range is clamped to the memory, as the headers might be malformed
+	const uint64 offset = std::min(static_cast<uint64>(static_cast<std::streamoff>(this->GetOffsetOfCompressedData())), _archive->_memorySize);
+	length = std::min(this->GetCompressedSize(), _archive->_memorySize - offset);
+
+	return _archive->_memoryData + offset;
+}
+
+TSharedPtr<std::istream> BZipArchiveEntry::OpenCompressedDataStream(mem_streambuf<char, std::char_traits<char>>** memoryStreambuf /* = nullptr */)
 {
-	// check for fail bit?
-	_archive->_zipStream->seekg(this->GetOffsetOfCompressedData(), std::ios::beg);
-	return this->GetOffsetOfCompressedData();
+	uint64 length;
+	const uint8* data = this->GetCompressedDataInMemory(length);
+
+	if (data != nullptr)
+	{
+		// read the memory in place, without seeking the shared stream
+		TSharedPtr<imemstream> memoryStream = MakeShareable<imemstream>(new imemstream(const_cast<char*>(reinterpret_cast<const char*>(data)), static_cast<size_t>(length)));
+
+		if (memoryStreambuf != nullptr)
+		{
+			*memoryStreambuf = &memoryStream->get_mem_streambuf();
+		}
+
+		return memoryStream;
+	}
+
+	const uint64 offsetOfCompressedData = static_cast<uint64>(static_cast<std::streamoff>(this->GetOffsetOfCompressedData()));
+	return MakeShareable<ipositionalstream>(new ipositionalstream(*_archive, offsetOfCompressedData, this->GetCompressedSize()));
 }
 
-void BZipArchiveEntry::SerializeLocalFileHeader(std::ostream& stream)
+void BZipArchiveEntry::SerializeLocalFileHeader(std::ostream& stream, std::istream* precompressedData /* = nullptr */)
 {
 	// ensure opening the stream
 	std::istream* compressedDataStream = nullptr;
 
+	// the data compressed ahead by Precompress are copied as they are
+	const bool needsCompress = _isNewOrChanged && precompressedData == nullptr;
+
+	// a file is opened only while its data are compressed
+	const bool isInputFileOpened = needsCompress && this->OpenInputFile();
+
 	if (!this->IsDirectory())
 	{
-		if (_inputStream == nullptr)
+		if (precompressedData != nullptr)
+		{
+			compressedDataStream = precompressedData;
+		}
+		else if (_inputStream == nullptr)
 		{
 			if (!_isNewOrChanged)
 			{
@@ -614,13 +912,24 @@ void BZipArchiveEntry::SerializeLocalFileHeader(std::ostream& stream)
 		this->FetchLocalFileHeader();
 	}
 
+	if (needsCompress && compressedDataStream != nullptr)
+	{
+		// the method and the extra fields of the header must be final before it is written
+		this->SyncEncryptionHeaders();
+	}
+
 	// save offset of stream here
 	_offsetOfSerializedLocalFileHeader = stream.tellp();
 
+	// the header is rewritten in place once the sizes are known,
+	// so whether it carries the ZIP64 extra field must be decided now
+	_localFileHeader.UseZip64 = this->NeedsZip64LocalFileHeader(compressedDataStream, !needsCompress);
+	this->FixVersionToExtractForZip64(_localFileHeader.UseZip64);
+
 	if (this->IsUsingDataDescriptor())
 	{
-		_localFileHeader.CompressedSize = 0;
-		_localFileHeader.UncompressedSize = 0;
+		_localFileHeader.CompressedSize64 = 0;
+		_localFileHeader.UncompressedSize64 = 0;
 		_localFileHeader.Crc32 = 0;
 	}
 
@@ -636,7 +945,7 @@ void BZipArchiveEntry::SerializeLocalFileHeader(std::ostream& stream)
 
 	if (!this->IsDirectory() && compressedDataStream != nullptr)
 	{
-		if (_isNewOrChanged)
+		if (needsCompress)
 		{
 			this->InternalCompressStream(*compressedDataStream, stream);
 
@@ -650,53 +959,418 @@ void BZipArchiveEntry::SerializeLocalFileHeader(std::ostream& stream)
 				// make non-seekable version?
 				stream.seekp(_offsetOfSerializedLocalFileHeader);
 				_localFileHeader.Serialize(stream);
-				stream.seekp(this->GetCompressedSize(), std::ios::cur);
+				stream.seekp(static_cast<std::streamoff>(this->GetCompressedSize()), std::ios::cur);
 			}
 		}
 		else
 		{
 			utils::stream::copy(*compressedDataStream, stream);
+
+			if (this->IsUsingDataDescriptor())
+			{
+				// the sizes were cleared for the local file header, the descriptor carries them
+				this->SyncLFH_with_CDFH();
+				_localFileHeader.SerializeAsDataDescriptor(stream);
+			}
 		}
 	}
+
+	if (isInputFileOpened)
+	{
+		this->CloseInputFile();
+	}
 }
 
 void BZipArchiveEntry::SerializeCentralDirectoryFileHeader(std::ostream& stream)
 {
-	_centralDirectoryFileHeader.RelativeOffsetOfLocalHeader = static_cast<int32>(_offsetOfSerializedLocalFileHeader);
+	this->SetOffsetOfLocalHeader(static_cast<uint64>(static_cast<std::streamoff>(_offsetOfSerializedLocalFileHeader)));
+
+	this->FixVersionToExtractForZip64(
+		this->GetSize() >= detail::Zip64ExtendedInformationExtraField::SaturatedValue32 ||
+		this->GetCompressedSize() >= detail::Zip64ExtendedInformationExtraField::SaturatedValue32 ||
+		this->GetOffsetOfLocalHeader() >= detail::Zip64ExtendedInformationExtraField::SaturatedValue32);
+
 	_centralDirectoryFileHeader.Serialize(stream);
 }
 
+bool BZipArchiveEntry::NeedsZip64LocalFileHeader(std::istream* compressedDataStream, bool isCompressed)
+{
+	const uint64 limit = detail::Zip64ExtendedInformationExtraField::SaturatedValue32;
+
+	if (this->IsDirectory() || compressedDataStream == nullptr)
+	{
+		return false;
+	}
+
+	if (isCompressed)
+	{
+		// raw data are copied, the sizes are known
+		return this->GetSize() >= limit || this->GetCompressedSize() >= limit;
+	}
+
+	// the data are yet to be compressed, estimate the sizes from the rest of the input,
+	// leave a margin for the data which grow by the compression and by the encryption
+	auto position = compressedDataStream->tellg();
+
+	if (position == std::istream::pos_type(-1))
+	{
+		return true;
+	}
+
+	compressedDataStream->seekg(0, std::ios::end);
+	auto endPosition = compressedDataStream->tellg();
+	compressedDataStream->clear();
+	compressedDataStream->seekg(position);
+
+	if (endPosition == std::istream::pos_type(-1))
+	{
+		return true;
+	}
+
+	uint64 remaining = static_cast<uint64>(static_cast<std::streamoff>(endPosition - position));
+	return remaining + remaining / 20 + 32 >= limit;
+}
+
+void BZipArchiveEntry::FixVersionToExtractForZip64(bool isZip64)
+{
+	if (isZip64)
+	{
+		this->FixVersionToExtractAtLeast(VERSION_NEEDED_ZIP64);
+
+		if (_localFileHeader.VersionNeededToExtract < VERSION_NEEDED_ZIP64)
+		{
+			_localFileHeader.VersionNeededToExtract = VERSION_NEEDED_ZIP64;
+		}
+	}
+}
+
 void BZipArchiveEntry::UnloadCompressionData()
 {
 	// unload stream
-	_immediateBuffer->clear();
+	if (_immediateBuffer != nullptr)
+	{
+		_immediateBuffer->clear();
+	}
 	_inputStream = nullptr;
+	_inputFilePath.Empty();
+	_inputFile.Reset();
+	_methodSelector.Reset();
 
-	_centralDirectoryFileHeader.CompressedSize = 0;
-	_centralDirectoryFileHeader.UncompressedSize = 0;
+	_centralDirectoryFileHeader.CompressedSize64 = 0;
+	_centralDirectoryFileHeader.UncompressedSize64 = 0;
 	_centralDirectoryFileHeader.Crc32 = 0;
 }
 
+bool BZipArchiveEntry::NeedsCompression() const
+{
+	return _isNewOrChanged && this->HasCompressionStream() && !this->IsDirectory();
+}
+
+bool BZipArchiveEntry::CanFallBackToStore() const
+{
+	return this->NeedsCompression() && _compressionMethod.IsValid()
+		&& _compressionMethod->GetZipMethodDescriptor().GetCompressionMethod() != StoreMethod::CompressionMethod;
+}
+
+bool BZipArchiveEntry::NeedsStoreTrial(uint64 maxInputSize)
+{
+	if (!this->CanFallBackToStore() || _isMethodSelected)
+	{
+		return false;
+	}
+
+	// the inputs of unknown size are not tried, their compressed data could fill the temporary disk
+	int64 inputSize = INDEX_NONE;
+
+	if (_inputStream != nullptr)
+	{
+		auto position = _inputStream->tellg();
+
+		if (position != std::istream::pos_type(-1) && _inputStream->seekg(0, std::ios::end))
+		{
+			inputSize = static_cast<int64>(_inputStream->tellg() - position);
+		}
+
+		_inputStream->clear();
+		if (position != std::istream::pos_type(-1))
+		{
+			_inputStream->seekg(position);
+		}
+	}
+	else if (!_inputFilePath.IsEmpty())
+	{
+		inputSize = IFileManager::Get().FileSize(*_inputFilePath);
+	}
+
+	return inputSize >= 0 && static_cast<uint64>(inputSize) <= maxInputSize;
+}
+
+void BZipArchiveEntry::ApplyCompressionMethod(TSharedPtr<ICompressionMethod> method)
+{
+	_compressionMethod = method;
+	this->SetCompressionMethod(method->GetZipMethodDescriptor().GetCompressionMethod());
+	this->SetGeneralPurposeBitFlag(BitFlag::MethodOptions, false);
+	this->SetGeneralPurposeBitFlag(static_cast<BitFlag>(method->GetGeneralPurposeBitFlag() & static_cast<uint16>(BitFlag::MethodOptions)));
+}
+
+bool BZipArchiveEntry::OpenInputFile()
+{
+	if (_inputFilePath.IsEmpty() || _inputStream != nullptr)
+	{
+		return false;
+	}
+
+	_inputFile = TUniquePtr<std::ifstream>(new std::ifstream(TCHAR_TO_UTF8(*_inputFilePath), std::ios::binary));
+
+	if (!_inputFile->is_open())
+	{
+		_inputFile.Reset();
+		_hasInputFileFailed = true;
+		return false;
+	}
+
+	_inputStream = _inputFile.Get();
+
+	// the data are sampled the first time the file is opened, before anything depends on the method
+	if (_methodSelector.IsValid())
+	{
+		this->ApplyCompressionMethod(_methodSelector->SelectMethod(_inputFilePath, *_inputFile));
+		_methodSelector.Reset();
+	}
+
+	return true;
+}
+
+void BZipArchiveEntry::CloseInputFile()
+{
+	_inputStream = nullptr;
+	_inputFile.Reset();
+}
+
+spill_budget& BZipArchiveEntry::GetImmediateModeBudget()
+{
+	static spill_budget budget(DEFAULT_IMMEDIATE_MODE_MEMORY_BUDGET);
+	return budget;
+}
+
+const std::shared_ptr<spill_file>& BZipArchiveEntry::GetImmediateModeSpillFile()
+{
+	// the buffers of the entries share it, they may outlive this one
+	static std::shared_ptr<spill_file> spillFile = CreateSpillFile();
+	return spillFile;
+}
+
+std::shared_ptr<spill_file> BZipArchiveEntry::CreateSpillFile()
+{
+	// the file is created in the temporary directory only once some data spill
+	return std::make_shared<spill_file>([]()
+	{
+		const FString path = FPaths::CreateTempFilename(FPlatformProcess::UserTempDir(), TEXT("BZipArchive"), TEXT(".tmp"));
+		return std::string(TCHAR_TO_UTF8(*path));
+	});
+}
+
+void BZipArchiveEntry::Precompress(spillstream& outputStream)
+{
+	// a file is opened only while its data are compressed, the entry stays empty if it cannot be
+	const bool isInputFileOpened = this->OpenInputFile();
+
+	if (_inputStream == nullptr)
+	{
+		return;
+	}
+
+	// entries often share one method instance, compress with an own encoder,
+	// the encoder of an entry compressed before on this thread is reused
+	TSharedPtr<ICompressionMethod> sharedMethod = _compressionMethod;
+	_compressionMethod = ZipMethodPool::Clone(*sharedMethod);
+
+	if (!_hasLocalFileHeader)
+	{
+		this->FetchLocalFileHeader();
+	}
+
+	auto position = _inputStream->tellg();
+	this->InternalCompressStream(*_inputStream, outputStream);
+
+	const bool isStored = this->FallBackToStore(*_inputStream, position);
+
+	if (isStored)
+	{
+		outputStream.truncate(0);
+		this->InternalCompressStream(*_inputStream, outputStream);
+	}
+
+	// rewind the input, so the archive can be written again
+	_inputStream->clear();
+	if (position != std::istream::pos_type(-1))
+	{
+		_inputStream->seekg(position);
+	}
+
+	// the entry keeps the store method, when the archive is written again
+	if (!isStored)
+	{
+		_compressionMethod = sharedMethod;
+	}
+
+	if (isInputFileOpened)
+	{
+		this->CloseInputFile();
+	}
+}
+
+bool BZipArchiveEntry::HashInput(uint64& size, uint32& crc32, uint8* sha1Digest)
+{
+	// the encrypted data differ even for the same input, the inputs which cannot seek are read only once,
+	// the files are opened only for the time of hashing
+	if (!this->NeedsCompression() || !_password.IsEmpty())
+	{
+		return false;
+	}
+
+	const bool isInputFileOpened = this->OpenInputFile();
+	auto position = _inputStream != nullptr ? _inputStream->tellg() : std::istream::pos_type(-1);
+
+	if (position == std::istream::pos_type(-1))
+	{
+		if (isInputFileOpened)
+		{
+			this->CloseInputFile();
+		}
+
+		return false;
+	}
+
+	utils::sha1 sha1;
+	TArray<char> buffer;
+	buffer.SetNumUninitialized(64 * 1024);
+
+	size = 0;
+	crc32 = 0;
+
+	while (_inputStream->read(buffer.GetData(), buffer.Num()), _inputStream->gcount() > 0)
+	{
+		const size_t bytesRead = static_cast<size_t>(_inputStream->gcount());
+
+		crc32 = utils::crc32::update(crc32, buffer.GetData(), bytesRead);
+		size += bytesRead;
+
+		if (sha1Digest != nullptr)
+		{
+			sha1.update(buffer.GetData(), bytesRead);
+		}
+	}
+
+	if (sha1Digest != nullptr)
+	{
+		sha1.final(sha1Digest);
+	}
+
+	_inputStream->clear();
+	const bool isRewound = !!_inputStream->seekg(position);
+
+	if (isInputFileOpened)
+	{
+		this->CloseInputFile();
+	}
+
+	return isRewound;
+}
+
+void BZipArchiveEntry::ShareCompressedData(const BZipArchiveEntry& original)
+{
+	// the copy is described by the properties the data were compressed with
+	_compressionMethod = original._compressionMethod;
+	this->SetCompressionMethod(original._centralDirectoryFileHeader.CompressionMethod);
+	this->SetGeneralPurposeBitFlag(BitFlag::MethodOptions, false);
+	this->SetGeneralPurposeBitFlag(static_cast<BitFlag>(original._centralDirectoryFileHeader.GeneralPurposeBitFlag & static_cast<uint16>(BitFlag::MethodOptions)));
+	this->FixVersionToExtractAtLeast(original._centralDirectoryFileHeader.VersionNeededToExtract);
+
+	_centralDirectoryFileHeader.Crc32 = original._centralDirectoryFileHeader.Crc32;
+	_centralDirectoryFileHeader.CompressedSize = original._centralDirectoryFileHeader.CompressedSize;
+	_centralDirectoryFileHeader.UncompressedSize = original._centralDirectoryFileHeader.UncompressedSize;
+	_centralDirectoryFileHeader.CompressedSize64 = original._centralDirectoryFileHeader.CompressedSize64;
+	_centralDirectoryFileHeader.UncompressedSize64 = original._centralDirectoryFileHeader.UncompressedSize64;
+
+	if (!_hasLocalFileHeader)
+	{
+		this->FetchLocalFileHeader();
+	}
+	else
+	{
+		this->SyncLFH_with_CDFH();
+	}
+}
+
+bool BZipArchiveEntry::FallBackToStore(std::istream& inputStream, std::istream::pos_type inputPosition)
+{
+	// stored data are never larger than the input, the compressed ones may be, if the input is compressed already
+	if (_compressionMethod->GetZipMethodDescriptor().GetCompressionMethod() == StoreMethod::CompressionMethod
+		|| _localFileHeader.CompressedSize64 <= _localFileHeader.UncompressedSize64 + this->GetEncryptionOverhead()
+		|| inputPosition == std::istream::pos_type(-1))
+	{
+		return false;
+	}
+
+	inputStream.clear();
+	if (!inputStream.seekg(inputPosition))
+	{
+		return false;
+	}
+
+	_compressionMethod = StoreMethod::Create();
+	this->SetCompressionMethod(StoreMethod::CompressionMethod);
+	this->SetGeneralPurposeBitFlag(BitFlag::MethodOptions, false);
+
+	return true;
+}
+
 void BZipArchiveEntry::InternalCompressStream(std::istream& inputStream, std::ostream& outputStream)
 {
 	std::ostream* intermediateStream = &outputStream;
 
+	this->SyncEncryptionHeaders();
+	const size_t aesKeyLength = !_password.IsEmpty() ? this->GetAesKeyLength() : 0;
+
 	TUniquePtr<zip_cryptostream> cryptoStream;
+	TUniquePtr<zip_aesstream> aesStream;
+	TUniquePtr<spillstream> unencryptedStream;
 	if (!_password.IsEmpty())
 	{
 		this->SetGeneralPurposeBitFlag(BitFlag::Encrypted);
 
-		// std::make_unique<zip_cryptostream>();
-		cryptoStream = TUniquePtr<zip_cryptostream>(new zip_cryptostream());
+		if (aesKeyLength != 0)
+		{
+			// AES does not depend on the crc32, the compressed data are encrypted
+			// and authenticated as they are produced
+			aesStream = TUniquePtr<zip_aesstream>(new zip_aesstream(outputStream, TCHAR_TO_UTF8(*_password), aesKeyLength));
+			intermediateStream = aesStream.Get();
+		}
+		else if (this->IsUsingDataDescriptor())
+		{
+			// std::make_unique<zip_cryptostream>();
+			cryptoStream = TUniquePtr<zip_cryptostream>(new zip_cryptostream());
 
-		cryptoStream->init(outputStream, TCHAR_TO_UTF8(*_password));
-		cryptoStream->set_final_byte(this->GetLastByteOfEncryptionHeader());
-		intermediateStream = cryptoStream.Get();
+			cryptoStream->init(outputStream, TCHAR_TO_UTF8(*_password));
+			cryptoStream->set_final_byte(this->GetLastByteOfEncryptionHeader());
+			intermediateStream = cryptoStream.Get();
+		}
+		else
+		{
+			// the encryption header carries the crc32, which is known only once the input has been read,
+			// keep the compressed data aside and encrypt them afterwards, so the input is read only once
+			unencryptedStream = TUniquePtr<spillstream>(new spillstream(static_cast<size_t>(BZipArchive::DEFAULT_SPILL_THRESHOLD), CreateSpillFile()));
+			intermediateStream = unencryptedStream.Get();
+		}
 	}
 
 	crc32stream crc32Stream;
 	crc32Stream.init(inputStream);
 
+	// a failing input which throws keeps throwing through the wrapper, the parallel writer reports it
+	crc32Stream.exceptions(inputStream.exceptions() & std::ios::badbit);
+
 	compression_encoder_stream compressionStream(
 		_compressionMethod->GetEncoder(),
 		_compressionMethod->GetEncoderProperties(),
@@ -706,36 +1380,35 @@ void BZipArchiveEntry::InternalCompressStream(std::istream& inputStream, std::os
 
 	intermediateStream->flush();
 
-	_localFileHeader.UncompressedSize = static_cast<uint32>(compressionStream.get_bytes_read());
-	_localFileHeader.CompressedSize = static_cast<uint32>(compressionStream.get_bytes_written() + (!_password.IsEmpty() ? 12 : 0));
-	_localFileHeader.Crc32 = crc32Stream.get_crc32();
-
-	this->SyncCDFH_with_LFH();
-}
+	if (cryptoStream != nullptr)
+	{
+		// the encryption stream buffers its output
+		cryptoStream->flush();
+	}
 
-void BZipArchiveEntry::FigureCrc32()
-{
-	if (this->IsDirectory() || _inputStream == nullptr || !_isNewOrChanged)
+	if (aesStream != nullptr)
 	{
-		return;
+		// writes the authentication code
+		aesStream->finish();
 	}
 
-	// stream must be seekable
-	auto position = _inputStream->tellg();
+	_localFileHeader.UncompressedSize64 = static_cast<uint64>(compressionStream.get_bytes_read());
+	_localFileHeader.CompressedSize64 = static_cast<uint64>(compressionStream.get_bytes_written()) + this->GetEncryptionOverhead();
 
-	// compute crc32
-	crc32stream crc32Stream;
-	crc32Stream.init(*_inputStream);
+	// AE-2 stores no crc32, the authentication code protects the data instead
+	_localFileHeader.Crc32 = aesStream != nullptr ? 0 : crc32Stream.get_crc32();
 
-	// just force to read all from crc32stream
-	nullstream nulldev;
-	utils::stream::copy(crc32Stream, nulldev);
+	this->SyncCDFH_with_LFH();
+	this->SyncEncryptionHeaders();
 
-	// seek back
-	_inputStream->clear();
-	_inputStream->seekg(position);
+	if (unencryptedStream != nullptr)
+	{
+		zip_cryptostream lateCryptoStream(outputStream, TCHAR_TO_UTF8(*_password));
+		lateCryptoStream.set_final_byte(this->GetLastByteOfEncryptionHeader());
 
-	_centralDirectoryFileHeader.Crc32 = crc32Stream.get_crc32();
+		utils::stream::copy(*unencryptedStream, lateCryptoStream);
+		lateCryptoStream.flush();
+	}
 }
 
 uint8 BZipArchiveEntry::GetLastByteOfEncryptionHeader()
@@ -760,10 +1433,63 @@ uint8 BZipArchiveEntry::GetLastByteOfEncryptionHeader()
 	else
 	{
 		// When bit 3 is not set, the CRC value is required before
-		// encryption of the file data begins. In this case there is no way
-		// around it: must read the stream in its entirety to compute the
-		// actual CRC before proceeding.
-		this->FigureCrc32();
+		// encryption of the file data begins. The compressed data are
+		// encrypted only after the compression has computed the CRC.
 		return uint8((this->GetCrc32() >> 24) & 0xff);
 	}
 }
+
+bool BZipArchiveEntry::IsAesEncrypted() const
+{
+	return _centralDirectoryFileHeader.CompressionMethod == detail::WinZipAesExtraField::CompressionMethodConstant;
+}
+
+size_t BZipArchiveEntry::GetAesKeyLength() const
+{
+	switch (_encryptionMethod)
+	{
+		case EncryptionMethod::Aes128: return 16;
+		case EncryptionMethod::Aes192: return 24;
+		case EncryptionMethod::Aes256: return 32;
+		default: return 0;
+	}
+}
+
+size_t BZipArchiveEntry::GetEncryptionOverhead() const
+{
+	if (_password.IsEmpty())
+	{
+		return 0;
+	}
+
+	// the salt, the password verifier and the authentication code, or the encryption header
+	const size_t aesKeyLength = this->GetAesKeyLength();
+	return aesKeyLength != 0 ? zip_aesstream::get_overhead(aesKeyLength) : 12;
+}
+
+void BZipArchiveEntry::SyncEncryptionHeaders()
+{
+	// an AES encrypted entry stores the method 99 in its headers,
+	// the real method is moved to the WinZip AES extra field
+	const size_t aesKeyLength = !_password.IsEmpty() ? this->GetAesKeyLength() : 0;
+	const uint16 compressionMethod = _compressionMethod->GetZipMethodDescriptor().GetCompressionMethod();
+
+	detail::WinZipAesExtraField aesExtraField;
+	aesExtraField.Strength = static_cast<uint8>(aesKeyLength / 8 - 1);
+	aesExtraField.CompressionMethod = compressionMethod;
+	aesExtraField.Serialize(_centralDirectoryFileHeader.ExtraFields, aesKeyLength != 0);
+	aesExtraField.Serialize(_localFileHeader.ExtraFields, aesKeyLength != 0);
+
+	_centralDirectoryFileHeader.CompressionMethod = aesKeyLength != 0 ? detail::WinZipAesExtraField::CompressionMethodConstant : compressionMethod;
+	_localFileHeader.CompressionMethod = _centralDirectoryFileHeader.CompressionMethod;
+
+	if (aesKeyLength != 0)
+	{
+		this->FixVersionToExtractAtLeast(VERSION_NEEDED_AES);
+
+		if (_localFileHeader.VersionNeededToExtract < VERSION_NEEDED_AES)
+		{
+			_localFileHeader.VersionNeededToExtract = VERSION_NEEDED_AES;
+		}
+	}
+}
@@ -6,31 +6,35 @@
 #include <fstream>
 #include <cassert>
 #include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
 
-bool BZipFile::Open(TSharedPtr<BZipArchive>& OutArchive, const FString& ZipPath, FString& ErrorMessage)
+bool BZipFile::Open(TSharedPtr<BZipArchive>& OutArchive, const FString& ZipPath, FString& ErrorMessage, BZipArchive::EntryLoadingMode LoadingMode)
 {
-	std::ifstream* zipFile = new std::ifstream();
-	zipFile->open(TCHAR_TO_UTF8(*ZipPath), std::ios::binary);
+	OutArchive = BZipArchive::CreateFromFile(ZipPath, LoadingMode);
 
-	if (!zipFile->is_open())
+	if (!OutArchive.IsValid())
 	{
 		// if file does not exist, try to create it
 		std::ofstream tmpFile;
 		tmpFile.open(TCHAR_TO_UTF8(*ZipPath), std::ios::binary);
 		tmpFile.close();
 
-		zipFile->open(TCHAR_TO_UTF8(*ZipPath), std::ios::binary);
+		OutArchive = BZipArchive::CreateFromFile(ZipPath, LoadingMode);
 
 		// if attempt to create file failed, throw an exception
-		if (!zipFile->is_open())
+		if (!OutArchive.IsValid())
 		{
 			ErrorMessage = TEXT("Unable to create/open file");
 			return false;
 		}
 	}
 
-	OutArchive = BZipArchive::Create(zipFile, true);
 	return true;
 }
 
@@ -43,7 +47,7 @@ bool BZipFile::Save(TSharedPtr<BZipArchive>& BZipArchive, const FString& ZipPath
 	return BZipFile::Open(BZipArchive, ZipPath, ErrorMessage);
 }
 
-bool BZipFile::SaveAndClose(TSharedPtr<BZipArchive>& ZArchive, const FString& ZipPath, FString& ErrorMessage)
+bool BZipFile::SaveAndClose(TSharedPtr<BZipArchive>& ZArchive, const FString& ZipPath, FString& ErrorMessage, int32 NumWorkers)
 {
 	// check if file exist
 	FString tempZipPath = MakeTempFilename(ZipPath);
@@ -56,7 +60,7 @@ bool BZipFile::SaveAndClose(TSharedPtr<BZipArchive>& ZArchive, const FString& Zi
 		return false;
 	}
 
-	ZArchive->WriteToStream(outZipFile);
+	ZArchive->WriteToStream(outZipFile, NumWorkers);
 	outZipFile.close();
 
 	ZArchive->InternalDestroy();
@@ -145,15 +149,25 @@ bool BZipFile::AddEncryptedFile(const FString& ZipPath, const FString& FileName,
 	return true;
 }
 
-bool BZipFile::CompressAll(const FString& InputFolderAbsolutePath, const FString& DestinationZipAbsolutePath, FString& ErrorMessage)
+bool BZipFile::CompressAll(const FString& InputFolderAbsolutePath, const FString& DestinationZipAbsolutePath, FString& ErrorMessage, int32 NumWorkers, const ZipMethodSelector& MethodSelector, bool bDeduplicate)
 {
+	// the folder is walked by another thread, while the files found so far are added to the archive
+	struct FEnumeratedFiles
+	{
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		TArray<FString> Pending;
+		bool bDone = false;
+		std::atomic<bool> bCancelled{ false };
+	};
+
 	class FFileRecursiveVisitor : public IPlatformFile::FDirectoryVisitor
 	{
 	public:
 		FString BaseFolderAbsolutePath;
 		FString RelativePrePath;
-		TArray<FString>& Result;
-		FFileRecursiveVisitor(const FString& InBaseFolderAbsolutePath, const FString& InRelativePrePath, TArray<FString>& InResult) : BaseFolderAbsolutePath(InBaseFolderAbsolutePath), RelativePrePath(InRelativePrePath), Result(InResult) {}
+		FEnumeratedFiles& Result;
+		FFileRecursiveVisitor(const FString& InBaseFolderAbsolutePath, const FString& InRelativePrePath, FEnumeratedFiles& InResult) : BaseFolderAbsolutePath(InBaseFolderAbsolutePath), RelativePrePath(InRelativePrePath), Result(InResult) {}
 		virtual bool Visit(const TCHAR* FilenameOrDirectory, bool bIsDirectory)
 		{
 			const FString CleanFileOrDirectoryName = FPaths::GetCleanFilename(FilenameOrDirectory);
@@ -163,22 +177,51 @@ bool BZipFile::CompressAll(const FString& InputFolderAbsolutePath, const FString
 
 			if (!bIsDirectory)
 			{
-				Result.Add(RelativePath);
+				std::lock_guard<std::mutex> Lock(Result.Mutex);
+				Result.Pending.Add(RelativePath);
+				Result.Condition.notify_one();
 			}
 			else
 			{
 				FFileRecursiveVisitor Iterator(BaseFolderAbsolutePath, Tmp + CleanFileOrDirectoryName, Result);
 				IFileManager::Get().IterateDirectory(*(BaseFolderAbsolutePath + "/" + RelativePath), Iterator);
 			}
-			return true;
+			return !Result.bCancelled;
 		}
 	};
 
-	TArray<FString> AllFiles;
-	FFileRecursiveVisitor Iterator(InputFolderAbsolutePath, "", AllFiles);
-	IFileManager::Get().IterateDirectory(*InputFolderAbsolutePath, Iterator);
+	FEnumeratedFiles Files;
+
+	TFuture<void> Enumeration = Async(EAsyncExecution::Thread, [&Files, &InputFolderAbsolutePath]()
+	{
+		FFileRecursiveVisitor Iterator(InputFolderAbsolutePath, "", Files);
+		IFileManager::Get().IterateDirectory(*InputFolderAbsolutePath, Iterator);
+
+		std::lock_guard<std::mutex> Lock(Files.Mutex);
+		Files.bDone = true;
+		Files.Condition.notify_all();
+	});
+
+	// the enumeration is stopped also when leaving early
+	ON_SCOPE_EXIT
+	{
+		Files.bCancelled = true;
+		Enumeration.Wait();
+	};
+
+	TArray<FString> FoundFiles;
 
-	if (AllFiles.Num() == 0)
+	auto WaitForFiles = [&Files, &FoundFiles]()
+	{
+		std::unique_lock<std::mutex> Lock(Files.Mutex);
+		Files.Condition.wait(Lock, [&Files]() { return Files.Pending.Num() > 0 || Files.bDone; });
+
+		FoundFiles = MoveTemp(Files.Pending);
+		return FoundFiles.Num() > 0 && !Files.bCancelled;
+	};
+
+	// the archive is created once the folder turns out not to be empty
+	if (!WaitForFiles())
 	{
 		ErrorMessage = "Given directory is empty.";
 		return false;
@@ -186,57 +229,102 @@ bool BZipFile::CompressAll(const FString& InputFolderAbsolutePath, const FString
 
 	TSharedPtr<BZipArchive> Archive;
 
-	if (!Open(Archive, DestinationZipAbsolutePath, ErrorMessage)) return false;
+	if (!Open(Archive, DestinationZipAbsolutePath, ErrorMessage))
+	{
+		return false;
+	}
 
-	bool bIterationFailed = false;
-	TArray<TSharedPtr<std::ifstream>> OpenedFileStreams;
+	Archive->SetEntryDeduplication(bDeduplicate);
+
+	const FString TempZipPath = MakeTempFilename(DestinationZipAbsolutePath);
+	std::ofstream OutZipFile;
+	OutZipFile.open(TCHAR_TO_UTF8(*TempZipPath), std::ios::binary | std::ios::trunc);
+
+	if (!OutZipFile.is_open())
+	{
+		ErrorMessage = TEXT("Cannot save zip file");
+		return false;
+	}
+
+	// the entries sample their data for the method only when they open their files
+	const TSharedPtr<const ZipMethodSelector> Selector = MakeShareable(new ZipMethodSelector(MethodSelector));
 
-	auto Method = DeflateMethod::Create();
-	Method->SetCompressionLevel(DeflateMethod::CompressionLevel::Default);
+	bool bIterationFailed = false;
+	int32 NextCheckedEntry = Archive->GetEntriesCount();
 
-	for (auto& CurrentRelativeFilePath : AllFiles)
+	// a file which could not be opened leaves its entry empty, the entries are checked once they are written
+	auto CheckOpenedFiles = [&]()
 	{
-		auto Entry = Archive->CreateEntry(CurrentRelativeFilePath);
+		for (; NextCheckedEntry < Archive->GetEntriesCount() && !bIterationFailed; NextCheckedEntry++)
+		{
+			auto Entry = Archive->GetEntry(NextCheckedEntry);
 
-		TSharedPtr<std::ifstream> ContentStream = MakeShareable(new std::ifstream());
-		ContentStream->open(TCHAR_TO_UTF8(*(InputFolderAbsolutePath + "/" + CurrentRelativeFilePath)), std::ios::binary);
+			if (Entry->HasInputFileFailed())
+			{
+				ErrorMessage = FString::Printf(TEXT("Folder iteration/open file handle has failed at file: %s"), *Entry->GetFullName());
+				bIterationFailed = true;
+				Files.bCancelled = true;
+			}
+		}
+	};
 
-		if (!ContentStream->is_open())
+	auto AddFoundFiles = [&]()
+	{
+		if (bIterationFailed || (FoundFiles.Num() == 0 && !WaitForFiles()))
 		{
-			ErrorMessage = FString::Printf(TEXT("Folder iteration/open file handle has failed at file: %s"), *CurrentRelativeFilePath);
-			bIterationFailed = true;
-			continue;
+			return false;
 		}
 
-		OpenedFileStreams.Add(ContentStream);
+		for (auto& CurrentRelativeFilePath : FoundFiles)
+		{
+			auto Entry = Archive->CreateEntry(CurrentRelativeFilePath);
 
-		if (!Entry->SetCompressionStream(*ContentStream.Get(), Method, BZipArchiveEntry::CompressionMode::Deferred))
+			// the file is opened only once its data are compressed
+			if (!Entry.IsValid() || !Entry->SetCompressionFile(InputFolderAbsolutePath + "/" + CurrentRelativeFilePath, Selector))
+			{
+				ErrorMessage = FString::Printf(TEXT("Folder iteration/set compression has failed at file: %s"), *CurrentRelativeFilePath);
+				bIterationFailed = true;
+				Files.bCancelled = true;
+				break;
+			}
+		}
+
+		FoundFiles.Empty();
+		return !bIterationFailed;
+	};
+
+	if (bDeduplicate)
+	{
+		// the copies are found among all the files, the folder is walked to the end before anything is written
+		while (AddFoundFiles())
 		{
-			ErrorMessage = FString::Printf(TEXT("Folder iteration/set compression has failed at file: %s"), *CurrentRelativeFilePath);
-			bIterationFailed = true;
-			break;
 		}
 	}
 
-	bool bSuccess = false;
-	if (!bIterationFailed)
+	// the entries are written while the folder is walked, only the central directory waits for its end
+	Archive->WriteToStreamInParallel(OutZipFile, NumWorkers, BZipArchive::DEFAULT_SPILL_THRESHOLD, [&]()
 	{
-		bSuccess = BZipFile::SaveAndClose(Archive, DestinationZipAbsolutePath, ErrorMessage);
-	}
+		CheckOpenedFiles();
+		return AddFoundFiles();
+	});
+	OutZipFile.close();
+
+	CheckOpenedFiles();
+	Archive->InternalDestroy();
 
-	for (auto& CurrentStream : OpenedFileStreams)
+	if (bIterationFailed)
 	{
-		if (CurrentStream.IsValid() && CurrentStream->is_open())
-		{
-			CurrentStream->close();
-		}
+		IFileManager::Get().Delete(*TempZipPath);
+		return false;
 	}
-	OpenedFileStreams.Empty();
 
-	return bSuccess;
+	IFileManager::Get().Delete(*DestinationZipAbsolutePath);
+	IFileManager::Get().Move(*DestinationZipAbsolutePath, *TempZipPath);
+
+	return true;
 }
 
-bool BZipFile::ExtractAll(const FString& ZipAbsolutePath, const FString& ExtractFolderAbsolutePath, FString& ErrorMessage)
+bool BZipFile::ExtractAll(const FString& ZipAbsolutePath, const FString& ExtractFolderAbsolutePath, FString& ErrorMessage, int32 NumWorkers)
 {
 	TSharedPtr<BZipArchive> zipArchive;
 	if (!BZipFile::Open(zipArchive, ZipAbsolutePath, ErrorMessage)) return false;
@@ -246,39 +334,122 @@ bool BZipFile::ExtractAll(const FString& ZipAbsolutePath, const FString& Extract
 		IFileManager::Get().MakeDirectory(*ExtractFolderAbsolutePath, true);
 	}
 
+	// entries are looked up up front, the archive itself is not synchronized
+	TArray<TSharedPtr<BZipArchiveEntry>> Entries;
+	Entries.Reserve(zipArchive->GetEntriesCount());
+
 	for (int32 i = 0; i < zipArchive->GetEntriesCount(); i++)
 	{
 		auto Entry = zipArchive->GetEntry(i);
 		if (Entry.IsValid())
 		{
+			Entries.Add(Entry);
+		}
+	}
+
+	if (NumWorkers <= 0)
+	{
+		NumWorkers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	}
+	NumWorkers = FMath::Max(1, FMath::Min(NumWorkers, Entries.Num()));
+
+	if (NumWorkers > 1)
+	{
+		// largest first, the small ones then fill the gaps left by the large ones
+		Entries.StableSort([](const TSharedPtr<BZipArchiveEntry>& A, const TSharedPtr<BZipArchiveEntry>& B)
+		{
+			return A->GetCompressedSize() > B->GetCompressedSize();
+		});
+	}
+
+	FCriticalSection Lock;
+	TSet<FString> CreatedDirectories;
+	std::atomic<int32> NextEntry(0);
+	std::atomic<bool> bFailed(false);
+
+	auto Fail = [&](const FString& Message)
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (!bFailed.exchange(true))
+		{
+			ErrorMessage = Message;
+		}
+	};
+
+	auto EnsureDirectory = [&](const FString& DirectoryPath)
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (!CreatedDirectories.Contains(DirectoryPath))
+		{
+			IFileManager::Get().MakeDirectory(*DirectoryPath, true);
+			CreatedDirectories.Add(DirectoryPath);
+		}
+	};
+
+	auto ExtractEntries = [&](int32 /*WorkerIndex*/)
+	{
+		int32 Index;
+		while (!bFailed && (Index = NextEntry++) < Entries.Num())
+		{
+			auto& Entry = Entries[Index];
+
 			FString EntryFullName = Entry->GetFullName();
 			FString EntryDestinationPath = ExtractFolderAbsolutePath + "/" + EntryFullName;
 
+			if (Entry->IsDirectory())
+			{
+				EnsureDirectory(EntryDestinationPath);
+				continue;
+			}
+
+			EnsureDirectory(FPaths::GetPath(EntryDestinationPath));
+
 			std::ofstream destFile;
 			destFile.open(TCHAR_TO_UTF8(*EntryDestinationPath), std::ios::binary | std::ios::trunc);
 
 			if (!destFile.is_open())
 			{
-				ErrorMessage = TEXT("Cannot create destination file");
-				return false;
+				Fail(TEXT("Cannot create destination file"));
+				return;
 			}
 
+			// every entry is extracted by one worker only, the stream of the entry can be checked afterwards
 			std::istream* dataStream = Entry->GetDecompressionStream();
 
 			if (dataStream == nullptr)
 			{
-				ErrorMessage = TEXT("Decompression stream is invalid.");
-				return false;
+				Fail(TEXT("Decompression stream is invalid."));
+				return;
 			}
 
 			utils::stream::copy(*dataStream, destFile);
 
+			const bool bIsAuthentic = Entry->AuthenticateDecompressionStream();
+			Entry->CloseDecompressionStream();
+
 			destFile.flush();
 			destFile.close();
+
+			// the data are known to be tampered with, they are not kept
+			if (!bIsAuthentic)
+			{
+				IFileManager::Get().Delete(*EntryDestinationPath);
+				Fail(TEXT("Authentication of the encrypted data failed."));
+				return;
+			}
 		}
+	};
+
+	if (NumWorkers == 1)
+	{
+		ExtractEntries(0);
+	}
+	else
+	{
+		ParallelFor(NumWorkers, ExtractEntries, EParallelForFlags::Unbalanced);
 	}
 
-	return true;
+	return !bFailed;
 }
 
 bool BZipFile::ExtractFile(const FString& ZipPath, const FString& FileName, FString& ErrorMessage)
@@ -333,9 +504,19 @@ bool BZipFile::ExtractEncryptedFile(const FString& ZipPath, const FString& FileN
 
 	utils::stream::copy(*dataStream, destFile);
 
+	const bool bIsAuthentic = entry->AuthenticateDecompressionStream();
+	entry->CloseDecompressionStream();
+
 	destFile.flush();
 	destFile.close();
 
+	if (!bIsAuthentic)
+	{
+		IFileManager::Get().Delete(*DestinationPath);
+		ErrorMessage = TEXT("Authentication of the encrypted data failed.");
+		return false;
+	}
+
 	return true;
 }
 
@@ -2,6 +2,9 @@
 /// Petr Benes - https://bitbucket.org/wbenny/ziplib
 
 #include "BZipLib.h"
+#include "compression/codec_allocator.h"
+
+LLM_DEFINE_TAG(BZipLib);
 
 void FBZipLibModule::StartupModule()
 {
@@ -0,0 +1,90 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveDeduplicationTest, "BZipLib.Archive.Deduplication", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveDeduplicationTest::RunTest(const FString& Parameters)
+{
+	std::string text;
+	while (text.size() < 300000)
+	{
+		text += "line " + std::to_string(text.size() % 997) + "\n";
+	}
+
+	// of the same size and crc32 prefilter bucket only by chance, differs in one byte
+	std::string changed = text;
+	changed[12345] ^= 1;
+
+	std::string random(100000, '\0');
+	uint32 x = 1;
+	for (char& c : random)
+	{
+		x = x * 1103515245 + 12345;
+		c = static_cast<char>(x >> 24);
+	}
+
+	TSharedPtr<DeflateMethod> best = DeflateMethod::Create();
+	best->SetCompressionLevel(DeflateMethod::CompressionLevel::Best);
+	TSharedPtr<DeflateMethod> fastest = DeflateMethod::Create();
+	fastest->SetCompressionLevel(DeflateMethod::CompressionLevel::Fastest);
+
+	for (int32 numWorkers : { 1, 4 })
+	{
+		for (bool deduplicate : { true, false })
+		{
+			BZipLibTest::FInputs inputs;
+			TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+			archive->SetEntryDeduplication(deduplicate);
+
+			// the setting moves with the archive
+			archive = BZipArchive::Create(MoveTemp(archive));
+			TestEqual(TEXT("Deduplication moved"), archive->IsDeduplicatingEntries(), deduplicate);
+
+			archive->CreateEntry(TEXT("text.txt"))->SetCompressionStream(inputs.Add(text), best);
+			archive->CreateEntry(TEXT("changed.txt"))->SetCompressionStream(inputs.Add(changed), fastest);
+			archive->CreateEntry(TEXT("random.bin"))->SetCompressionStream(inputs.Add(random), best);
+			archive->CreateEntry(TEXT("copy.txt"))->SetCompressionStream(inputs.Add(text), fastest);
+			archive->CreateEntry(TEXT("random copy.bin"))->SetCompressionStream(inputs.Add(random), fastest);
+
+			TSharedPtr<BZipArchiveEntry> encrypted = archive->CreateEntry(TEXT("encrypted copy.txt"));
+			encrypted->SetPassword(TEXT("password"), BZipArchiveEntry::EncryptionMethod::Aes256);
+			encrypted->SetCompressionStream(inputs.Add(text), fastest);
+
+			// the inputs are rewound, the archive written again differs only by the salt of the encrypted entry
+			const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive, numWorkers);
+			TestEqual(TEXT("Written again"), BZipLibTest::WriteArchive(archive, numWorkers).Num(), bytes.Num());
+
+			TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+			TestEqual(TEXT("Entries read back"), reopened->GetEntriesCount(), 6);
+
+			TestTrue(TEXT("Text"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("text.txt"))) == text);
+			TestTrue(TEXT("Changed"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("changed.txt"))) == changed);
+			TestTrue(TEXT("Random"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("random.bin"))) == random);
+			TestTrue(TEXT("Copy"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("copy.txt"))) == text);
+			TestTrue(TEXT("Random copy"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("random copy.bin"))) == random);
+
+			TSharedPtr<BZipArchiveEntry> reopenedEncrypted = reopened->GetEntry(TEXT("encrypted copy.txt"));
+			reopenedEncrypted->SetPassword(TEXT("password"));
+			TestTrue(TEXT("Encrypted copy"), BZipLibTest::ReadEntry(reopenedEncrypted) == text);
+
+			// the copy takes the compressed data of the first one, the fastest level would produce more
+			const uint64 textSize = reopened->GetEntry(TEXT("text.txt"))->GetCompressedSize();
+			const uint64 copySize = reopened->GetEntry(TEXT("copy.txt"))->GetCompressedSize();
+			TestEqual(TEXT("Copy compressed once"), copySize == textSize, deduplicate);
+			TestTrue(TEXT("Changed compressed apart"), reopened->GetEntry(TEXT("changed.txt"))->GetCompressedSize() != textSize);
+
+			// the stored first copy is stored for the copies too
+			TSharedPtr<BZipArchiveEntry> randomCopy = reopened->GetEntry(TEXT("random copy.bin"));
+			TestTrue(TEXT("Random copy stored"), randomCopy->GetCompressionMethod() == StoreMethod::CompressionMethod);
+			TestEqual(TEXT("Random copy size"), randomCopy->GetCompressedSize(), static_cast<uint64>(random.size()));
+		}
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,174 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+#include "BZipFile.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+#include <fstream>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	std::string MakeData(size_t size)
+	{
+		std::string data;
+		while (data.size() < size)
+		{
+			data += "line " + std::to_string(data.size() % 1013) + "\n";
+		}
+
+		data.resize(size);
+		return data;
+	}
+
+	TArray<uint8> WriteEncryptedArchive(BZipArchiveEntry::EncryptionMethod encryptionMethod, TSharedPtr<ICompressionMethod> method, const std::string& data)
+	{
+		BZipLibTest::FInputs inputs;
+		TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+		TSharedPtr<BZipArchiveEntry> entry = archive->CreateEntry(TEXT("secret.txt"));
+		entry->SetPassword(TEXT("password"), encryptionMethod);
+		entry->SetCompressionStream(inputs.Add(data), method);
+
+		archive->CreateEntry(TEXT("plain.txt"))->SetCompressionStream(inputs.Add("plain"), method);
+
+		return BZipLibTest::WriteArchive(archive);
+	}
+
+	/**
+	 * \brief Reads the encrypted entry with the given password, and the plain entry next to it.
+	 *        Returns false if no stream is opened for the encrypted entry or the plain entry differs.
+	 */
+	bool ReadEncryptedEntry(const TArray<uint8>& bytes, const FString& password, std::string& data, bool& bIsAuthentic)
+	{
+		TSharedPtr<BZipArchive> archive = BZipArchive::CreateFromMemory(bytes);
+		TSharedPtr<BZipArchiveEntry> entry = archive->GetEntry(TEXT("secret.txt"));
+
+		if (!entry.IsValid())
+		{
+			return false;
+		}
+
+		if (!password.IsEmpty())
+		{
+			entry->SetPassword(password);
+		}
+
+		std::istream* stream = entry->GetDecompressionStream();
+
+		if (stream == nullptr)
+		{
+			return false;
+		}
+
+		data.clear();
+		char buffer[4096];
+		while (stream->read(buffer, sizeof(buffer)), stream->gcount() > 0)
+		{
+			data.append(buffer, static_cast<size_t>(stream->gcount()));
+		}
+
+		bIsAuthentic = entry->AuthenticateDecompressionStream();
+		entry->CloseDecompressionStream();
+
+		return BZipLibTest::ReadEntry(archive->GetEntry(TEXT("plain.txt"))) == "plain";
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveEncryptionRoundTripTest, "BZipLib.Archive.Encryption.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveEncryptionRoundTripTest::RunTest(const FString& Parameters)
+{
+	typedef BZipArchiveEntry::EncryptionMethod EncryptionMethod;
+
+	for (EncryptionMethod encryptionMethod : { EncryptionMethod::ZipCrypto, EncryptionMethod::Aes128, EncryptionMethod::Aes192, EncryptionMethod::Aes256 })
+	{
+		for (TSharedPtr<ICompressionMethod> method : { StaticCastSharedPtr<ICompressionMethod>(StoreMethod::Create()), StaticCastSharedPtr<ICompressionMethod>(DeflateMethod::Create()) })
+		{
+			// empty, and larger than the buffers of the streams
+			for (size_t size : { size_t(0), size_t(200000) })
+			{
+				const std::string data = MakeData(size);
+				const TArray<uint8> bytes = WriteEncryptedArchive(encryptionMethod, method, data);
+
+				std::string read;
+				bool bIsAuthentic = false;
+
+				TestFalse(TEXT("Not read without the password"), ReadEncryptedEntry(bytes, FString(), read, bIsAuthentic));
+				TestTrue(TEXT("Read with the password"), ReadEncryptedEntry(bytes, TEXT("password"), read, bIsAuthentic));
+				TestTrue(TEXT("Authentic"), bIsAuthentic);
+				TestTrue(TEXT("Data read back"), read == data);
+
+				// the one byte check of ZipCrypto passes for 1 in 256 wrong passwords
+				if (encryptionMethod != EncryptionMethod::ZipCrypto)
+				{
+					TestFalse(TEXT("Not read with a wrong password"), ReadEncryptedEntry(bytes, TEXT("wrong"), read, bIsAuthentic));
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveEncryptionTamperTest, "BZipLib.Archive.Encryption.Tamper", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveEncryptionTamperTest::RunTest(const FString& Parameters)
+{
+	typedef BZipArchiveEntry::EncryptionMethod EncryptionMethod;
+
+	const std::string data = MakeData(200000);
+
+	for (TSharedPtr<ICompressionMethod> method : { StaticCastSharedPtr<ICompressionMethod>(StoreMethod::Create()), StaticCastSharedPtr<ICompressionMethod>(DeflateMethod::Create()) })
+	{
+		const TArray<uint8> bytes = WriteEncryptedArchive(EncryptionMethod::Aes256, method, data);
+		const int32 dataOffset = BZipLibTest::GetOffsetOfFirstEntryData(bytes);
+
+		// a byte of the encrypted data, and the last byte of the authentication code
+		TSharedPtr<BZipArchive> archive = BZipArchive::CreateFromMemory(bytes);
+		const int32 endOfData = dataOffset + static_cast<int32>(archive->GetEntry(TEXT("secret.txt"))->GetCompressedSize());
+
+		for (int32 offset : { (dataOffset + endOfData) / 2, endOfData - 1 })
+		{
+			TArray<uint8> tampered = bytes;
+			BZipLibTest::CorruptByte(tampered, offset);
+
+			std::string read;
+			bool bIsAuthentic = true;
+
+			// the stream ends before its last data, the decoder may stop earlier on the changed data
+			ReadEncryptedEntry(tampered, TEXT("password"), read, bIsAuthentic);
+			TestFalse(TEXT("Not authentic"), bIsAuthentic);
+			TestTrue(TEXT("Last data not passed on"), read.size() < data.size());
+		}
+	}
+
+	// the extraction reports the mismatch and keeps no file
+	{
+		TArray<uint8> tampered = WriteEncryptedArchive(EncryptionMethod::Aes128, StoreMethod::Create(), data);
+		BZipLibTest::CorruptByte(tampered, BZipLibTest::GetOffsetOfFirstEntryData(tampered) + 100);
+
+		const FString archivePath = FPaths::CreateTempFilename(FPlatformProcess::UserTempDir(), TEXT("BZipLibTest"), TEXT(".zip"));
+		const FString destinationPath = FPaths::CreateTempFilename(FPlatformProcess::UserTempDir(), TEXT("BZipLibTest"), TEXT(".txt"));
+
+		{
+			std::ofstream file(TCHAR_TO_UTF8(*archivePath), std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(tampered.GetData()), tampered.Num());
+		}
+
+		FString errorMessage;
+		TestFalse(TEXT("Extraction fails"), BZipFile::ExtractEncryptedFile(archivePath, TEXT("secret.txt"), destinationPath, TEXT("password"), errorMessage));
+		TestFalse(TEXT("Error message"), errorMessage.IsEmpty());
+		TestFalse(TEXT("No extracted file"), IFileManager::Get().FileExists(*destinationPath));
+
+		IFileManager::Get().Delete(*archivePath);
+		IFileManager::Get().Delete(*destinationPath);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveImmediateModeBudgetTest, "BZipLib.Archive.ImmediateMode.Budget", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveImmediateModeBudgetTest::RunTest(const FString& Parameters)
+{
+	const uint64 previousBudget = BZipArchiveEntry::GetImmediateModeMemoryBudget();
+
+	// the budget holds the data of the first entry only, the others spill
+	BZipArchiveEntry::SetImmediateModeMemoryBudget(128 * 1024);
+
+	TArray<std::string> data;
+
+	for (int32 i = 0; i < 6; i++)
+	{
+		std::string random(100000, '\0');
+		uint32 x = static_cast<uint32>(i);
+		for (char& c : random)
+		{
+			x = x * 1103515245 + 12345;
+			c = static_cast<char>(x >> 24);
+		}
+
+		data.Add(random);
+	}
+
+	for (int32 numWorkers : { 1, 4 })
+	{
+		TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+		for (int32 i = 0; i < data.Num(); i++)
+		{
+			// the input is not needed once the entry is compressed
+			std::istringstream input(data[i], std::ios::binary);
+			TSharedPtr<BZipArchiveEntry> entry = archive->CreateEntry(FString::Printf(TEXT("entry%d.bin"), i));
+			entry->SetCompressionStream(input, StoreMethod::Create(), BZipArchiveEntry::CompressionMode::Immediate);
+		}
+
+		const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive, numWorkers);
+		TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+
+		for (int32 i = 0; i < data.Num(); i++)
+		{
+			TestTrue(FString::Printf(TEXT("Entry %d read back"), i), BZipLibTest::ReadEntry(reopened->GetEntry(FString::Printf(TEXT("entry%d.bin"), i))) == data[i]);
+		}
+	}
+
+	BZipArchiveEntry::SetImmediateModeMemoryBudget(previousBudget);
+
+	return true;
+}
+
+#endif
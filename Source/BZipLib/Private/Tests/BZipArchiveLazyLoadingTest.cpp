@@ -0,0 +1,80 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	TArray<uint8> CreateLazyTestArchive()
+	{
+		BZipLibTest::FInputs inputs;
+		TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+		archive->CreateEntry(TEXT("a.txt"))->SetCompressionStream(inputs.Add("first a"), StoreMethod::Create());
+		archive->CreateEntry(TEXT("b.txt"))->SetCompressionStream(inputs.Add("b"), DeflateMethod::Create());
+		archive->CreateEntry(TEXT("c.txt"))->SetCompressionStream(inputs.Add("second a"), DeflateMethod::Create());
+		archive->CreateEntry(TEXT("d.txt"))->SetCompressionStream(inputs.Add("malformed"), StoreMethod::Create());
+		archive->CreateEntry(TEXT("e.txt"))->SetCompressionStream(inputs.Add("e"), DeflateMethod::Create());
+
+		TArray<uint8> bytes = BZipLibTest::WriteArchive(archive);
+
+		// a duplicate of the first name, and a record which passes the scan but fails to materialize
+		BZipLibTest::PatchCentralDirectoryName(bytes, "c.txt", "a.txt");
+		BZipLibTest::PatchCentralDirectoryName(bytes, "d.txt", std::string("\0.txt", 5));
+
+		return bytes;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveLazyLoadingTest, "BZipLib.Archive.LazyLoading", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveLazyLoadingTest::RunTest(const FString& Parameters)
+{
+	const TArray<uint8> bytes = CreateLazyTestArchive();
+
+	// the same entries as the eager loading
+	{
+		TSharedPtr<BZipArchive> eager = BZipArchive::CreateFromMemory(bytes, BZipArchive::EntryLoadingMode::Eager);
+		TSharedPtr<BZipArchive> lazy = BZipArchive::CreateFromMemory(bytes, BZipArchive::EntryLoadingMode::Lazy);
+
+		TestEqual(TEXT("Eager entries"), eager->GetEntriesCount(), 4);
+		TestEqual(TEXT("Lazy records"), lazy->GetEntriesCount(), 5);
+		TestEqual(TEXT("Lazy lookup by name"), BZipLibTest::ReadEntry(lazy->GetEntry(TEXT("e.txt"))), std::string("e"));
+		TestEqual(TEXT("First duplicate wins"), BZipLibTest::ReadEntry(lazy->GetEntry(TEXT("a.txt"))), std::string("first a"));
+	}
+
+	// the first record of a name keeps it, even if a later one is materialized first
+	{
+		TSharedPtr<BZipArchive> lazy = BZipArchive::CreateFromMemory(bytes, BZipArchive::EntryLoadingMode::Lazy);
+
+		TestEqual(TEXT("Later duplicate by index"), BZipLibTest::ReadEntry(lazy->GetEntry(2)), std::string("second a"));
+		TestEqual(TEXT("First duplicate by name"), BZipLibTest::ReadEntry(lazy->GetEntry(TEXT("a.txt"))), std::string("first a"));
+
+		// the shadowed duplicate takes the name over, once the first one is removed
+		TestValid(TEXT("Removed first duplicate"), lazy->RemoveEntry(TEXT("a.txt")));
+		TestEqual(TEXT("Promoted duplicate"), BZipLibTest::ReadEntry(lazy->GetEntry(TEXT("a.txt"))), std::string("second a"));
+	}
+
+	// removing a malformed record keeps the lazy records consistent
+	{
+		TSharedPtr<BZipArchive> lazy = BZipArchive::CreateFromMemory(bytes, BZipArchive::EntryLoadingMode::Lazy);
+
+		TestInvalid(TEXT("Malformed record"), lazy->RemoveEntry(3));
+		TestEqual(TEXT("Records after the removal"), lazy->GetEntriesCount(), 4);
+		TestEqual(TEXT("Lookup after the removal"), BZipLibTest::ReadEntry(lazy->GetEntry(TEXT("e.txt"))), std::string("e"));
+		TestEqual(TEXT("Index after the removal"), BZipLibTest::ReadEntry(lazy->GetEntry(3)), std::string("e"));
+
+		// the archive written again has no trace of the record
+		const TArray<uint8> rewritten = BZipLibTest::WriteArchive(lazy);
+		TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(rewritten);
+
+		TestEqual(TEXT("Rewritten entries"), reopened->GetEntriesCount(), 4);
+		TestEqual(TEXT("Rewritten entry"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("b.txt"))), std::string("b"));
+	}
+
+	return true;
+}
+
+#endif
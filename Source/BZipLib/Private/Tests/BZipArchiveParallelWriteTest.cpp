@@ -0,0 +1,144 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+#include "Misc/QueuedThreadPool.h"
+
+#include <stdexcept>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/**
+	 * \brief Input which fails by an exception after the first buffer.
+	 */
+	class FFailingStreambuf : public std::streambuf
+	{
+	public:
+		FFailingStreambuf()
+			: Buffer(1024, 'x')
+		{
+			setg(Buffer.data(), Buffer.data(), Buffer.data() + Buffer.size());
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			throw std::runtime_error("input failed");
+		}
+
+	private:
+		std::vector<char> Buffer;
+	};
+
+	void AddEntries(TSharedPtr<BZipArchive>& archive, BZipLibTest::FInputs& inputs, int32 count)
+	{
+		for (int32 i = 0; i < count; i++)
+		{
+			archive->CreateEntry(FString::Printf(TEXT("%d.txt"), i))->SetCompressionStream(inputs.Add(std::string(4096, 'a' + i % 26)), DeflateMethod::Create());
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveParallelWriteTest, "BZipLib.Archive.ParallelWrite.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveParallelWriteTest::RunTest(const FString& Parameters)
+{
+	const int32 numberOfEntries = 64;
+
+	BZipLibTest::FInputs inputs;
+	TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+	AddEntries(archive, inputs, numberOfEntries);
+
+	const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive, 4);
+	TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+	TestEqual(TEXT("Entries read back"), reopened->GetEntriesCount(), numberOfEntries);
+
+	for (int32 i = 0; i < numberOfEntries; i++)
+	{
+		TestEqual(TEXT("Entry read back"), BZipLibTest::ReadEntry(reopened->GetEntry(i)), std::string(4096, 'a' + i % 26));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveParallelWriteBlockDeflateTest, "BZipLib.Archive.ParallelWrite.BlockDeflate", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveParallelWriteBlockDeflateTest::RunTest(const FString& Parameters)
+{
+	// the workers take every thread of the pool, the blocks of their entries cannot wait for a free one
+	const int32 numWorkers = GThreadPool->GetNumThreads() + 1;
+	const int32 numberOfEntries = numWorkers * 2;
+
+	BZipLibTest::FInputs inputs;
+	TArray<std::string> data;
+	TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+	for (int32 i = 0; i < numberOfEntries; i++)
+	{
+		std::string text;
+		while (text.size() < 512 * 1024)
+		{
+			text += std::to_string(text.size() * (i + 1)) + " ";
+		}
+
+		data.Add(text);
+
+		TSharedPtr<DeflateMethod> method = DeflateMethod::Create();
+		method->SetNumThreads(4);
+		method->SetParallelBlockSize(64 * 1024);
+
+		archive->CreateEntry(FString::Printf(TEXT("%d.txt"), i))->SetCompressionStream(inputs.Add(text), method);
+	}
+
+	const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive, numWorkers);
+	TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+	TestEqual(TEXT("Entries read back"), reopened->GetEntriesCount(), numberOfEntries);
+
+	for (int32 i = 0; i < numberOfEntries; i++)
+	{
+		TestTrue(FString::Printf(TEXT("Entry %d read back"), i), BZipLibTest::ReadEntry(reopened->GetEntry(i)) == data[i]);
+	}
+
+	return true;
+}
+
+#if !PLATFORM_EXCEPTIONS_DISABLED
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveParallelWriteFailureTest, "BZipLib.Archive.ParallelWrite.Failure", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveParallelWriteFailureTest::RunTest(const FString& Parameters)
+{
+	// the failing entry is compressed by a worker or by the writer, the rest keeps the workers waiting for the writer
+	for (int32 failingIndex : { 0, 5, 63 })
+	{
+		BZipLibTest::FInputs inputs;
+		TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+		AddEntries(archive, inputs, 64);
+
+		FFailingStreambuf failing;
+		std::istream input(&failing);
+		input.exceptions(std::ios::badbit);
+		archive->GetEntry(failingIndex)->SetCompressionStream(input, DeflateMethod::Create());
+
+		bool hasFailed = false;
+
+		try
+		{
+			BZipLibTest::WriteArchive(archive, 4);
+		}
+		catch (const std::runtime_error&)
+		{
+			hasFailed = true;
+		}
+
+		TestTrue(TEXT("Failure reported to the caller"), hasFailed);
+	}
+
+	return true;
+}
+
+#endif
+
+#endif
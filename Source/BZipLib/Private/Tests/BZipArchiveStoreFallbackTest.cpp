@@ -0,0 +1,96 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveStoreFallbackTest, "BZipLib.Archive.StoreFallback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveStoreFallbackTest::RunTest(const FString& Parameters)
+{
+	// random data do not compress, the text does
+	std::string random(100000, '\0');
+	uint32 x = 1;
+	for (char& c : random)
+	{
+		x = x * 1103515245 + 12345;
+		c = static_cast<char>(x >> 24);
+	}
+
+	const std::string text(100000, 'a');
+
+	for (int32 numWorkers : { 1, 4 })
+	{
+		for (bool useDataDescriptor : { false, true })
+		{
+			BZipLibTest::FInputs inputs;
+			TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+			auto addEntry = [&](const FString& name, const std::string& data)
+			{
+				TSharedPtr<BZipArchiveEntry> entry = archive->CreateEntry(name);
+				entry->UseDataDescriptor(useDataDescriptor);
+				entry->SetCompressionStream(inputs.Add(data), DeflateMethod::Create());
+			};
+
+			addEntry(TEXT("random.bin"), random);
+			addEntry(TEXT("text.txt"), text);
+
+			const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive, numWorkers);
+			TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+
+			TSharedPtr<BZipArchiveEntry> randomEntry = reopened->GetEntry(TEXT("random.bin"));
+			TSharedPtr<BZipArchiveEntry> textEntry = reopened->GetEntry(TEXT("text.txt"));
+
+			if (!TestValid(TEXT("Random entry"), randomEntry) || !TestValid(TEXT("Text entry"), textEntry))
+			{
+				continue;
+			}
+
+			TestTrue(TEXT("Random data stored"), randomEntry->GetCompressionMethod() == StoreMethod::CompressionMethod);
+			TestEqual(TEXT("Stored size"), randomEntry->GetCompressedSize(), static_cast<uint64>(random.size()));
+			TestTrue(TEXT("Text deflated"), textEntry->GetCompressionMethod() == DeflateMethod::CompressionMethod);
+
+			TestTrue(TEXT("Random data read back"), BZipLibTest::ReadEntry(randomEntry) == random);
+			TestTrue(TEXT("Text read back"), BZipLibTest::ReadEntry(textEntry) == text);
+
+			// nothing but the entries and the central directory
+			TestTrue(TEXT("Archive size"), static_cast<size_t>(bytes.Num()) < random.size() + 2000);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveStoreFallbackLargeInputTest, "BZipLib.Archive.StoreFallback.LargeInput", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveStoreFallbackLargeInputTest::RunTest(const FString& Parameters)
+{
+	// the serial writer does not buffer an input beyond the trial size, it stays deflated
+	std::string random(static_cast<size_t>(BZipArchive::MAX_STORE_TRIAL_SIZE) + 1, '\0');
+	uint32 x = 1;
+	for (char& c : random)
+	{
+		x = x * 1103515245 + 12345;
+		c = static_cast<char>(x >> 24);
+	}
+
+	BZipLibTest::FInputs inputs;
+	TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+	archive->CreateEntry(TEXT("random.bin"))->SetCompressionStream(inputs.Add(random), DeflateMethod::Create());
+
+	const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive);
+	TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+	TSharedPtr<BZipArchiveEntry> entry = reopened->GetEntry(TEXT("random.bin"));
+
+	if (TestValid(TEXT("Random entry"), entry))
+	{
+		TestTrue(TEXT("Random data deflated"), entry->GetCompressionMethod() == DeflateMethod::CompressionMethod);
+		TestTrue(TEXT("Random data read back"), BZipLibTest::ReadEntry(entry) == random);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	bool HasZip64EndOfCentralDirectory(const TArray<uint8>& archive)
+	{
+		const uint32 recordSignature = 0x06064b50;
+		const uint32 locatorSignature = 0x07064b50;
+		bool hasRecord = false, hasLocator = false;
+
+		// both precede the end of central directory record
+		for (int32 i = FMath::Max(0, archive.Num() - 22 - 56 - 20 - 64); i + 4 <= archive.Num(); i++)
+		{
+			hasRecord |= memcmp(archive.GetData() + i, &recordSignature, 4) == 0;
+			hasLocator |= memcmp(archive.GetData() + i, &locatorSignature, 4) == 0;
+		}
+
+		return hasRecord && hasLocator;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveZip64EntryCountTest, "BZipLib.Archive.Zip64.EntryCount", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipArchiveZip64EntryCountTest::RunTest(const FString& Parameters)
+{
+	const int32 numberOfEntries = 70000;
+
+	BZipLibTest::FInputs inputs;
+	TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+
+	for (int32 i = 0; i < numberOfEntries; i++)
+	{
+		TSharedPtr<BZipArchiveEntry> entry = archive->CreateEntry(FString::Printf(TEXT("dir/%d.txt"), i));
+
+		if (i % 1000 == 0)
+		{
+			entry->SetCompressionStream(inputs.Add(std::to_string(i)), StoreMethod::Create());
+		}
+	}
+
+	// the records exceed the 16-bit count of the classic end of central directory record
+	const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive);
+	TestTrue(TEXT("ZIP64 end of central directory written"), HasZip64EndOfCentralDirectory(bytes));
+
+	for (BZipArchive::EntryLoadingMode mode : { BZipArchive::EntryLoadingMode::Eager, BZipArchive::EntryLoadingMode::Lazy })
+	{
+		TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes, mode);
+
+		TestEqual(TEXT("Entries read back"), reopened->GetEntriesCount(), numberOfEntries);
+		TestEqual(TEXT("Last entry"), BZipLibTest::ReadEntry(reopened->GetEntry(TEXT("dir/69000.txt"))), std::string("69000"));
+		TestEqual(TEXT("Empty entry"), BZipLibTest::ReadEntry(reopened->GetEntry(numberOfEntries - 1)), std::string());
+	}
+
+	// a small archive stays classic
+	{
+		TSharedPtr<BZipArchive> small = BZipArchive::Create();
+		small->CreateEntry(TEXT("a.txt"))->SetCompressionStream(inputs.Add("a"));
+		TestFalse(TEXT("Classic end of central directory"), HasZip64EndOfCentralDirectory(BZipLibTest::WriteArchive(small)));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipArchiveZip64EntrySizeTest, "BZipLib.Archive.Zip64.EntrySize", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::StressFilter)
+
+bool FBZipArchiveZip64EntrySizeTest::RunTest(const FString& Parameters)
+{
+	// the zeros deflate to a few megabytes, the archive stays in the memory
+	const uint64 size = (uint64(4) << 30) + 4096;
+
+	TSharedPtr<DeflateMethod> method = DeflateMethod::Create();
+	method->SetCompressionLevel(DeflateMethod::CompressionLevel::Fastest);
+
+	for (bool useDataDescriptor : { false, true })
+	{
+		BZipLibTest::FZeroStreambuf zeros(size);
+		std::istream input(&zeros);
+
+		TSharedPtr<BZipArchive> archive = BZipArchive::Create();
+		TSharedPtr<BZipArchiveEntry> entry = archive->CreateEntry(TEXT("zeros.bin"));
+		entry->UseDataDescriptor(useDataDescriptor);
+		entry->SetCompressionStream(input, method);
+
+		const TArray<uint8> bytes = BZipLibTest::WriteArchive(archive);
+		TSharedPtr<BZipArchive> reopened = BZipArchive::CreateFromMemory(bytes);
+		TSharedPtr<BZipArchiveEntry> reopenedEntry = reopened->GetEntry(TEXT("zeros.bin"));
+
+		if (!TestValid(TEXT("Large entry read back"), reopenedEntry))
+		{
+			continue;
+		}
+
+		TestEqual(TEXT("64-bit size"), reopenedEntry->GetSize(), size);
+		TestTrue(TEXT("Compressed size"), reopenedEntry->GetCompressedSize() > 0 && reopenedEntry->GetCompressedSize() < static_cast<uint64>(bytes.Num()));
+
+		// the decompressed data are checked against the crc32 of the entry
+		std::istream* stream = reopenedEntry->GetDecompressionStream();
+		uint64 bytesRead = 0;
+		bool allZeros = stream != nullptr;
+
+		if (stream != nullptr)
+		{
+			std::vector<char> buffer(1 << 20);
+			while (stream->read(buffer.data(), buffer.size()), stream->gcount() > 0)
+			{
+				const size_t count = static_cast<size_t>(stream->gcount());
+				allZeros = allZeros && std::all_of(buffer.data(), buffer.data() + count, [](char c) { return c == 0; });
+				bytesRead += count;
+			}
+		}
+
+		reopenedEntry->CloseDecompressionStream();
+
+		TestEqual(TEXT("Decompressed size"), bytesRead, size);
+		TestTrue(TEXT("Decompressed data"), allZeros);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "Misc/AutomationTest.h"
+#include "BZipLibTestUtils.h"
+#include "BZipFile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+#include <fstream>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBZipFileCompressAllTest, "BZipLib.File.CompressAll", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBZipFileCompressAllTest::RunTest(const FString& Parameters)
+{
+	const FString Folder = FPaths::CreateTempFilename(FPlatformProcess::UserTempDir(), TEXT("BZipLibCompressAll"));
+	const FString ZipPath = Folder + TEXT(".zip");
+
+	// random data, which are sampled, and the text and the image, which are picked by their names
+	std::string Random(100000, '\0');
+	uint32 X = 1;
+	for (char& C : Random)
+	{
+		X = X * 1103515245 + 12345;
+		C = static_cast<char>(X >> 24);
+	}
+
+	const std::string Text(100000, 'a');
+
+	TArray<FString> Names;
+	TArray<std::string> Contents;
+
+	auto AddFile = [&](const FString& Name, const std::string& Content)
+	{
+		const FString Path = Folder + TEXT("/") + Name;
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+
+		std::ofstream Stream(TCHAR_TO_UTF8(*Path), std::ios::binary);
+		Stream.write(Content.data(), static_cast<std::streamsize>(Content.size()));
+
+		Names.Add(Name);
+		Contents.Add(Content);
+	};
+
+	for (int32 i = 0; i < 20; i++)
+	{
+		AddFile(FString::Printf(TEXT("dir%d/random%d.bin"), i % 3, i), Random);
+		AddFile(FString::Printf(TEXT("dir%d/text%d.txt"), i % 3, i), Text);
+		AddFile(FString::Printf(TEXT("image%d.png"), i), Text);
+	}
+
+	for (int32 NumWorkers : { 1, 4 })
+	{
+		for (bool bDeduplicate : { false, true })
+		{
+			IFileManager::Get().Delete(*ZipPath);
+
+			FString ErrorMessage;
+			if (!TestTrue(TEXT("Compressed"), BZipFile::CompressAll(Folder, ZipPath, ErrorMessage, NumWorkers, ZipMethodSelector(), bDeduplicate)))
+			{
+				AddError(ErrorMessage);
+				continue;
+			}
+
+			TSharedPtr<BZipArchive> Archive;
+			if (!TestTrue(TEXT("Opened"), BZipFile::Open(Archive, ZipPath, ErrorMessage)))
+			{
+				continue;
+			}
+
+			TestEqual(TEXT("Entries"), Archive->GetEntriesCount(), Names.Num());
+
+			for (int32 i = 0; i < Names.Num(); i++)
+			{
+				TSharedPtr<BZipArchiveEntry> Entry = Archive->GetEntry(Names[i]);
+
+				if (!TestValid(Names[i], Entry))
+				{
+					continue;
+				}
+
+				const bool bIsStored = Entry->GetCompressionMethod() == StoreMethod::CompressionMethod;
+				TestEqual(Names[i] + TEXT(" stored"), bIsStored, !Names[i].EndsWith(TEXT(".txt")));
+				TestTrue(Names[i] + TEXT(" read back"), BZipLibTest::ReadEntry(Entry) == Contents[i]);
+			}
+
+			Archive.Reset();
+		}
+	}
+
+	// the folder is empty, nothing is written
+	const FString EmptyFolder = Folder + TEXT("/empty");
+	IFileManager::Get().MakeDirectory(*EmptyFolder, true);
+
+	FString ErrorMessage;
+	TestFalse(TEXT("Empty folder"), BZipFile::CompressAll(EmptyFolder, EmptyFolder + TEXT(".zip"), ErrorMessage));
+
+	IFileManager::Get().DeleteDirectory(*Folder, false, true);
+	IFileManager::Get().Delete(*ZipPath);
+
+	return true;
+}
+
+#endif
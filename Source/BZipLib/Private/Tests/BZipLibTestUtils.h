@@ -0,0 +1,169 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BZipArchive.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace BZipLibTest
+{
+	/**
+	 * \brief Inputs of the entries, which must live until the archive is written.
+	 */
+	class FInputs
+	{
+	public:
+		std::istream& Add(const std::string& data)
+		{
+			Streams.emplace_back(new std::istringstream(data, std::ios::binary));
+			return *Streams.back();
+		}
+
+	private:
+		std::vector<TUniquePtr<std::istringstream>> Streams;
+	};
+
+	/**
+	 * \brief Seekable input of the given number of zero bytes, which never holds more than one buffer of them.
+	 */
+	class FZeroStreambuf : public std::streambuf
+	{
+	public:
+		explicit FZeroStreambuf(uint64 size)
+			: Size(size)
+			, Position(0)
+			, Buffer(1 << 16, 0)
+		{
+
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			Position += static_cast<uint64>(egptr() - eback());
+
+			if (Position >= Size)
+			{
+				setg(nullptr, nullptr, nullptr);
+				return traits_type::eof();
+			}
+
+			const size_t length = static_cast<size_t>(std::min<uint64>(Buffer.size(), Size - Position));
+			setg(Buffer.data(), Buffer.data(), Buffer.data() + length);
+			return traits_type::to_int_type(*gptr());
+		}
+
+		pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which) override
+		{
+			const uint64 current = Position + static_cast<uint64>(gptr() - eback());
+			const off_type base = dir == std::ios::beg ? 0 : dir == std::ios::cur ? static_cast<off_type>(current) : static_cast<off_type>(Size);
+			return seekpos(pos_type(base + off), which);
+		}
+
+		pos_type seekpos(pos_type pos, std::ios::openmode which) override
+		{
+			const off_type target = static_cast<off_type>(pos);
+
+			if (target < 0 || static_cast<uint64>(target) > Size)
+			{
+				return pos_type(off_type(-1));
+			}
+
+			Position = static_cast<uint64>(target);
+			setg(nullptr, nullptr, nullptr);
+			return pos;
+		}
+
+	private:
+		uint64 Size;
+		uint64 Position;      //< position of the start of the get area
+		std::vector<char> Buffer;
+	};
+
+	inline TArray<uint8> WriteArchive(const TSharedPtr<BZipArchive>& archive, int32 numWorkers = 1)
+	{
+		std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+		archive->WriteToStream(stream, numWorkers);
+
+		const std::string bytes = stream.str();
+
+		TArray<uint8> result;
+		result.SetNumUninitialized(static_cast<int32>(bytes.size()));
+		memcpy(result.GetData(), bytes.data(), bytes.size());
+		return result;
+	}
+
+	inline std::string ReadEntry(const TSharedPtr<BZipArchiveEntry>& entry)
+	{
+		std::string result;
+
+		if (!entry.IsValid())
+		{
+			return result;
+		}
+
+		std::istream* stream = entry->GetDecompressionStream();
+
+		if (stream != nullptr)
+		{
+			char buffer[4096];
+			while (stream->read(buffer, sizeof(buffer)), stream->gcount() > 0)
+			{
+				result.append(buffer, static_cast<size_t>(stream->gcount()));
+			}
+		}
+
+		entry->CloseDecompressionStream();
+		return result;
+	}
+
+	/**
+	 * \brief Renames the central directory record of the given name, the names must be of the same length.
+	 */
+	inline bool PatchCentralDirectoryName(TArray<uint8>& archive, const std::string& name, const std::string& newName)
+	{
+		const uint32 signature = 0x02014b50;
+		const int32 filenameOffset = 46;
+
+		for (int32 i = 0; i + filenameOffset + static_cast<int32>(name.size()) <= archive.Num(); i++)
+		{
+			if (memcmp(archive.GetData() + i, &signature, sizeof(signature)) == 0
+				&& memcmp(archive.GetData() + i + filenameOffset, name.data(), name.size()) == 0)
+			{
+				memcpy(archive.GetData() + i + filenameOffset, newName.data(), newName.size());
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * \brief Flips the bits of the byte at the given offset of the archive.
+	 */
+	inline void CorruptByte(TArray<uint8>& archive, int32 offset)
+	{
+		archive[offset] ^= 0x5a;
+	}
+
+	/**
+	 * \brief Offset of the compressed data of the first entry, behind its local file header.
+	 */
+	inline int32 GetOffsetOfFirstEntryData(const TArray<uint8>& archive)
+	{
+		const int32 filenameLengthOffset = 26;
+		const int32 extraFieldLengthOffset = 28;
+		const int32 localFileHeaderSize = 30;
+
+		const int32 filenameLength = archive[filenameLengthOffset] | archive[filenameLengthOffset + 1] << 8;
+		const int32 extraFieldLength = archive[extraFieldLengthOffset] | archive[extraFieldLengthOffset + 1] << 8;
+
+		return localFileHeaderSize + filenameLength + extraFieldLength;
+	}
+}
@@ -2,6 +2,7 @@
 
 #include "detail/EndOfCentralDirectoryBlock.h"
 #include "streams/serialization.h"
+#include <algorithm>
 #include <cstring>
 
 namespace detail {
@@ -36,6 +37,31 @@ namespace detail {
 		return true;
 	}
 
+	bool EndOfCentralDirectoryBlock::Deserialize(const uint8_t*& data, const uint8_t* end)
+	{
+		const uint8_t* cursor = data;
+
+		if (static_cast<size_t>(end - cursor) < SIZE_IN_BYTES)
+		{
+			return false;
+		}
+
+		deserialize(cursor, end, Signature);
+		deserialize(cursor, end, NumberOfThisDisk);
+		deserialize(cursor, end, NumberOfTheDiskWithTheStartOfTheCentralDirectory);
+		deserialize(cursor, end, NumberOfEntriesInTheCentralDirectoryOnThisDisk);
+		deserialize(cursor, end, NumberOfEntriesInTheCentralDirectory);
+		deserialize(cursor, end, SizeOfCentralDirectory);
+		deserialize(cursor, end, OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber);
+		deserialize(cursor, end, CommentLength);
+
+		// tolerate truncated comments
+		deserialize(cursor, end, Comment, std::min(static_cast<size_t>(CommentLength), static_cast<size_t>(end - cursor)));
+
+		data = cursor;
+		return true;
+	}
+
 	void EndOfCentralDirectoryBlock::Serialize(std::ostream& stream)
 	{
 		CommentLength = static_cast<uint16_t>(Comment.length());
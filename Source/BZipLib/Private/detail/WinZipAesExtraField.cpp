@@ -0,0 +1,79 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "detail/WinZipAesExtraField.h"
+#include "streams/serialization.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace detail {
+
+	WinZipAesExtraField::WinZipAesExtraField()
+		: VendorVersion(VendorVersionAE2)
+		, VendorId(VendorIdConstant)
+		, Strength(3)
+		, CompressionMethod(0)
+	{
+
+	}
+
+	bool WinZipAesExtraField::Deserialize(const std::vector<ZipGenericExtraField>& extraFields)
+	{
+		for (auto& extraField : extraFields)
+		{
+			if (extraField.Tag != TagConstant)
+			{
+				continue;
+			}
+
+			const uint8_t* cursor = extraField.Data.data();
+			const uint8_t* end = cursor + extraField.Data.size();
+
+			return deserialize(cursor, end, VendorVersion)
+				&& deserialize(cursor, end, VendorId)
+				&& deserialize(cursor, end, Strength)
+				&& deserialize(cursor, end, CompressionMethod)
+				&& VendorId == VendorIdConstant
+				&& GetKeyLength() != 0;
+		}
+
+		return false;
+	}
+
+	void WinZipAesExtraField::Serialize(std::vector<ZipGenericExtraField>& extraFields, bool isUsed)
+	{
+		auto existing = std::find_if(extraFields.begin(), extraFields.end(), [](const ZipGenericExtraField& extraField) { return extraField.Tag == TagConstant; });
+
+		if (!isUsed)
+		{
+			if (existing != extraFields.end())
+			{
+				extraFields.erase(existing);
+			}
+
+			return;
+		}
+
+		ZipGenericExtraField extraField;
+		extraField.Tag = TagConstant;
+		extraField.Size = static_cast<uint16_t>(DATA_SIZE);
+		extraField.Data.resize(DATA_SIZE);
+
+		uint8_t* cursor = extraField.Data.data();
+		memcpy(cursor + 0, &VendorVersion, sizeof(VendorVersion));
+		memcpy(cursor + 2, &VendorId, sizeof(VendorId));
+		memcpy(cursor + 4, &Strength, sizeof(Strength));
+		memcpy(cursor + 5, &CompressionMethod, sizeof(CompressionMethod));
+
+		// keep the position, so the size of the headers does not change
+		if (existing != extraFields.end())
+		{
+			*existing = extraField;
+		}
+		else
+		{
+			extraFields.push_back(extraField);
+		}
+	}
+
+}
@@ -0,0 +1,111 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "detail/Zip64EndOfCentralDirectoryBlock.h"
+#include "streams/serialization.h"
+
+namespace detail {
+
+	Zip64EndOfCentralDirectoryLocator::Zip64EndOfCentralDirectoryLocator()
+		: Signature(SignatureConstant)
+		, NumberOfTheDiskWithTheStartOfTheZip64EndOfCentralDirectory(0)
+		, RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord(0)
+		, TotalNumberOfDisks(1)
+	{
+
+	}
+
+	bool Zip64EndOfCentralDirectoryLocator::Deserialize(const uint8_t*& data, const uint8_t* end)
+	{
+		const uint8_t* cursor = data;
+
+		if (static_cast<size_t>(end - cursor) < SIZE_IN_BYTES)
+		{
+			return false;
+		}
+
+		// the struct is not packed, read field by field
+		deserialize(cursor, end, Signature);
+		deserialize(cursor, end, NumberOfTheDiskWithTheStartOfTheZip64EndOfCentralDirectory);
+		deserialize(cursor, end, RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord);
+		deserialize(cursor, end, TotalNumberOfDisks);
+
+		if (Signature != SignatureConstant)
+		{
+			return false;
+		}
+
+		data = cursor;
+		return true;
+	}
+
+	void Zip64EndOfCentralDirectoryLocator::Serialize(std::ostream& stream)
+	{
+		serialize(stream, Signature);
+		serialize(stream, NumberOfTheDiskWithTheStartOfTheZip64EndOfCentralDirectory);
+		serialize(stream, RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord);
+		serialize(stream, TotalNumberOfDisks);
+	}
+
+	Zip64EndOfCentralDirectoryBlock::Zip64EndOfCentralDirectoryBlock()
+		: Signature(SignatureConstant)
+		, SizeOfZip64EndOfCentralDirectoryRecord(SIZE_IN_BYTES - sizeof(uint32_t) - sizeof(uint64_t))
+		, VersionMadeBy(0)
+		, VersionNeededToExtract(0)
+		, NumberOfThisDisk(0)
+		, NumberOfTheDiskWithTheStartOfTheCentralDirectory(0)
+		, NumberOfEntriesInTheCentralDirectoryOnThisDisk(0)
+		, NumberOfEntriesInTheCentralDirectory(0)
+		, SizeOfCentralDirectory(0)
+		, OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber(0)
+	{
+
+	}
+
+	bool Zip64EndOfCentralDirectoryBlock::Deserialize(const uint8_t*& data, const uint8_t* end)
+	{
+		const uint8_t* cursor = data;
+
+		if (static_cast<size_t>(end - cursor) < SIZE_IN_BYTES)
+		{
+			return false;
+		}
+
+		deserialize(cursor, end, Signature);
+		deserialize(cursor, end, SizeOfZip64EndOfCentralDirectoryRecord);
+		deserialize(cursor, end, VersionMadeBy);
+		deserialize(cursor, end, VersionNeededToExtract);
+		deserialize(cursor, end, NumberOfThisDisk);
+		deserialize(cursor, end, NumberOfTheDiskWithTheStartOfTheCentralDirectory);
+		deserialize(cursor, end, NumberOfEntriesInTheCentralDirectoryOnThisDisk);
+		deserialize(cursor, end, NumberOfEntriesInTheCentralDirectory);
+		deserialize(cursor, end, SizeOfCentralDirectory);
+		deserialize(cursor, end, OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber);
+
+		if (Signature != SignatureConstant)
+		{
+			return false;
+		}
+
+		// the extensible data sector is not used
+		data = cursor;
+		return true;
+	}
+
+	void Zip64EndOfCentralDirectoryBlock::Serialize(std::ostream& stream)
+	{
+		// the size does not include the leading 12 bytes
+		SizeOfZip64EndOfCentralDirectoryRecord = SIZE_IN_BYTES - sizeof(Signature) - sizeof(SizeOfZip64EndOfCentralDirectoryRecord);
+
+		serialize(stream, Signature);
+		serialize(stream, SizeOfZip64EndOfCentralDirectoryRecord);
+		serialize(stream, VersionMadeBy);
+		serialize(stream, VersionNeededToExtract);
+		serialize(stream, NumberOfThisDisk);
+		serialize(stream, NumberOfTheDiskWithTheStartOfTheCentralDirectory);
+		serialize(stream, NumberOfEntriesInTheCentralDirectoryOnThisDisk);
+		serialize(stream, NumberOfEntriesInTheCentralDirectory);
+		serialize(stream, SizeOfCentralDirectory);
+		serialize(stream, OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber);
+	}
+
+}
@@ -0,0 +1,76 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "detail/Zip64ExtendedInformationExtraField.h"
+#include "streams/serialization.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace detail {
+
+	Zip64ExtendedInformationExtraField::Zip64ExtendedInformationExtraField()
+		: UncompressedSize(0)
+		, CompressedSize(0)
+		, RelativeOffsetOfLocalHeader(0)
+		, DiskStartNumber(0)
+	{
+
+	}
+
+	bool Zip64ExtendedInformationExtraField::Deserialize(const std::vector<ZipGenericExtraField>& extraFields,
+		bool hasUncompressedSize, bool hasCompressedSize, bool hasRelativeOffsetOfLocalHeader, bool hasDiskStartNumber)
+	{
+		for (auto& extraField : extraFields)
+		{
+			if (extraField.Tag != TagConstant)
+			{
+				continue;
+			}
+
+			const uint8_t* cursor = extraField.Data.data();
+			const uint8_t* end = cursor + extraField.Data.size();
+
+			// a missing value makes the whole field invalid
+			return (!hasUncompressedSize || deserialize(cursor, end, UncompressedSize))
+				&& (!hasCompressedSize || deserialize(cursor, end, CompressedSize))
+				&& (!hasRelativeOffsetOfLocalHeader || deserialize(cursor, end, RelativeOffsetOfLocalHeader))
+				&& (!hasDiskStartNumber || deserialize(cursor, end, DiskStartNumber));
+		}
+
+		return false;
+	}
+
+	void Zip64ExtendedInformationExtraField::Serialize(std::vector<ZipGenericExtraField>& extraFields,
+		bool hasUncompressedSize, bool hasCompressedSize, bool hasRelativeOffsetOfLocalHeader, bool hasDiskStartNumber)
+	{
+		extraFields.erase(
+			std::remove_if(extraFields.begin(), extraFields.end(), [](const ZipGenericExtraField& extraField) { return extraField.Tag == TagConstant; }),
+			extraFields.end());
+
+		if (!hasUncompressedSize && !hasCompressedSize && !hasRelativeOffsetOfLocalHeader && !hasDiskStartNumber)
+		{
+			return;
+		}
+
+		ZipGenericExtraField extraField;
+		extraField.Tag = TagConstant;
+
+		auto append = [&extraField](const void* value, size_t size)
+		{
+			size_t offset = extraField.Data.size();
+			extraField.Data.resize(offset + size);
+			memcpy(extraField.Data.data() + offset, value, size);
+		};
+
+		if (hasUncompressedSize) append(&UncompressedSize, sizeof(UncompressedSize));
+		if (hasCompressedSize) append(&CompressedSize, sizeof(CompressedSize));
+		if (hasRelativeOffsetOfLocalHeader) append(&RelativeOffsetOfLocalHeader, sizeof(RelativeOffsetOfLocalHeader));
+		if (hasDiskStartNumber) append(&DiskStartNumber, sizeof(DiskStartNumber));
+
+		extraField.Size = static_cast<uint16_t>(extraField.Data.size());
+
+		// keep it first, some readers look only there
+		extraFields.insert(extraFields.begin(), extraField);
+	}
+
+}
@@ -2,6 +2,7 @@
 
 #include "detail/ZipCentralDirectoryFileHeader.h"
 #include "detail/ZipLocalFileHeader.h"
+#include "detail/Zip64ExtendedInformationExtraField.h"
 
 #include "streams/serialization.h"
 
@@ -14,6 +15,10 @@ namespace detail {
 	{
 		memset(this, 0, sizeof(ZipCentralDirectoryFileHeaderBase));
 		Signature = SignatureConstant;
+
+		CompressedSize64 = 0;
+		UncompressedSize64 = 0;
+		RelativeOffsetOfLocalHeader64 = 0;
 	}
 
 	void ZipCentralDirectoryFileHeader::SyncWithLocalFileHeader(ZipLocalFileHeader& lfh)
@@ -21,6 +26,8 @@ namespace detail {
 		Crc32 = lfh.Crc32;
 		CompressedSize = lfh.CompressedSize;
 		UncompressedSize = lfh.UncompressedSize;
+		CompressedSize64 = lfh.CompressedSize64;
+		UncompressedSize64 = lfh.UncompressedSize64;
 
 		FilenameLength = static_cast<uint16_t>(Filename.length());
 		FileCommentLength = static_cast<uint16_t>(FileComment.length());
@@ -77,11 +84,117 @@ namespace detail {
 
 		deserialize(stream, FileComment, FileCommentLength);
 
+		this->ReadZip64ExtendedInformation();
+
 		return true;
 	}
 
+	bool ZipCentralDirectoryFileHeader::Deserialize(const uint8_t*& data, const uint8_t* end)
+	{
+		const uint8_t* cursor = data;
+
+		if (!deserialize(cursor, end, Signature) || Signature != SignatureConstant)
+		{
+			// If there is not any other entry.
+			return false;
+		}
+
+		if (static_cast<size_t>(end - cursor) < SIZE_IN_BYTES - sizeof(Signature))
+		{
+			return false;
+		}
+
+		deserialize(cursor, end, VersionMadeBy);
+		deserialize(cursor, end, VersionNeededToExtract);
+		deserialize(cursor, end, GeneralPurposeBitFlag);
+		deserialize(cursor, end, CompressionMethod);
+		deserialize(cursor, end, LastModificationTime);
+		deserialize(cursor, end, LastModificationDate);
+		deserialize(cursor, end, Crc32);
+		deserialize(cursor, end, CompressedSize);
+		deserialize(cursor, end, UncompressedSize);
+		deserialize(cursor, end, FilenameLength);
+		deserialize(cursor, end, ExtraFieldLength);
+		deserialize(cursor, end, FileCommentLength);
+		deserialize(cursor, end, DiskNumberStart);
+		deserialize(cursor, end, InternalFileAttributes);
+		deserialize(cursor, end, ExternalFileAttributes);
+		deserialize(cursor, end, RelativeOffsetOfLocalHeader);
+
+		if (!deserialize(cursor, end, Filename, FilenameLength))
+		{
+			return false;
+		}
+
+		if (ExtraFieldLength > 0)
+		{
+			if (static_cast<size_t>(end - cursor) < ExtraFieldLength)
+			{
+				return false;
+			}
+
+			ZipGenericExtraField extraField;
+			const uint8_t* extraFieldEnd = cursor + ExtraFieldLength;
+
+			while (extraField.Deserialize(cursor, extraFieldEnd))
+			{
+				ExtraFields.push_back(extraField);
+			}
+
+			// skip extra fields which are not stored as tag, size and data tuples
+			cursor = extraFieldEnd;
+		}
+
+		if (!deserialize(cursor, end, FileComment, FileCommentLength))
+		{
+			return false;
+		}
+
+		this->ReadZip64ExtendedInformation();
+
+		data = cursor;
+		return true;
+	}
+
+	void ZipCentralDirectoryFileHeader::ReadZip64ExtendedInformation()
+	{
+		CompressedSize64 = CompressedSize;
+		UncompressedSize64 = UncompressedSize;
+		RelativeOffsetOfLocalHeader64 = static_cast<uint32_t>(RelativeOffsetOfLocalHeader);
+
+		bool hasUncompressedSize = UncompressedSize == Zip64ExtendedInformationExtraField::SaturatedValue32;
+		bool hasCompressedSize = CompressedSize == Zip64ExtendedInformationExtraField::SaturatedValue32;
+		bool hasRelativeOffsetOfLocalHeader = static_cast<uint32_t>(RelativeOffsetOfLocalHeader) == Zip64ExtendedInformationExtraField::SaturatedValue32;
+		bool hasDiskStartNumber = DiskNumberStart == Zip64ExtendedInformationExtraField::SaturatedValue16;
+
+		if (hasUncompressedSize || hasCompressedSize || hasRelativeOffsetOfLocalHeader || hasDiskStartNumber)
+		{
+			Zip64ExtendedInformationExtraField zip64;
+
+			if (zip64.Deserialize(ExtraFields, hasUncompressedSize, hasCompressedSize, hasRelativeOffsetOfLocalHeader, hasDiskStartNumber))
+			{
+				if (hasUncompressedSize) UncompressedSize64 = zip64.UncompressedSize;
+				if (hasCompressedSize) CompressedSize64 = zip64.CompressedSize;
+				if (hasRelativeOffsetOfLocalHeader) RelativeOffsetOfLocalHeader64 = zip64.RelativeOffsetOfLocalHeader;
+			}
+		}
+	}
+
 	void ZipCentralDirectoryFileHeader::Serialize(std::ostream& stream)
 	{
+		bool hasUncompressedSize = UncompressedSize64 >= Zip64ExtendedInformationExtraField::SaturatedValue32;
+		bool hasCompressedSize = CompressedSize64 >= Zip64ExtendedInformationExtraField::SaturatedValue32;
+		bool hasRelativeOffsetOfLocalHeader = RelativeOffsetOfLocalHeader64 >= Zip64ExtendedInformationExtraField::SaturatedValue32;
+
+		Zip64ExtendedInformationExtraField zip64;
+		zip64.UncompressedSize = UncompressedSize64;
+		zip64.CompressedSize = CompressedSize64;
+		zip64.RelativeOffsetOfLocalHeader = RelativeOffsetOfLocalHeader64;
+		zip64.Serialize(ExtraFields, hasUncompressedSize, hasCompressedSize, hasRelativeOffsetOfLocalHeader, false);
+
+		CompressedSize = Zip64ExtendedInformationExtraField::Saturate32(CompressedSize64);
+		UncompressedSize = Zip64ExtendedInformationExtraField::Saturate32(UncompressedSize64);
+		RelativeOffsetOfLocalHeader = static_cast<int32_t>(Zip64ExtendedInformationExtraField::Saturate32(RelativeOffsetOfLocalHeader64));
 		FilenameLength = static_cast<uint16_t>(Filename.length());
 		FileCommentLength = static_cast<uint16_t>(FileComment.length());
 		ExtraFieldLength = 0;
@@ -25,6 +25,21 @@ namespace detail {
 		return true;
 	}
 
+	bool ZipGenericExtraField::Deserialize(const uint8_t*& data, const uint8_t* extraFieldEnd)
+	{
+		const uint8_t* cursor = data;
+
+		if (!deserialize(cursor, extraFieldEnd, Tag) ||
+			!deserialize(cursor, extraFieldEnd, Size) ||
+			!deserialize(cursor, extraFieldEnd, Data, Size))
+		{
+			return false;
+		}
+
+		data = cursor;
+		return true;
+	}
+
 	void ZipGenericExtraField::Serialize(std::ostream& stream)
 	{
 		Size = static_cast<uint16_t>(Data.size());
@@ -2,6 +2,7 @@
 
 #include "detail/ZipLocalFileHeader.h"
 #include "detail/ZipCentralDirectoryFileHeader.h"
+#include "detail/Zip64ExtendedInformationExtraField.h"
 
 #include "streams/serialization.h"
 
@@ -13,6 +14,10 @@ namespace detail {
 	{
 		memset(this, 0, sizeof(ZipLocalFileHeaderBase));
 		Signature = SignatureConstant;
+
+		CompressedSize64 = 0;
+		UncompressedSize64 = 0;
+		UseZip64 = false;
 	}
 
 	void ZipLocalFileHeader::SyncWithCentralDirectoryFileHeader(ZipCentralDirectoryFileHeader& cdfh)
@@ -25,6 +30,8 @@ namespace detail {
 		Crc32 = cdfh.Crc32;
 		CompressedSize = cdfh.CompressedSize;
 		UncompressedSize = cdfh.UncompressedSize;
+		CompressedSize64 = cdfh.CompressedSize64;
+		UncompressedSize64 = cdfh.UncompressedSize64;
 
 		Filename = cdfh.Filename;
 		FilenameLength = static_cast<uint16_t>(Filename.length());
@@ -79,11 +86,96 @@ namespace detail {
 			stream.seekg(extraFieldEnd, std::ios::beg);
 		}
 
+		this->ReadZip64ExtendedInformation();
+
+		return true;
+	}
+
+	bool ZipLocalFileHeader::Deserialize(const uint8_t*& data, const uint8_t* end)
+	{
+		const uint8_t* cursor = data;
+
+		if (!deserialize(cursor, end, Signature) || Signature != SignatureConstant)
+		{
+			// If there is not any other entry.
+			return false;
+		}
+
+		if (static_cast<size_t>(end - cursor) < SIZE_IN_BYTES - sizeof(Signature))
+		{
+			return false;
+		}
+
+		deserialize(cursor, end, VersionNeededToExtract);
+		deserialize(cursor, end, GeneralPurposeBitFlag);
+		deserialize(cursor, end, CompressionMethod);
+		deserialize(cursor, end, LastModificationTime);
+		deserialize(cursor, end, LastModificationDate);
+		deserialize(cursor, end, Crc32);
+		deserialize(cursor, end, CompressedSize);
+		deserialize(cursor, end, UncompressedSize);
+		deserialize(cursor, end, FilenameLength);
+		deserialize(cursor, end, ExtraFieldLength);
+
+		if (!deserialize(cursor, end, Filename, FilenameLength))
+		{
+			return false;
+		}
+
+		if (ExtraFieldLength > 0)
+		{
+			if (static_cast<size_t>(end - cursor) < ExtraFieldLength)
+			{
+				return false;
+			}
+
+			ZipGenericExtraField extraField;
+			const uint8_t* extraFieldEnd = cursor + ExtraFieldLength;
+
+			while (extraField.Deserialize(cursor, extraFieldEnd))
+			{
+				ExtraFields.push_back(extraField);
+			}
+
+			// skip extra fields which are not stored as tag, size and data tuples
+			cursor = extraFieldEnd;
+		}
+
+		this->ReadZip64ExtendedInformation();
+
+		data = cursor;
 		return true;
 	}
 
+	void ZipLocalFileHeader::ReadZip64ExtendedInformation()
+	{
+		CompressedSize64 = CompressedSize;
+		UncompressedSize64 = UncompressedSize;
+
+		if (UncompressedSize == Zip64ExtendedInformationExtraField::SaturatedValue32 ||
+			CompressedSize == Zip64ExtendedInformationExtraField::SaturatedValue32)
+		{
+			// the local header must carry both sizes
+			Zip64ExtendedInformationExtraField zip64;
+
+			if (zip64.Deserialize(ExtraFields, true, true, false, false))
+			{
+				CompressedSize64 = zip64.CompressedSize;
+				UncompressedSize64 = zip64.UncompressedSize;
+				UseZip64 = true;
+			}
+		}
+	}
+
 	void ZipLocalFileHeader::Serialize(std::ostream& stream)
 	{
+		Zip64ExtendedInformationExtraField zip64;
+		zip64.UncompressedSize = UncompressedSize64;
+		zip64.CompressedSize = CompressedSize64;
+		zip64.Serialize(ExtraFields, UseZip64, UseZip64, false, false);
+
+		CompressedSize = UseZip64 ? Zip64ExtendedInformationExtraField::SaturatedValue32 : Zip64ExtendedInformationExtraField::Saturate32(CompressedSize64);
+		UncompressedSize = UseZip64 ? Zip64ExtendedInformationExtraField::SaturatedValue32 : Zip64ExtendedInformationExtraField::Saturate32(UncompressedSize64);
 		FilenameLength = static_cast<uint16_t>(Filename.length());
 		ExtraFieldLength = 0;
 
@@ -140,14 +232,29 @@ namespace detail {
 
 		deserialize(stream, CompressedSize);
 		deserialize(stream, UncompressedSize);
+
+		CompressedSize64 = CompressedSize;
+		UncompressedSize64 = UncompressedSize;
 	}
 
 	void ZipLocalFileHeader::SerializeAsDataDescriptor(std::ostream& stream)
 	{
 		serialize(stream, DataDescriptorSignature);
 		serialize(stream, Crc32);
-		serialize(stream, CompressedSize);
-		serialize(stream, UncompressedSize);
+
+		if (UseZip64)
+		{
+			serialize(stream, CompressedSize64);
+			serialize(stream, UncompressedSize64);
+		}
+		else
+		{
+			CompressedSize = Zip64ExtendedInformationExtraField::Saturate32(CompressedSize64);
+			UncompressedSize = Zip64ExtendedInformationExtraField::Saturate32(UncompressedSize64);
+
+			serialize(stream, CompressedSize);
+			serialize(stream, UncompressedSize);
+		}
 	}
 
 }
@@ -0,0 +1,145 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "methods/ZipMethodSelector.h"
+
+#include "Misc/Paths.h"
+
+#include "zlib.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// formats which carry compressed data already
+	const TCHAR* const StoredExtensions[] = {
+		TEXT("png"), TEXT("jpg"), TEXT("jpeg"), TEXT("gif"), TEXT("webp"), TEXT("heic"),
+		TEXT("ogg"), TEXT("opus"), TEXT("mp3"), TEXT("aac"), TEXT("m4a"), TEXT("flac"),
+		TEXT("mp4"), TEXT("m4v"), TEXT("mov"), TEXT("mkv"), TEXT("webm"), TEXT("bk2"),
+		TEXT("zip"), TEXT("7z"), TEXT("rar"), TEXT("gz"), TEXT("tgz"), TEXT("bz2"), TEXT("xz"), TEXT("zst"), TEXT("lz4"),
+		TEXT("jar"), TEXT("apk"), TEXT("ipa")
+	};
+
+	double GetEntropy(const uint8* data, size_t size)
+	{
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < size; i++)
+		{
+			histogram[data[i]]++;
+		}
+
+		double entropy = 0.0;
+		for (size_t count : histogram)
+		{
+			if (count != 0)
+			{
+				const double probability = static_cast<double>(count) / static_cast<double>(size);
+				entropy -= probability * std::log2(probability);
+			}
+		}
+
+		return entropy;
+	}
+
+	double GetCompressionRatio(const uint8* data, size_t size)
+	{
+		uLongf compressedSize = compressBound(static_cast<uLong>(size));
+		std::vector<Bytef> compressed(compressedSize);
+
+		if (compress2(compressed.data(), &compressedSize, data, static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK)
+		{
+			return 1.0;
+		}
+
+		return static_cast<double>(compressedSize) / static_cast<double>(size);
+	}
+}
+
+ZipMethodSelector::ZipMethodSelector(TSharedPtr<ICompressionMethod> method, TSharedPtr<ICompressionMethod> fastMethod)
+	: SampleSize(1 << 16)
+	, MaxEntropy(7.95)
+	, StoreRatio(0.97)
+	, FastRatio(0.9)
+	, _method(method)
+	, _fastMethod(fastMethod)
+	, _storeMethod(StoreMethod::Create())
+{
+	if (!_fastMethod.IsValid())
+	{
+		TSharedPtr<DeflateMethod> fastestDeflate = DeflateMethod::Create();
+		fastestDeflate->SetCompressionLevel(DeflateMethod::CompressionLevel::Fastest);
+		_fastMethod = fastestDeflate;
+	}
+
+	for (const TCHAR* extension : StoredExtensions)
+	{
+		_extensionPolicies.Add(extension, ExtensionPolicy::Store);
+	}
+}
+
+void ZipMethodSelector::SetExtensionPolicy(const FString& extension, ExtensionPolicy policy)
+{
+	_extensionPolicies.Add(extension.ToLower(), policy);
+}
+
+ZipMethodSelector::ExtensionPolicy ZipMethodSelector::GetExtensionPolicy(const FString& fileName) const
+{
+	const ExtensionPolicy* policy = _extensionPolicies.Find(FPaths::GetExtension(fileName).ToLower());
+	return policy != nullptr ? *policy : ExtensionPolicy::Sample;
+}
+
+TSharedPtr<ICompressionMethod> ZipMethodSelector::SelectMethod(const FString& fileName, std::istream& stream) const
+{
+	if (!this->NeedsSample(fileName))
+	{
+		return this->SelectMethod(fileName);
+	}
+
+	const auto position = stream.tellg();
+
+	if (position == std::istream::pos_type(-1))
+	{
+		return _method;
+	}
+
+	std::vector<char> sample(SampleSize);
+	stream.read(sample.data(), static_cast<std::streamsize>(sample.size()));
+	sample.resize(static_cast<size_t>(stream.gcount()));
+
+	stream.clear();
+	stream.seekg(position);
+
+	// too small to tell, the sizes in the headers cost more than the compression could save
+	if (sample.size() < 1024)
+	{
+		return _method;
+	}
+
+	const uint8* data = reinterpret_cast<const uint8*>(sample.data());
+
+	if (GetEntropy(data, sample.size()) > MaxEntropy)
+	{
+		return _storeMethod;
+	}
+
+	const double ratio = GetCompressionRatio(data, sample.size());
+
+	if (ratio > StoreRatio)
+	{
+		return _storeMethod;
+	}
+
+	return ratio > FastRatio ? _fastMethod : _method;
+}
+
+TSharedPtr<ICompressionMethod> ZipMethodSelector::SelectMethod(const FString& fileName) const
+{
+	return this->GetExtensionPolicy(fileName) == ExtensionPolicy::Store ? _storeMethod : _method;
+}
+
+bool ZipMethodSelector::NeedsSample(const FString& fileName) const
+{
+	// nothing to decide when the data are stored anyway
+	return this->GetExtensionPolicy(fileName) == ExtensionPolicy::Sample
+		&& _method->GetZipMethodDescriptor().GetCompressionMethod() != StoreMethod::CompressionMethod;
+}
@@ -0,0 +1,351 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/aes_utils.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#	define AES_X86_AESNI 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#	if defined(__GNUC__) || defined(__clang__)
+#		define AES_AESNI_TARGET __attribute__((target("aes,sse2")))
+#	else
+#		define AES_AESNI_TARGET
+#	endif
+#endif
+
+namespace {
+	inline uint8_t xtime(uint8_t value)
+	{
+		return uint8_t((value << 1) ^ ((value & 0x80) ? 0x1b : 0x00));
+	}
+
+	inline uint8_t rotl8(uint8_t value, int bits)
+	{
+		return uint8_t((value << bits) | (value >> (8 - bits)));
+	}
+
+	inline uint32_t rotr32(uint32_t value, int bits)
+	{
+		return (value >> bits) | (value << (32 - bits));
+	}
+
+	inline uint32_t load_be32(const uint8_t* data)
+	{
+		return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+	}
+
+	inline void store_be32(uint8_t* data, uint32_t value)
+	{
+		data[0] = uint8_t(value >> 24);
+		data[1] = uint8_t(value >> 16);
+		data[2] = uint8_t(value >> 8);
+		data[3] = uint8_t(value);
+	}
+
+	/**
+	 * \brief The S-box and the encryption round tables, computed once.
+	 */
+	struct aes_tables
+	{
+		aes_tables()
+		{
+			// walk the multiplicative group by 3 and its inverse by 3^-1 at the same time
+			uint8_t p = 1;
+			uint8_t q = 1;
+
+			do
+			{
+				p = uint8_t(p ^ xtime(p));
+
+				q ^= q << 1;
+				q ^= q << 2;
+				q ^= q << 4;
+				q = uint8_t(q ^ ((q & 0x80) ? 0x09 : 0x00));
+
+				SBox[p] = uint8_t(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63);
+			} while (p != 1);
+
+			SBox[0] = 0x63;
+
+			for (int i = 0; i < 256; i++)
+			{
+				uint8_t s = SBox[i];
+				uint8_t s2 = xtime(s);
+				uint8_t s3 = uint8_t(s2 ^ s);
+
+				Te[0][i] = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | uint32_t(s3);
+				Te[1][i] = rotr32(Te[0][i], 8);
+				Te[2][i] = rotr32(Te[0][i], 16);
+				Te[3][i] = rotr32(Te[0][i], 24);
+			}
+		}
+
+		uint8_t  SBox[256];
+		uint32_t Te[4][256];
+	};
+
+	const aes_tables& get_aes_tables()
+	{
+		static const aes_tables tables;
+		return tables;
+	}
+
+	void expand_key(const uint8_t* key, size_t keyLength, uint8_t* roundKeys, int rounds)
+	{
+		const aes_tables& tables = get_aes_tables();
+
+		const size_t keyWords = keyLength / 4;
+		const size_t totalWords = 4 * static_cast<size_t>(rounds + 1);
+
+		memcpy(roundKeys, key, keyLength);
+
+		uint8_t roundConstant = 1;
+		for (size_t i = keyWords; i < totalWords; i++)
+		{
+			uint8_t temp[4];
+			memcpy(temp, roundKeys + 4 * (i - 1), 4);
+
+			if (i % keyWords == 0)
+			{
+				uint8_t first = temp[0];
+				temp[0] = uint8_t(tables.SBox[temp[1]] ^ roundConstant);
+				temp[1] = tables.SBox[temp[2]];
+				temp[2] = tables.SBox[temp[3]];
+				temp[3] = tables.SBox[first];
+
+				roundConstant = xtime(roundConstant);
+			}
+			else if (keyWords > 6 && i % keyWords == 4)
+			{
+				for (uint8_t& b : temp)
+				{
+					b = tables.SBox[b];
+				}
+			}
+
+			for (int j = 0; j < 4; j++)
+			{
+				roundKeys[4 * i + j] = uint8_t(roundKeys[4 * (i - keyWords) + j] ^ temp[j]);
+			}
+		}
+	}
+
+	void encrypt_block(const uint8_t* roundKeys, int rounds, const uint8_t* input, uint8_t* output)
+	{
+		const aes_tables& tables = get_aes_tables();
+		const uint32_t(&te)[4][256] = tables.Te;
+
+		uint32_t s0 = load_be32(input + 0) ^ load_be32(roundKeys + 0);
+		uint32_t s1 = load_be32(input + 4) ^ load_be32(roundKeys + 4);
+		uint32_t s2 = load_be32(input + 8) ^ load_be32(roundKeys + 8);
+		uint32_t s3 = load_be32(input + 12) ^ load_be32(roundKeys + 12);
+
+		for (int round = 1; round < rounds; round++)
+		{
+			const uint8_t* rk = roundKeys + 16 * round;
+
+			uint32_t t0 = te[0][s0 >> 24] ^ te[1][(s1 >> 16) & 0xff] ^ te[2][(s2 >> 8) & 0xff] ^ te[3][s3 & 0xff] ^ load_be32(rk + 0);
+			uint32_t t1 = te[0][s1 >> 24] ^ te[1][(s2 >> 16) & 0xff] ^ te[2][(s3 >> 8) & 0xff] ^ te[3][s0 & 0xff] ^ load_be32(rk + 4);
+			uint32_t t2 = te[0][s2 >> 24] ^ te[1][(s3 >> 16) & 0xff] ^ te[2][(s0 >> 8) & 0xff] ^ te[3][s1 & 0xff] ^ load_be32(rk + 8);
+			uint32_t t3 = te[0][s3 >> 24] ^ te[1][(s0 >> 16) & 0xff] ^ te[2][(s1 >> 8) & 0xff] ^ te[3][s2 & 0xff] ^ load_be32(rk + 12);
+
+			s0 = t0;
+			s1 = t1;
+			s2 = t2;
+			s3 = t3;
+		}
+
+		// the last round has no MixColumns
+		const uint8_t* sbox = tables.SBox;
+		const uint8_t* rk = roundKeys + 16 * rounds;
+
+		store_be32(output + 0, ((uint32_t(sbox[s0 >> 24]) << 24) | (uint32_t(sbox[(s1 >> 16) & 0xff]) << 16) | (uint32_t(sbox[(s2 >> 8) & 0xff]) << 8) | uint32_t(sbox[s3 & 0xff])) ^ load_be32(rk + 0));
+		store_be32(output + 4, ((uint32_t(sbox[s1 >> 24]) << 24) | (uint32_t(sbox[(s2 >> 16) & 0xff]) << 16) | (uint32_t(sbox[(s3 >> 8) & 0xff]) << 8) | uint32_t(sbox[s0 & 0xff])) ^ load_be32(rk + 4));
+		store_be32(output + 8, ((uint32_t(sbox[s2 >> 24]) << 24) | (uint32_t(sbox[(s3 >> 16) & 0xff]) << 16) | (uint32_t(sbox[(s0 >> 8) & 0xff]) << 8) | uint32_t(sbox[s1 & 0xff])) ^ load_be32(rk + 8));
+		store_be32(output + 12, ((uint32_t(sbox[s3 >> 24]) << 24) | (uint32_t(sbox[(s0 >> 16) & 0xff]) << 16) | (uint32_t(sbox[(s1 >> 8) & 0xff]) << 8) | uint32_t(sbox[s2 & 0xff])) ^ load_be32(rk + 12));
+	}
+
+	inline void store_counter(uint8_t* block, uint64_t counter)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			block[i] = uint8_t(counter >> (8 * i));
+		}
+
+		memset(block + 8, 0, 8);
+	}
+
+	void generate_key_stream_portable(const uint8_t* roundKeys, int rounds, uint64_t& counter, uint8_t* keyStream, size_t blocks)
+	{
+		uint8_t block[utils::aes_ctr::BLOCK_SIZE];
+
+		for (size_t i = 0; i < blocks; i++)
+		{
+			store_counter(block, ++counter);
+			encrypt_block(roundKeys, rounds, block, keyStream + utils::aes_ctr::BLOCK_SIZE * i);
+		}
+	}
+
+#if defined(AES_X86_AESNI)
+	/**
+	 * \brief Encrypts 4 counter blocks at a time to keep the AES unit busy.
+	 */
+	AES_AESNI_TARGET void generate_key_stream_aesni(const uint8_t* roundKeys, int rounds, uint64_t& counter, uint8_t* keyStream, size_t blocks)
+	{
+		__m128i k[15];
+		for (int i = 0; i <= rounds; i++)
+		{
+			k[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys + 16 * i));
+		}
+
+		while (blocks >= 4)
+		{
+			__m128i b0 = _mm_xor_si128(_mm_set_epi64x(0, static_cast<long long>(counter + 1)), k[0]);
+			__m128i b1 = _mm_xor_si128(_mm_set_epi64x(0, static_cast<long long>(counter + 2)), k[0]);
+			__m128i b2 = _mm_xor_si128(_mm_set_epi64x(0, static_cast<long long>(counter + 3)), k[0]);
+			__m128i b3 = _mm_xor_si128(_mm_set_epi64x(0, static_cast<long long>(counter + 4)), k[0]);
+
+			for (int round = 1; round < rounds; round++)
+			{
+				b0 = _mm_aesenc_si128(b0, k[round]);
+				b1 = _mm_aesenc_si128(b1, k[round]);
+				b2 = _mm_aesenc_si128(b2, k[round]);
+				b3 = _mm_aesenc_si128(b3, k[round]);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(keyStream + 0x00), _mm_aesenclast_si128(b0, k[rounds]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(keyStream + 0x10), _mm_aesenclast_si128(b1, k[rounds]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(keyStream + 0x20), _mm_aesenclast_si128(b2, k[rounds]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(keyStream + 0x30), _mm_aesenclast_si128(b3, k[rounds]));
+
+			counter += 4;
+			keyStream += 0x40;
+			blocks -= 4;
+		}
+
+		while (blocks-- > 0)
+		{
+			__m128i b = _mm_xor_si128(_mm_set_epi64x(0, static_cast<long long>(++counter)), k[0]);
+
+			for (int round = 1; round < rounds; round++)
+			{
+				b = _mm_aesenc_si128(b, k[round]);
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(keyStream), _mm_aesenclast_si128(b, k[rounds]));
+			keyStream += 0x10;
+		}
+	}
+
+	bool has_aesni()
+	{
+		const unsigned int AESNI_BIT = 1 << 25;
+
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		unsigned int ecx = static_cast<unsigned int>(info[2]);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		{
+			return false;
+		}
+#endif
+
+		return (ecx & AESNI_BIT) != 0;
+	}
+#endif
+}
+
+namespace utils {
+
+	aes_ctr::aes_ctr()
+		: _rounds(0)
+		, _useAesNi(false)
+		, _counter(0)
+		, _keyStreamPosition(BLOCK_SIZE)
+	{
+
+	}
+
+	void aes_ctr::init(const uint8_t* key, size_t keyLength)
+	{
+		_rounds = static_cast<int>(keyLength / 4) + 6;
+		expand_key(key, keyLength, _roundKeys, _rounds);
+
+#if defined(AES_X86_AESNI)
+		static const bool hasAesNi = has_aesni();
+		_useAesNi = hasAesNi;
+#endif
+
+		_counter = 0;
+		_keyStreamPosition = BLOCK_SIZE;
+	}
+
+	void aes_ctr::transform(const uint8_t* input, uint8_t* output, size_t length)
+	{
+		// rest of the last block
+		while (length > 0 && _keyStreamPosition < BLOCK_SIZE)
+		{
+			*output++ = uint8_t(*input++ ^ _keyStream[_keyStreamPosition++]);
+			length--;
+		}
+
+		// whole blocks, in batches which stay in the cache
+		const size_t BATCH_BLOCKS = 64;
+		uint8_t keyStream[BLOCK_SIZE * BATCH_BLOCKS];
+
+		while (length >= BLOCK_SIZE)
+		{
+			size_t blocks = length / BLOCK_SIZE < BATCH_BLOCKS ? length / BLOCK_SIZE : BATCH_BLOCKS;
+			this->generate_key_stream(keyStream, blocks);
+
+			const size_t bytes = blocks * BLOCK_SIZE;
+			for (size_t i = 0; i < bytes; i += sizeof(uint64_t))
+			{
+				uint64_t data;
+				uint64_t key;
+				memcpy(&data, input + i, sizeof(data));
+				memcpy(&key, keyStream + i, sizeof(key));
+
+				data ^= key;
+				memcpy(output + i, &data, sizeof(data));
+			}
+
+			input += bytes;
+			output += bytes;
+			length -= bytes;
+		}
+
+		// start of a new block
+		if (length > 0)
+		{
+			this->generate_key_stream(_keyStream, 1);
+			_keyStreamPosition = 0;
+
+			while (length-- > 0)
+			{
+				*output++ = uint8_t(*input++ ^ _keyStream[_keyStreamPosition++]);
+			}
+		}
+	}
+
+	void aes_ctr::generate_key_stream(uint8_t* keyStream, size_t blocks)
+	{
+#if defined(AES_X86_AESNI)
+		if (_useAesNi)
+		{
+			generate_key_stream_aesni(_roundKeys, _rounds, _counter, keyStream, blocks);
+			return;
+		}
+#endif
+
+		generate_key_stream_portable(_roundKeys, _rounds, _counter, keyStream, blocks);
+	}
+}
@@ -0,0 +1,340 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/crc32_utils.h"
+#include <cstring>
+
+// CRC32_FORCE_PORTABLE=1 keeps the table kernel also where the instructions exist, to test and measure it
+#if defined(CRC32_FORCE_PORTABLE) && CRC32_FORCE_PORTABLE
+#elif defined(_M_X64) || defined(__x86_64__)
+#	define CRC32_X86_PCLMUL 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#	if defined(__GNUC__) || defined(__clang__)
+#		define CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#	else
+#		define CRC32_PCLMUL_TARGET
+#	endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#	define CRC32_ARMV8 1
+#	include <arm_acle.h>
+#	if defined(__ARM_FEATURE_CRC32) || defined(_MSC_VER)
+#		define CRC32_ARMV8_TARGET
+#	elif defined(__clang__)
+#		define CRC32_ARMV8_TARGET __attribute__((target("crc")))
+#	else
+#		define CRC32_ARMV8_TARGET __attribute__((target("+crc")))
+#	endif
+#	if defined(__linux__) && !defined(__ARM_FEATURE_CRC32)
+#		include <sys/auxv.h>
+#		ifndef HWCAP_CRC32
+#			define HWCAP_CRC32 (1 << 7)
+#		endif
+#	endif
+#endif
+
+namespace {
+	const uint32_t POLYNOMIAL = 0xedb88320;
+
+	typedef uint32_t(*update_function)(uint32_t, const uint8_t*, size_t);
+
+	/**
+	 * \brief Lookup tables of the slicing-by-8 kernel, table k advances a byte by k further zero bytes.
+	 */
+	struct slicing_tables
+	{
+		uint32_t table[8][256];
+
+		slicing_tables()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : (crc >> 1);
+				}
+
+				table[0][i] = crc;
+			}
+
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				for (int k = 1; k < 8; k++)
+				{
+					table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+				}
+			}
+		}
+	};
+
+	const slicing_tables& get_slicing_tables()
+	{
+		static const slicing_tables tables;
+		return tables;
+	}
+
+	/**
+	 * \brief Portable kernel, eight table lookups per 8 bytes instead of one per byte
+	 *        ("A Systematic Approach to Building High Performance Software-Based CRC Generators", Kounavis, Berry).
+	 */
+	uint32_t update_slicing_by_8(uint32_t crc, const uint8_t* data, size_t length)
+	{
+		const uint32_t (&table)[8][256] = get_slicing_tables().table;
+
+		crc = ~crc;
+
+		while (length >= 8)
+		{
+			// the bytes are taken one by one, the kernel does not depend on the byte order of the platform
+			const uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+
+			crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^ table[5][(low >> 16) & 0xff] ^ table[4][low >> 24]
+				^ table[3][data[4]] ^ table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+
+			data += 8;
+			length -= 8;
+		}
+
+		while (length-- > 0)
+		{
+			crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xff];
+		}
+
+		return ~crc;
+	}
+
+#if defined(CRC32_X86_PCLMUL)
+	/**
+	 * \brief Folds 64 bytes at a time with carry-less multiplication, then Barrett-reduces to 32 bits
+	 *        ("Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel).
+	 *        The length must be at least 64 and a multiple of 16, crc is the raw (non-inverted) register.
+	 */
+	CRC32_PCLMUL_TARGET uint32_t fold_pclmul(uint32_t crc, const uint8_t* data, size_t length)
+	{
+		const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+		const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+		const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+		const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+		const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+		__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+		__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+		__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+		__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+		__m128i x5;
+
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+
+		data += 64;
+		length -= 64;
+
+		// fold 4 x 128 bits in parallel
+		while (length >= 64)
+		{
+			__m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+			__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+			__m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+			x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+
+			x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+			x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+			x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+			x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+			x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+			x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+			x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+
+			data += 64;
+			length -= 64;
+		}
+
+		// fold into 128 bits
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+		// fold the remaining 16 byte blocks
+		while (length >= 16)
+		{
+			x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), x5);
+
+			data += 16;
+			length -= 16;
+		}
+
+		// fold 128 bits to 64 bits
+		x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+		x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, mask32);
+		x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		// Barrett reduction to 32 bits
+		x2 = _mm_and_si128(x1, mask32);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+		x2 = _mm_and_si128(x2, mask32);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+	}
+
+	uint32_t update_pclmul(uint32_t crc, const uint8_t* data, size_t length)
+	{
+		if (length >= 64)
+		{
+			size_t foldLength = length & ~static_cast<size_t>(15);
+			crc = ~fold_pclmul(~crc, data, foldLength);
+
+			data += foldLength;
+			length -= foldLength;
+		}
+
+		return update_slicing_by_8(crc, data, length);
+	}
+
+	bool has_pclmul()
+	{
+		const unsigned int PCLMUL_BIT = 1 << 1;
+		const unsigned int SSE41_BIT = 1 << 19;
+
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		unsigned int ecx = static_cast<unsigned int>(info[2]);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		{
+			return false;
+		}
+#endif
+
+		return (ecx & PCLMUL_BIT) != 0 && (ecx & SSE41_BIT) != 0;
+	}
+#endif
+
+#if defined(CRC32_ARMV8)
+	CRC32_ARMV8_TARGET uint32_t update_armv8(uint32_t crc, const uint8_t* data, size_t length)
+	{
+		crc = ~crc;
+
+		while (length >= 8)
+		{
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			crc = __crc32d(crc, value);
+
+			data += 8;
+			length -= 8;
+		}
+
+		while (length-- > 0)
+		{
+			crc = __crc32b(crc, *data++);
+		}
+
+		return ~crc;
+	}
+
+	bool has_armv8_crc32()
+	{
+#if defined(__ARM_FEATURE_CRC32) || defined(_MSC_VER)
+		// always present on Apple silicon and on Windows on ARM
+		return true;
+#elif defined(__linux__)
+		return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+		return false;
+#endif
+	}
+#endif
+
+	update_function select_update_function()
+	{
+#if defined(CRC32_X86_PCLMUL)
+		if (has_pclmul())
+		{
+			return &update_pclmul;
+		}
+#elif defined(CRC32_ARMV8)
+		if (has_armv8_crc32())
+		{
+			return &update_armv8;
+		}
+#endif
+
+		return &update_slicing_by_8;
+	}
+
+	/**
+	 * \brief a * b modulo the CRC polynomial, in the bit-reflected representation.
+	 */
+	uint32_t multiply_modulo(uint32_t a, uint32_t b)
+	{
+		uint32_t m = 1u << 31;
+		uint32_t p = 0;
+
+		while (m != 0)
+		{
+			if (a & m)
+			{
+				p ^= b;
+			}
+
+			m >>= 1;
+			b = (b & 1) ? (b >> 1) ^ POLYNOMIAL : (b >> 1);
+		}
+
+		return p;
+	}
+}
+
+namespace utils {
+
+	uint32_t crc32::update(uint32_t prevCrc32, const void* data, size_t length)
+	{
+		static const update_function update = select_update_function();
+
+		return update(prevCrc32, static_cast<const uint8_t*>(data), length);
+	}
+
+	uint32_t crc32::combine(uint32_t crc1, uint32_t crc2, uint64_t length2)
+	{
+		// x^(8 * length2) modulo the polynomial, by squaring x^(2^k)
+		uint32_t power = 1u << 30;   // x^1
+		uint32_t shift = 1u << 31;   // x^0
+
+		uint64_t bits = length2 * 8;
+		while (bits != 0)
+		{
+			if (bits & 1)
+			{
+				shift = multiply_modulo(power, shift);
+			}
+
+			power = multiply_modulo(power, power);
+			bits >>= 1;
+		}
+
+		return multiply_modulo(shift, crc1) ^ crc2;
+	}
+}
@@ -0,0 +1,232 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/sha1_utils.h"
+#include <cstring>
+
+namespace {
+	inline uint32_t rotl(uint32_t value, int bits)
+	{
+		return (value << bits) | (value >> (32 - bits));
+	}
+}
+
+namespace utils {
+
+	sha1::sha1()
+	{
+		this->reset();
+	}
+
+	void sha1::reset()
+	{
+		_state[0] = 0x67452301;
+		_state[1] = 0xefcdab89;
+		_state[2] = 0x98badcfe;
+		_state[3] = 0x10325476;
+		_state[4] = 0xc3d2e1f0;
+
+		_length = 0;
+		_bufferLength = 0;
+	}
+
+	void sha1::update(const void* data, size_t length)
+	{
+		const uint8_t* input = static_cast<const uint8_t*>(data);
+		_length += length;
+
+		if (_bufferLength > 0)
+		{
+			size_t toCopy = BLOCK_SIZE - _bufferLength < length ? BLOCK_SIZE - _bufferLength : length;
+			memcpy(_buffer + _bufferLength, input, toCopy);
+
+			_bufferLength += toCopy;
+			input += toCopy;
+			length -= toCopy;
+
+			if (_bufferLength < BLOCK_SIZE)
+			{
+				return;
+			}
+
+			this->transform(_buffer);
+			_bufferLength = 0;
+		}
+
+		// whole blocks are hashed right from the input
+		while (length >= BLOCK_SIZE)
+		{
+			this->transform(input);
+
+			input += BLOCK_SIZE;
+			length -= BLOCK_SIZE;
+		}
+
+		memcpy(_buffer, input, length);
+		_bufferLength = length;
+	}
+
+	void sha1::final(uint8_t digest[DIGEST_SIZE])
+	{
+		const uint64_t bitLength = _length * 8;
+
+		// padding: 0x80, zeros up to 56 mod 64, big-endian length in bits
+		uint8_t padding[BLOCK_SIZE + 8] = { 0x80 };
+		size_t paddingLength = (_bufferLength < 56 ? 56 : 120) - _bufferLength;
+
+		for (int i = 0; i < 8; i++)
+		{
+			padding[paddingLength + i] = uint8_t(bitLength >> (56 - 8 * i));
+		}
+
+		this->update(padding, paddingLength + 8);
+
+		for (int i = 0; i < 5; i++)
+		{
+			digest[4 * i + 0] = uint8_t(_state[i] >> 24);
+			digest[4 * i + 1] = uint8_t(_state[i] >> 16);
+			digest[4 * i + 2] = uint8_t(_state[i] >> 8);
+			digest[4 * i + 3] = uint8_t(_state[i]);
+		}
+	}
+
+	void sha1::transform(const uint8_t* block)
+	{
+		uint32_t w[80];
+
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) | (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+		}
+
+		for (int i = 16; i < 80; i++)
+		{
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = _state[0];
+		uint32_t b = _state[1];
+		uint32_t c = _state[2];
+		uint32_t d = _state[3];
+		uint32_t e = _state[4];
+
+		// one loop per round function, so the loops stay free of branches
+		uint32_t temp;
+		for (int i = 0; i < 20; i++)
+		{
+			temp = rotl(a, 5) + ((b & c) | (~b & d)) + e + 0x5a827999 + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+		}
+
+		for (int i = 20; i < 40; i++)
+		{
+			temp = rotl(a, 5) + (b ^ c ^ d) + e + 0x6ed9eba1 + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+		}
+
+		for (int i = 40; i < 60; i++)
+		{
+			temp = rotl(a, 5) + ((b & c) | (b & d) | (c & d)) + e + 0x8f1bbcdc + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+		}
+
+		for (int i = 60; i < 80; i++)
+		{
+			temp = rotl(a, 5) + (b ^ c ^ d) + e + 0xca62c1d6 + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+		}
+
+		_state[0] += a;
+		_state[1] += b;
+		_state[2] += c;
+		_state[3] += d;
+		_state[4] += e;
+	}
+
+	void hmac_sha1::init(const void* key, size_t keyLength)
+	{
+		uint8_t paddedKey[sha1::BLOCK_SIZE] = { 0 };
+
+		if (keyLength > sha1::BLOCK_SIZE)
+		{
+			sha1 keyHash;
+			keyHash.update(key, keyLength);
+			keyHash.final(paddedKey);
+		}
+		else
+		{
+			memcpy(paddedKey, key, keyLength);
+		}
+
+		uint8_t pad[sha1::BLOCK_SIZE];
+
+		for (size_t i = 0; i < sha1::BLOCK_SIZE; i++)
+		{
+			pad[i] = paddedKey[i] ^ 0x36;
+		}
+
+		_inner.reset();
+		_inner.update(pad, sizeof(pad));
+
+		for (size_t i = 0; i < sha1::BLOCK_SIZE; i++)
+		{
+			pad[i] = paddedKey[i] ^ 0x5c;
+		}
+
+		_outer.reset();
+		_outer.update(pad, sizeof(pad));
+	}
+
+	void hmac_sha1::update(const void* data, size_t length)
+	{
+		_inner.update(data, length);
+	}
+
+	void hmac_sha1::final(uint8_t digest[DIGEST_SIZE])
+	{
+		uint8_t innerDigest[DIGEST_SIZE];
+		_inner.final(innerDigest);
+
+		_outer.update(innerDigest, sizeof(innerDigest));
+		_outer.final(digest);
+	}
+
+	void hmac_sha1::pbkdf2(const void* password, size_t passwordLength, const void* salt, size_t saltLength,
+		uint32_t iterations, uint8_t* key, size_t keyLength)
+	{
+		// the pads are hashed once, every iteration starts from a copy
+		hmac_sha1 keyed;
+		keyed.init(password, passwordLength);
+
+		for (uint32_t blockIndex = 1; keyLength > 0; blockIndex++)
+		{
+			const uint8_t blockIndexBytes[4] = { uint8_t(blockIndex >> 24), uint8_t(blockIndex >> 16), uint8_t(blockIndex >> 8), uint8_t(blockIndex) };
+
+			uint8_t u[DIGEST_SIZE];
+			uint8_t t[DIGEST_SIZE];
+
+			hmac_sha1 hmac = keyed;
+			hmac.update(salt, saltLength);
+			hmac.update(blockIndexBytes, sizeof(blockIndexBytes));
+			hmac.final(u);
+			memcpy(t, u, sizeof(t));
+
+			for (uint32_t i = 1; i < iterations; i++)
+			{
+				hmac = keyed;
+				hmac.update(u, sizeof(u));
+				hmac.final(u);
+
+				for (size_t j = 0; j < DIGEST_SIZE; j++)
+				{
+					t[j] ^= u[j];
+				}
+			}
+
+			size_t toCopy = keyLength < DIGEST_SIZE ? keyLength : DIGEST_SIZE;
+			memcpy(key, t, toCopy);
+
+			key += toCopy;
+			keyLength -= toCopy;
+		}
+	}
+}
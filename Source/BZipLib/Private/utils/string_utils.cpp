@@ -0,0 +1,98 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/string_utils.h"
+
+namespace
+{
+	inline unsigned char fold_ascii(unsigned char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+	}
+}
+
+namespace utils {
+
+	std::string string::normalize_entry_name(const char* name)
+	{
+		std::string result;
+
+		if (name == nullptr)
+		{
+			return result;
+		}
+
+		// if slash is first char, skip it
+		while (*name == '/' || *name == '\\')
+		{
+			++name;
+		}
+
+		// collapse multiple slashes
+		bool prevWasSlash = false;
+		for (; *name != '\0'; ++name)
+		{
+			char c = (*name == '\\') ? '/' : *name;
+
+			if (c == '/' && prevWasSlash) continue;
+			prevWasSlash = (c == '/');
+
+			result += c;
+		}
+
+		return result;
+	}
+
+	size_t string::hash_entry_name(const std::string& name, bool ignoreCase)
+	{
+		return hash_entry_name(name.data(), name.length(), ignoreCase);
+	}
+
+	size_t string::hash_entry_name(const char* name, size_t length, bool ignoreCase)
+	{
+		// FNV-1a over the normalized name, see normalize_entry_name
+		size_t hash = static_cast<size_t>(14695981039346656037ULL);
+		size_t i = 0;
+
+		while (i < length && (name[i] == '/' || name[i] == '\\'))
+		{
+			++i;
+		}
+
+		bool prevWasSlash = false;
+		for (; i < length; ++i)
+		{
+			unsigned char c = (name[i] == '\\') ? '/' : static_cast<unsigned char>(name[i]);
+
+			if (c == '/' && prevWasSlash) continue;
+			prevWasSlash = (c == '/');
+
+			hash ^= ignoreCase ? fold_ascii(c) : c;
+			hash *= static_cast<size_t>(1099511628211ULL);
+		}
+
+		return hash;
+	}
+
+	bool string::equals_entry_name(const std::string& lhs, const std::string& rhs, bool ignoreCase)
+	{
+		if (lhs.length() != rhs.length())
+		{
+			return false;
+		}
+
+		if (!ignoreCase)
+		{
+			return lhs == rhs;
+		}
+
+		for (std::string::size_type i = 0; i < lhs.length(); ++i)
+		{
+			if (fold_ascii(static_cast<unsigned char>(lhs[i])) != fold_ascii(static_cast<unsigned char>(rhs[i])))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
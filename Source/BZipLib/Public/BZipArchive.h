@@ -4,19 +4,52 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
 #include "detail/EndOfCentralDirectoryBlock.h"
+#include "detail/Zip64EndOfCentralDirectoryBlock.h"
 #include "BZipArchiveEntry.h"
+#include "streams/streambuffs/positional_streambuf.h"
+#include "utils/string_utils.h"
+#include "HAL/CriticalSection.h"
 #include <istream>
+#include <string>
+#include <unordered_map>
 
 /**
  * \brief Represents a package of compressed files in the zip archive format.
+ *        The entries read the archive with positional reads, so streams of different entries,
+ *        or several streams opened by BZipArchiveEntry::OpenDecompressionStream on the same entry,
+ *        can be read from multiple threads at the same time. Archives created over a std::istream
+ *        serialize these reads on the stream. Looking up, adding and removing entries
+ *        and writing the archive are not synchronized.
  */
-class BZIPLIB_API BZipArchive
+class BZIPLIB_API BZipArchive : private positional_reader
 {
     friend class BZipFile;
     friend class BZipArchiveEntry;
 
 public:
+    /**
+     * \brief Values that represent the way the entries are loaded from the central directory.
+     */
+    enum class EntryLoadingMode
+    {
+        Eager,
+        Lazy
+    };
+
+    /**
+     * \brief Default size of the compressed data of an entry kept in the memory by the parallel WriteToStream.
+     */
+    static const uint64 DEFAULT_SPILL_THRESHOLD = 16 * 1024 * 1024;
+
+    /**
+     * \brief Largest input which the serial WriteToStream compresses aside, to store it instead when the compression
+     *        does not pay off. The larger inputs, and those whose method was picked by a ZipMethodSelector,
+     *        are compressed straight into the archive.
+     */
+    static const uint64 MAX_STORE_TRIAL_SIZE = DEFAULT_SPILL_THRESHOLD;
+
     /**
      * \brief Default constructor.
      */
@@ -32,9 +65,15 @@ public:
     /**
      * \brief Constructor.
      *
-     * \param stream The input stream of the zip archive content. Must be seekable.
+     * \param stream      The input stream of the zip archive content. Must be seekable.
+     * \param loadingMode (Optional) The way the entries are loaded.
+     *                    If eager mode is chosen, all entries are built when the archive is opened.
+     *
+     *                    If lazy mode is chosen, only the raw central directory is kept in the memory
+     *                    and the entries are built when they are accessed by GetEntry or RemoveEntry.
+     *                    It is recommended for huge archives of which only a few entries are used.
      */
-    static TSharedPtr<BZipArchive> Create(std::istream& stream);
+    static TSharedPtr<BZipArchive> Create(std::istream& stream, EntryLoadingMode loadingMode = EntryLoadingMode::Eager);
 
     /**
      * \brief Constructor. It optionally allows to simultaneously destroy and dealloc the input stream
@@ -42,8 +81,40 @@ public:
      *
      * \param stream                The input stream of the zip archive content. Must be seekable.
      * \param takeOwnership         If true, it calls "delete stream" in the BZipArchive destructor.
+     * \param loadingMode           (Optional) The way the entries are loaded, see above.
+     */
+    static TSharedPtr<BZipArchive> Create(std::istream* stream, bool takeOwnership, EntryLoadingMode loadingMode = EntryLoadingMode::Eager);
+
+    /**
+     * \brief Opens the zip archive file. Concurrent reads of the entries use a pool of file handles,
+     *        one for each thread reading at the same time, instead of serializing on a single stream.
+     *
+     * \param path        Full pathname of the zip archive file.
+     * \param loadingMode (Optional) The way the entries are loaded, see above.
+     *
+     * \return null if the file cannot be opened, else the BZipArchive instance.
+     */
+    static TSharedPtr<BZipArchive> CreateFromFile(const FString& path, EntryLoadingMode loadingMode = EntryLoadingMode::Eager);
+
+    /**
+     * \brief Constructor. Reads the zip archive directly from the memory, without any intermediate copies.
+     *        The memory must stay valid and unchanged for the lifetime of the BZipArchive.
+     *
+     * \param data        The zip archive content.
+     * \param loadingMode (Optional) The way the entries are loaded, see above.
+     */
+    static TSharedPtr<BZipArchive> CreateFromMemory(TArrayView<const uint8> data, EntryLoadingMode loadingMode = EntryLoadingMode::Eager);
+
+    /**
+     * \brief Opens the zip archive file mapped into the memory (mmap on Linux) and reads it like CreateFromMemory.
+     *        The mapping is released with the BZipArchive.
+     *
+     * \param path        Full pathname of the zip archive file.
+     * \param loadingMode (Optional) The way the entries are loaded, see above.
+     *
+     * \return null if the file cannot be mapped, else the BZipArchive instance.
      */
-    static TSharedPtr<BZipArchive> Create(std::istream* stream, bool takeOwnership);
+    static TSharedPtr<BZipArchive> OpenMapped(const FString& path, EntryLoadingMode loadingMode = EntryLoadingMode::Eager);
 
     /**
      * \brief Destructor.
@@ -100,6 +171,39 @@ public:
      */
     TSharedPtr<BZipArchiveEntry> GetEntry(const FString& entryName);
 
+    /**
+     * \brief Sets whether the entry names are compared case-insensitively by GetEntry, RemoveEntry and CreateEntry.
+     *        Only ASCII letters are folded. Enabled by default.
+     *
+     * \param ignoreCase If true, "Dir/File.txt" and "dir/file.TXT" name the same entry.
+     */
+    void SetIgnoreCaseInEntryNames(bool ignoreCase);
+
+    /**
+     * \brief Query if the entry names are compared case-insensitively.
+     *
+     * \return  true if the case is ignored, false if not.
+     */
+    bool IsIgnoringCaseInEntryNames() const;
+
+    /**
+     * \brief Sets whether WriteToStream compresses the byte-identical new entries only once.
+     *        The inputs are read ahead to find them, by their size and crc32, confirmed by SHA-1.
+     *        Every copy keeps its own local header, the compressed data of the first one are copied
+     *        for the others. The first copy decides the compression method and its properties.
+     *        The encrypted entries and the inputs which cannot seek are not deduplicated. Disabled by default.
+     *
+     * \param deduplicate If true, the identical entries are compressed once.
+     */
+    void SetEntryDeduplication(bool deduplicate);
+
+    /**
+     * \brief Query if WriteToStream compresses the identical entries once.
+     *
+     * \return  true if the entries are deduplicated, false if not.
+     */
+    bool IsDeduplicatingEntries() const;
+
     /**
      * \brief Gets the number of the zip entries in this archive.
      *
@@ -123,11 +227,29 @@ public:
 
     /**
      * \brief Writes the zip archive content to the stream. It must be seekable.
+     *        The new and changed entries up to MAX_STORE_TRIAL_SIZE are compressed into a buffer first,
+     *        so an entry whose compressed data would be larger than its input is stored instead.
+     *        The larger entries, and those whose method was picked by a ZipMethodSelector, are compressed
+     *        straight into the stream.
      *
      * \param stream The stream to write in.
      */
     void WriteToStream(std::ostream& stream);
 
+    /**
+     * \brief Writes the zip archive content to the stream, compressing the new and changed entries on multiple workers.
+     *        The workers compress the entries ahead of the writer into temporary buffers,
+     *        which continue in a temporary file shared by the entries once they exceed the spill threshold.
+     *        The writer then appends them in the order of the entries, so the output is the same as of the
+     *        single threaded WriteToStream. The compression runs at most a few entries per worker ahead.
+     *        The input streams are rewound after the compression, so the archive can be written again.
+     *
+     * \param stream          The stream to write in. It must be seekable.
+     * \param numWorkers      Number of entries compressed at the same time, 0 to use all the cores.
+     * \param spillThreshold  (Optional) Size of the compressed data of an entry kept in the memory, in bytes.
+     */
+    void WriteToStream(std::ostream& stream, int32 numWorkers, uint64 spillThreshold = DEFAULT_SPILL_THRESHOLD);
+
     /**
      * \brief Swaps this instance of BZipArchive with another instance.
      *
@@ -140,20 +262,92 @@ private:
     BZipArchive(const BZipArchive&);
     BZipArchive& operator = (const BZipArchive& other);
 
-    enum class SeekDirection
-    {
-        Forward,
-        Backward
-    };
+    void SetMemory(const uint8* data, uint64 size);
+    bool IsMemoryBacked() const;
+    const uint8* ReadBlock(uint64 offset, size_t size, TArray<uint8>& storage);
+
+    // positional_reader
+    size_t read_at(uint64_t offset, void* buffer, size_t size) override;
+    std::istream* AcquireReadHandle();
+    void ReleaseReadHandle(std::istream* handle);
+
+    void WriteCentralDirectory(std::ostream& stream, std::ios::pos_type startPosition);
+
+    // deduplication of the entries on write
+    struct DuplicateEntries;
+
+    void FindDuplicateEntries(DuplicateEntries& duplicates);
+    void WriteDuplicateEntry(int32 index, std::ostream& stream, DuplicateEntries& duplicates);
+
+    // writing while the entries are being added, the source adds the next entries once all the entries
+    // known so far are written, waiting for them if needed, and returns false when there are no more
+    void WriteToStreamSerially(std::ostream& stream, const TFunction<bool()>& addEntries);
+    void WriteToStreamInParallel(std::ostream& stream, int32 numWorkers, uint64 spillThreshold, const TFunction<bool()>& addEntries);
+    bool AddEntriesFromSource(const TFunction<bool()>& addEntries, DuplicateEntries& duplicates);
 
     bool EnsureCentralDirectoryRead();
+    void AddExistingEntry(detail::ZipCentralDirectoryFileHeader& cd);
+    void AddLazyEntries();
     bool ReadEndOfCentralDirectory();
-    bool SeekToSignature(uint32 signature, SeekDirection direction);
+    bool ReadZip64EndOfCentralDirectory(uint64 offsetOfEndOfCentralDirectory);
+
+    uint64 GetNumberOfEntriesInCentralDirectory() const;
+    uint64 GetSizeOfCentralDirectory() const;
+    uint64 GetOffsetOfCentralDirectory() const;
+
+    // name index, keyed on the normalized UTF-8 entry name
+    typedef std::unordered_map<std::string, BZipArchiveEntry*, utils::entry_name_hash, utils::entry_name_equal> EntryNameIndex;
+
+    BZipArchiveEntry* FindIndexedEntry(const std::string& normalizedName) const;
+    void IndexEntry(BZipArchiveEntry* entry);
+    void UnindexEntry(BZipArchiveEntry* entry, const std::string& name);
+    void ReindexEntry(BZipArchiveEntry* entry, const std::string& oldName);
+    void RebuildEntryNameIndex();
+    void AdoptEntries();
+
+    // lazy loading of the entries
+    struct LazyNameSlot
+    {
+        uint32 Hash;
+        uint32 RecordOffset;
+    };
+
+    TSharedPtr<BZipArchiveEntry> MaterializeEntry(int32 index);
+    void MaterializeAllEntries();
+    void RemoveLazyEntry(int32 index);
+    int32 FindLazyEntry(const std::string& normalizedName);
+    void BuildLazyNameTable();
+    void InsertIntoLazyNameTable(uint32 hash, uint32 recordOffset);
+    void RemoveFromLazyNameTable(uint32 recordOffset);
+    void ReleaseCentralDirectory();
 
     void InternalDestroy();
 
     detail::EndOfCentralDirectoryBlock _endOfCentralDirectoryBlock;
+    detail::Zip64EndOfCentralDirectoryBlock _zip64EndOfCentralDirectoryBlock;
+    bool _hasZip64EndOfCentralDirectory;
     TArray<TSharedPtr<BZipArchiveEntry>> _entries;
+    EntryNameIndex _entryNameIndex;
+    bool _hasDuplicateEntryNames;
+    bool _deduplicateEntries;
+
+    EntryLoadingMode _entryLoadingMode;
+    TArray<uint8> _centralDirectory;               //< storage of the raw central directory, unless it is in the memory of the archive
+    TArrayView<const uint8> _centralDirectoryView; //< raw central directory, kept while there are not materialized entries
+    TArray<uint32> _centralDirectoryRecordOffsets; //< offset of the record of each entry within _centralDirectory
+    TArray<LazyNameSlot> _lazyNameTable;           //< open addressing hash table of the not materialized entries
+    int32 _lazyEntriesCount;
     std::istream* _zipStream;
     bool _owningStream;
+
+    // positional reads
+    FString _filePath;                  //< path of the archive file, enables the pool of read handles
+    TArray<std::istream*> _readHandles; //< idle read handles of the archive file
+    FCriticalSection _readLock;         //< guards _readHandles, or _zipStream when there is no file path
+
+    // memory backed archives
+    TUniquePtr<IMappedFileHandle> _mappedFile;
+    TUniquePtr<IMappedFileRegion> _mappedRegion;
+    const uint8* _memoryData;
+    uint64 _memorySize;
 };
\ No newline at end of file
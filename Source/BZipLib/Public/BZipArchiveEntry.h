@@ -11,12 +11,18 @@
 #include "methods/ICompressionMethod.h"
 #include "methods/StoreMethod.h"
 #include "methods/DeflateMethod.h"
+#include "methods/ZipMethodSelector.h"
 
 #include "streams/substream.h"
+#include "streams/memstream.h"
+#include "streams/spillstream.h"
 #include "utils/enum_utils.h"
 
+#include "HAL/CriticalSection.h"
+
 #include <cstdint>
 #include <ctime>
+#include <fstream>
 #include <string>
 
 class BZipArchive;
@@ -39,6 +45,19 @@ public:
         Deferred
     };
 
+    /**
+     * \brief Values that represent the way the zip entry will be encrypted.
+     *        ZipCrypto is the traditional PKWARE encryption, which is weak, but readable by any zip tool.
+     *        The AES methods follow the WinZip AES (AE-2) specification.
+     */
+    enum class EncryptionMethod
+    {
+        ZipCrypto,
+        Aes128,
+        Aes192,
+        Aes256
+    };
+
     /**
      * \brief Values that represent the MS-DOS file attributes.
      */
@@ -61,6 +80,11 @@ public:
     MARK_AS_TYPED_ENUMFLAGS_FRIEND(Attributes);
     MARK_AS_TYPED_ENUMFLAGS_FRIEND(CompressionMode);
 
+    /**
+     * \brief Default memory shared by the compressed data of the entries compressed in the immediate mode.
+     */
+    static const uint64 DEFAULT_IMMEDIATE_MODE_MEMORY_BUDGET = 256 * 1024 * 1024;
+
     /**
      * \brief Destructor.
      */
@@ -132,6 +156,7 @@ public:
 
     /**
      * \brief Gets the compression method.
+     *        For the AES encrypted entries, it is the real method, not the 99 stored in the headers.
      *
      * \return  The compression method.
      */
@@ -161,10 +186,19 @@ public:
     /**
      * \brief Sets a password of the zip entry. If the password is empty string, the password is not set.
      *        Use before GetDecompressionStream or SetCompressionStream.
+     *        When reading, the encryption method is given by the entry, the parameter is used only for compression.
      *
-     * \param password  The password.
+     * \param password          The password.
+     * \param encryptionMethod  (Optional) The method of encryption.
      */
-    void SetPassword(const FString& password);
+    void SetPassword(const FString& password, EncryptionMethod encryptionMethod = EncryptionMethod::ZipCrypto);
+
+    /**
+     * \brief Gets the encryption method. Meaningful only if the entry is password protected.
+     *
+     * \return  The encryption method.
+     */
+    EncryptionMethod GetEncryptionMethod() const;
 
     /**
      * \brief Gets CRC 32 of the file.
@@ -239,8 +273,9 @@ public:
      *                The advantage of deferred compression mode is the compressed data needs not to be loaded
      *                into the memory, because they are streamed into the final output stream.
      *
-     *                If immediate mode is chosen, the data are compressed immediately into the memory buffer.
-     *                It is not recommended to use this method for large files.
+     *                If immediate mode is chosen, the data are compressed immediately into the memory buffer,
+     *                which moves to a temporary file when the memory budget of the immediate mode is exhausted,
+     *                see SetImmediateModeMemoryBudget.
      *                The advantage of immediate mode is the input stream can be destroyed (i.e. by scope)
      *                even before the BZipArchive::WriteToStream method is called.
      *
@@ -248,11 +283,58 @@ public:
      */
     bool SetCompressionStream(std::istream& stream, TSharedPtr<ICompressionMethod> method = DeflateMethod::Create(), CompressionMode mode = CompressionMode::Deferred);
 
+    /**
+     * \brief Sets the file whose data are compressed, in the deferred mode.
+     *        The file is opened only while its data are compressed, when the archive is written,
+     *        and closed right afterwards, so any number of such entries keeps only a few files open.
+     *        If the file cannot be opened then, the entry contains no data.
+     *
+     * \param filePath  Full pathname of the file.
+     * \param method    (Optional) The method of compression.
+     *
+     * \return  true if it succeeds, false if it fails.
+     */
+    bool SetCompressionFile(const FString& filePath, TSharedPtr<ICompressionMethod> method = DeflateMethod::Create());
+
+    /**
+     * \brief Sets the file whose data are compressed, in the deferred mode, by the method the selector picks.
+     *        A method which depends on the data is picked when the file is opened for the first time,
+     *        so the file is not opened just to sample them.
+     *
+     * \param filePath        Full pathname of the file.
+     * \param methodSelector  The selector, which may be shared by many entries.
+     *
+     * \return  true if it succeeds, false if it fails.
+     */
+    bool SetCompressionFile(const FString& filePath, TSharedPtr<const ZipMethodSelector> methodSelector);
+
+    /**
+     * \brief Whether the file set by SetCompressionFile could not be opened when the archive was written.
+     *        The entry then contains no data.
+     */
+    bool HasInputFileFailed() const;
+
     /**
      * \brief Sets compression stream to be null and unsets the password. The entry would contain no data with zero size.
      */
     void UnsetCompressionStream();
 
+    /**
+     * \brief Sets the memory shared by the compressed data of all the entries compressed in the immediate mode.
+     *        The data of an entry which do not fit any more are moved to a temporary file shared by the entries, created only then.
+     *        The entries compressed already keep their memory.
+     *
+     * \param budget  The budget in bytes, DEFAULT_IMMEDIATE_MODE_MEMORY_BUDGET by default.
+     */
+    static void SetImmediateModeMemoryBudget(uint64 budget);
+
+    /**
+     * \brief Gets the memory shared by the compressed data of all the entries compressed in the immediate mode.
+     *
+     * \return  The budget in bytes.
+     */
+    static uint64 GetImmediateModeMemoryBudget();
+
     /**
      * \brief Gets raw stream of the compressed data.
      *
@@ -268,6 +350,35 @@ public:
      */
     std::istream* GetDecompressionStream();
 
+    /**
+     * \brief Opens a new decompression stream, independent of GetDecompressionStream and of other opened streams.
+     *        Any number of these streams can be read at the same time, also from multiple threads.
+     *        The stream must be released before the owning BZipArchive is destroyed.
+     *        If the file is encrypted and correct password is not provided, it returns nullptr.
+     *
+     * \return  null if it fails, else the decompression stream.
+     */
+    TSharedPtr<std::istream> OpenDecompressionStream();
+
+    /**
+     * \brief Gets the raw compressed data directly in the memory of the archive, without any copy.
+     *        Available only for the entries of archives opened by BZipArchive::CreateFromMemory or BZipArchive::OpenMapped,
+     *        which were not changed since. The view is valid as long as the archive exists.
+     *
+     * \return  empty view if it fails, else the view of raw data.
+     */
+    TArrayView<const uint8> GetRawDataView();
+
+    /**
+     * \brief Gets the data of a stored (not compressed) and not encrypted entry directly in the memory of the archive,
+     *        without any copy. Requirements are the same as of GetRawDataView. CRC32 of the data is not verified.
+     *
+     * \param view [out] The view of the uncompressed data.
+     *
+     * \return  true if it succeeds, false if the data cannot be viewed in place.
+     */
+    bool TryGetStoredDataView(TArrayView<const uint8>& view);
+
     /**
      * \brief Query if the GetRawStream method has been already called.
      *
@@ -282,6 +393,16 @@ public:
      */
     bool IsDecompressionStreamOpened() const;
 
+    /**
+     * \brief Query if the data read from the stream of GetDecompressionStream are authentic.
+     *        Only the AES encrypted entries carry an authentication code, the stream of such an entry
+     *        ends before its last data if the code does not match. Call it once the stream has been read,
+     *        the encrypted data not read yet are skipped.
+     *
+     * \return  false if the authentication code does not match or no stream is opened, true otherwise.
+     */
+    bool AuthenticateDecompressionStream();
+
     /**
      * \brief Closes the raw stream, opened by GetRawStream.
      */
@@ -298,11 +419,13 @@ private:
     static const uint16 VERSION_NEEDED_DEFAULT = 10;
     static const uint16 VERSION_NEEDED_EXPLICIT_DIRECTORY = 20;
     static const uint16 VERSION_NEEDED_ZIP64 = 45;
+    static const uint16 VERSION_NEEDED_AES = 51;
 
     enum class BitFlag : uint16
     {
         None = 0,
         Encrypted = 1,
+        MethodOptions = 6,
         DataDescriptor = 8,
         UnicodeFileName = 0x800
     };
@@ -329,12 +452,13 @@ private:
     uint16 GetVersionMadeBy() const;
     void SetVersionMadeBy(uint16 value);
 
-    int32 GetOffsetOfLocalHeader() const;
-    void SetOffsetOfLocalHeader(int32 value);
+    uint64 GetOffsetOfLocalHeader() const;
+    void SetOffsetOfLocalHeader(uint64 value);
 
     bool HasCompressionStream() const;
 
     void FetchLocalFileHeader();
+    void OnFullNameChanged(const std::string& oldFilename);
     void CheckFilenameCorrection();
     void FixVersionToExtractAtLeast(uint16 value);
 
@@ -342,17 +466,40 @@ private:
     void SyncCDFH_with_LFH();
 
     std::ios::pos_type GetOffsetOfCompressedData();
-    std::ios::pos_type SeekToCompressedData();
+    const uint8* GetCompressedDataInMemory(uint64& length);
+    TSharedPtr<std::istream> OpenCompressedDataStream(mem_streambuf<char, std::char_traits<char>>** memoryStreambuf = nullptr);
+    TSharedPtr<std::istream> CreateDecompressionStream(TSharedPtr<std::istream>& archiveStream, TSharedPtr<std::istream>& encryptionStream, TSharedPtr<std::istream>& compressionStream);
+
+    bool NeedsZip64LocalFileHeader(std::istream* compressedDataStream, bool isCompressed);
+    void FixVersionToExtractForZip64(bool isZip64);
 
-    void SerializeLocalFileHeader(std::ostream& stream);
+    void SerializeLocalFileHeader(std::ostream& stream, std::istream* precompressedData = nullptr);
     void SerializeCentralDirectoryFileHeader(std::ostream& stream);
 
+    void ApplyCompressionMethod(TSharedPtr<ICompressionMethod> method);
     void UnloadCompressionData();
+    bool OpenInputFile();
+    void CloseInputFile();
     void InternalCompressStream(std::istream& inputStream, std::ostream& outputStream);
+    bool FallBackToStore(std::istream& inputStream, std::istream::pos_type inputPosition);
+    bool NeedsCompression() const;
+    bool CanFallBackToStore() const;
+    bool NeedsStoreTrial(uint64 maxInputSize);
+    void Precompress(spillstream& outputStream);
+    static spill_budget& GetImmediateModeBudget();
+    static const std::shared_ptr<spill_file>& GetImmediateModeSpillFile();
+    static std::shared_ptr<spill_file> CreateSpillFile();
+
+    // for deduplication
+    bool HashInput(uint64& size, uint32& crc32, uint8* sha1Digest);
+    void ShareCompressedData(const BZipArchiveEntry& original);
 
     // for encryption
-    void FigureCrc32();
     uint8 GetLastByteOfEncryptionHeader();
+    bool IsAesEncrypted() const;
+    size_t GetAesKeyLength() const;
+    size_t GetEncryptionOverhead() const;
+    void SyncEncryptionHeaders();
 
     //////////////////////////////////////////////////////////////////////////
     BZipArchive* _archive;           //< pointer to the owning zip archive
@@ -363,8 +510,11 @@ private:
     TSharedPtr<std::istream>   _archiveStream;     //< substream of owning zip archive file
 
     // internal compression data
-    TSharedPtr<std::iostream>  _immediateBuffer;   //< stream used in the immediate mode, stores compressed data in memory
+    TSharedPtr<spillstream>    _immediateBuffer;   //< stream used in the immediate mode, stores compressed data in memory or in a temporary file
     std::istream* _inputStream;       //< input stream
+    FString _inputFilePath;           //< file opened as the input stream only while it is compressed
+    TUniquePtr<std::ifstream> _inputFile;
+    TSharedPtr<const ZipMethodSelector> _methodSelector;   //< picks the method once the input file is opened
 
     TSharedPtr<ICompressionMethod>  _compressionMethod; //< compression method
     CompressionMode                 _compressionMode;   //< compression mode, either deferred or immediate
@@ -375,12 +525,16 @@ private:
     bool _originallyInArchive;
     bool _isNewOrChanged;
     bool _hasLocalFileHeader;
+    bool _hasInputFileFailed;
+    bool _isMethodSelected;          //< the method was picked by a ZipMethodSelector, it is not tried against the store
 
     detail::ZipLocalFileHeader _localFileHeader;
     detail::ZipCentralDirectoryFileHeader _centralDirectoryFileHeader;
 
     std::ios::pos_type _offsetOfCompressedData;
+    FCriticalSection _localFileHeaderLock; //< guards fetching of the local file header by concurrent streams
     std::ios::pos_type _offsetOfSerializedLocalFileHeader;
 
     FString _password;
+    EncryptionMethod _encryptionMethod;
 };
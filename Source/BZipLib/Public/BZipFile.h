@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "BZipArchive.h"
+#include "methods/ZipMethodSelector.h"
 #include <istream>
 
 /**
@@ -17,10 +18,12 @@ public:
      * \brief Opens the zip archive file with the given filename.
      *
      * \param ZipPath Full pathname of the zip file.
+     * \param LoadingMode (Optional) How the entries of the central directory are loaded,
+     *                    see BZipArchive::EntryLoadingMode.
      *
      * \return The BZipArchive instance.
      */
-    static bool Open(TSharedPtr<BZipArchive>& OutArchive, const FString& ZipPath, FString& ErrorMessage);
+    static bool Open(TSharedPtr<BZipArchive>& OutArchive, const FString& ZipPath, FString& ErrorMessage, BZipArchive::EntryLoadingMode LoadingMode = BZipArchive::EntryLoadingMode::Eager);
 
     /**
      * \brief Saves the zip archive file with the given filename.
@@ -37,8 +40,10 @@ public:
      *
      * \param BZipArchive  The zip archive to save.
      * \param ZipPath     Full pathname of the zip archive file.
+     * \param NumWorkers  (Optional) Number of entries compressed at the same time, 0 to use all the cores.
+     *                    See the parallel BZipArchive::WriteToStream.
      */
-    static bool SaveAndClose(TSharedPtr<BZipArchive>& ZArchive, const FString& ZipPath, FString& ErrorMessage);
+    static bool SaveAndClose(TSharedPtr<BZipArchive>& ZArchive, const FString& ZipPath, FString& ErrorMessage, int32 NumWorkers = 1);
 
     /**
      * \brief Checks if file with the given path is contained in the archive.
@@ -108,20 +113,32 @@ public:
 
     /**
      * \brief Extracts all files in the zip archive to the given directory.
+     *        With more workers, the entries are extracted on the task graph, largest first,
+     *        and every worker takes the next pending entry when it is done with its current one,
+     *        so a few huge entries do not stall the rest.
      *
      * \param ZipAbsolutePath               Full pathname of the zip file.
      * \param ExtractFolderAbsolutePath     Full pathname of the destination folder.
      * \param ErrorMessage                  Error message will be set to this.
+     * \param NumWorkers                    (Optional) Number of entries extracted at the same time, 0 to use all the cores.
      */
-	static bool ExtractAll(const FString& ZipAbsolutePath, const FString& ExtractFolderAbsolutePath, FString& ErrorMessage);
+	static bool ExtractAll(const FString& ZipAbsolutePath, const FString& ExtractFolderAbsolutePath, FString& ErrorMessage, int32 NumWorkers = 1);
 
     /**
      * \brief Compresses all files in the given directory to the given zip file path.
+     *        The files are written as the directory is walked, each of them opened only while it is compressed.
      *
      * \param InputFolderAbsolutePath       Full pathname of the source folder.
      * \param DestinationZipAbsolutePath    Full pathname of the destination zip file.
+     * \param NumWorkers                    (Optional) Number of files compressed at the same time, 0 to use all the cores.
+     *                                      The compressed files are still written in order by a single writer.
+     * \param MethodSelector                (Optional) Picks the method of every file, by default the compressed
+     *                                      formats are stored and the rest is deflated.
+     * \param bDeduplicate                  (Optional) Compresses the files with identical contents only once,
+     *                                      see BZipArchive::SetEntryDeduplication. The directory is then walked
+     *                                      to the end before the first file is written.
      */
-	static bool CompressAll(const FString& InputFolderAbsolutePath, const FString& DestinationZipAbsolutePath, FString& ErrorMessage);
+	static bool CompressAll(const FString& InputFolderAbsolutePath, const FString& DestinationZipAbsolutePath, FString& ErrorMessage, int32 NumWorkers = 1, const ZipMethodSelector& MethodSelector = ZipMethodSelector(), bool bDeduplicate = false);
 
     /**
      * \brief Extracts an encrypted file from the zip archive.
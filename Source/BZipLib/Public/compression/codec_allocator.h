@@ -0,0 +1,209 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/UnrealMemory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+LLM_DECLARE_TAG_API(BZipLib, BZIPLIB_API);
+
+/**
+ * \brief Allocator of the state and of the buffers of a codec, set by the Allocator of its properties.
+ *        Without one, the codecs use new[] and the allocator of the compression library.
+ */
+class codec_allocator_interface
+{
+public:
+	virtual ~codec_allocator_interface() { }
+
+	virtual void* allocate(size_t size) = 0;
+	virtual void deallocate(void* pointer) = 0;
+
+	/**
+	 * \brief The allocator used by one codec instance. The properties are shared by the codecs of
+	 *        several threads, so an allocator with state returns a new instance here.
+	 */
+	virtual TSharedPtr<codec_allocator_interface> create_for_codec() = 0;
+
+	/**
+	 * \brief Whether reset() releases all the memory at once, the codec then drops its state before,
+	 *        and allocates it again for every entry.
+	 */
+	virtual bool releases_on_reset() const { return false; }
+
+	/**
+	 * \brief Called by the codec when it starts a new entry.
+	 */
+	virtual void reset() { }
+
+	template <typename ELEM_TYPE>
+	static ELEM_TYPE* allocate_array(codec_allocator_interface* allocator, size_t count)
+	{
+		return allocator != nullptr
+			? static_cast<ELEM_TYPE*>(allocator->allocate(count * sizeof(ELEM_TYPE)))
+			: new ELEM_TYPE[count];
+	}
+
+	template <typename ELEM_TYPE>
+	static void deallocate_array(codec_allocator_interface* allocator, ELEM_TYPE* pointer)
+	{
+		if (allocator != nullptr)
+		{
+			allocator->deallocate(pointer);
+		}
+		else
+		{
+			delete[] pointer;
+		}
+	}
+
+	/**
+	 * \brief alloc_func and free_func of zlib, with the allocator as the opaque pointer.
+	 */
+	static void* zlib_alloc(void* opaque, unsigned int items, unsigned int size)
+	{
+		return static_cast<codec_allocator_interface*>(opaque)->allocate(static_cast<size_t>(items) * size);
+	}
+
+	static void zlib_free(void* opaque, void* address)
+	{
+		static_cast<codec_allocator_interface*>(opaque)->deallocate(address);
+	}
+};
+
+/**
+ * \brief Allocates through FMemory, tracked by the BZipLib tag of the low level memory tracker.
+ */
+class fmemory_codec_allocator : public codec_allocator_interface
+{
+public:
+	void* allocate(size_t size) override
+	{
+		LLM_SCOPE_BYTAG(BZipLib);
+		return FMemory::Malloc(size);
+	}
+
+	void deallocate(void* pointer) override
+	{
+		FMemory::Free(pointer);
+	}
+
+	TSharedPtr<codec_allocator_interface> create_for_codec() override
+	{
+		// no state, a new instance is as good as this one
+		return MakeShareable<codec_allocator_interface>(new fmemory_codec_allocator());
+	}
+};
+
+/**
+ * \brief Bump allocator, every codec gets an own arena which is reset between the entries.
+ *        Nothing is freed while an entry is processed, the blocks are kept for the next entries,
+ *        so compressing many entries does not allocate on the heap after the first ones.
+ */
+class arena_codec_allocator : public codec_allocator_interface
+{
+public:
+	enum : size_t
+	{
+		ALIGNMENT = 16
+	};
+
+	explicit arena_codec_allocator(size_t blockSize = 1 << 20)
+		: _blockSize(blockSize)
+		, _offset(0)
+	{
+
+	}
+
+	~arena_codec_allocator()
+	{
+		release_blocks();
+	}
+
+	void* allocate(size_t size) override
+	{
+		size = (size + ALIGNMENT - 1) & ~static_cast<size_t>(ALIGNMENT - 1);
+
+		if (_blocks.empty() || _offset + size > _blocks.back().Size)
+		{
+			add_block(std::max(size, _blockSize));
+		}
+
+		void* result = _blocks.back().Data + _offset;
+		_offset += size;
+
+		return result;
+	}
+
+	void deallocate(void* pointer) override
+	{
+		// released by reset()
+	}
+
+	TSharedPtr<codec_allocator_interface> create_for_codec() override
+	{
+		return MakeShareable<codec_allocator_interface>(new arena_codec_allocator(_blockSize));
+	}
+
+	bool releases_on_reset() const override
+	{
+		return true;
+	}
+
+	void reset() override
+	{
+		// merge the blocks, so the next entry of the same size fits in one
+		if (_blocks.size() > 1)
+		{
+			size_t totalSize = 0;
+			for (const block& b : _blocks)
+			{
+				totalSize += b.Size;
+			}
+
+			release_blocks();
+			add_block(totalSize);
+		}
+
+		_offset = 0;
+	}
+
+private:
+	struct block
+	{
+		uint8_t* Data;
+		size_t   Size;
+	};
+
+	void add_block(size_t size)
+	{
+		LLM_SCOPE_BYTAG(BZipLib);
+
+		block b;
+		b.Data = static_cast<uint8_t*>(FMemory::Malloc(size, ALIGNMENT));
+		b.Size = size;
+
+		_blocks.push_back(b);
+		_offset = 0;
+	}
+
+	void release_blocks()
+	{
+		for (const block& b : _blocks)
+		{
+			FMemory::Free(b.Data);
+		}
+
+		_blocks.clear();
+	}
+
+	size_t _blockSize;          //< minimal size of a block
+	size_t _offset;             //< first free byte of the last block
+	std::vector<block> _blocks;
+};
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <algorithm>
 
+#include "streams/streambuffs/mem_streambuf.h"
+
 struct compression_properties_interface
 {
 	virtual void normalize() = 0;
@@ -34,8 +36,8 @@ public:
 
 	virtual bool is_init() const = 0;
 
-	virtual size_t get_bytes_read() const = 0;
-	virtual size_t get_bytes_written() const = 0;
+	virtual uint64_t get_bytes_read() const = 0;
+	virtual uint64_t get_bytes_written() const = 0;
 
 	virtual ELEM_TYPE* get_buffer_begin() = 0;
 	virtual ELEM_TYPE* get_buffer_end() = 0;
@@ -64,6 +66,15 @@ public:
 	virtual void init(istream_type& stream) = 0;
 	virtual void init(istream_type& stream, compression_decoder_properties_interface& props) = 0;
 	virtual size_t decode_next() = 0;
+
+	/**
+	 * \brief Initializes the decoder with the input held by the memory stream buffer of the stream.
+	 *        The decoders which cannot read the memory in place read the stream as any other.
+	 */
+	virtual void init_in_memory(istream_type& stream, compression_decoder_properties_interface& props, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& memoryStreambuf)
+	{
+		init(stream, props);
+	}
 };
 
 typedef compression_interface_basic<uint8_t, std::char_traits<uint8_t>>           byte_compression_interface;
@@ -5,6 +5,8 @@
 
 #include "compression/deflate/deflate_decoder_properties.h"
 
+#include "streams/streambuffs/mem_streambuf.h"
+
 #include "zlib.h"
 
 #include <cstdint>
@@ -18,11 +20,14 @@ public:
 
 	basic_deflate_decoder()
 		: _lastError(Z_OK)
+		, _zstreamInitialized(false)
 		, _stream(nullptr)
+		, _memoryStreambuf(nullptr)
 		, _endOfStream(false)
 		, _bufferCapacity(0)
 		, _inputBufferSize(0)
 		, _outputBufferSize(0)
+		, _inputData(nullptr)
 		, _inputBuffer(nullptr)
 		, _outputBuffer(nullptr)
 		, _bytesRead(0)
@@ -33,11 +38,8 @@ public:
 
 	~basic_deflate_decoder()
 	{
-		if (is_init())
-		{
-			inflateEnd(&_zstream);
-			uninit_buffers();
-		}
+		uninit_zstream();
+		uninit_buffers();
 	}
 
 	void init(istream_type& stream) override
@@ -48,46 +50,26 @@ public:
 
 	void init(istream_type& stream, compression_decoder_properties_interface& props) override
 	{
-		// init stream
-		_stream = &stream;
-		_endOfStream = false;
-
-		// init values
-		_inputBufferSize = _outputBufferSize = 0;
-		_bytesRead = _bytesWritten = 0;
-
-		// init buffers
-		deflate_decoder_properties& deflateProps = static_cast<deflate_decoder_properties&>(props);
-		_bufferCapacity = deflateProps.BufferCapacity;
-
-		uninit_buffers();
-		_inputBuffer = new ELEM_TYPE[_bufferCapacity];
-		_outputBuffer = new ELEM_TYPE[_bufferCapacity];
-
-		// init deflate
-		_zstream.zalloc = nullptr;
-		_zstream.zfree = nullptr;
-		_zstream.opaque = nullptr;
-
-		_zstream.next_in = nullptr;
-		_zstream.next_out = nullptr;
-		_zstream.avail_in = 0;
-		_zstream.avail_out = uInt(-1); // force first load of data
+		init_stream(stream, props, nullptr);
+	}
 
-		inflateInit2(&_zstream, -MAX_WBITS);
+	void init_in_memory(istream_type& stream, compression_decoder_properties_interface& props, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& memoryStreambuf) override
+	{
+		// in-memory input is inflated in place, without copying into the input buffer
+		init_stream(stream, props, &memoryStreambuf);
 	}
 
 	bool is_init() const override
 	{
-		return (_inputBuffer != nullptr && _outputBuffer != nullptr);
+		return ((_inputBuffer != nullptr || _memoryStreambuf != nullptr) && _outputBuffer != nullptr);
 	}
 
-	size_t get_bytes_read() const override
+	uint64_t get_bytes_read() const override
 	{
 		return _bytesRead;
 	}
 
-	size_t get_bytes_written() const override
+	uint64_t get_bytes_written() const override
 	{
 		return _bytesWritten;
 	}
@@ -122,7 +104,7 @@ public:
 				read_next();
 
 				// set input buffer and its size
-				_zstream.next_in = reinterpret_cast<Bytef*>(_inputBuffer);
+				_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<ELEM_TYPE*>(_inputData));
 				_zstream.avail_in = static_cast<uInt>(_inputBufferSize);
 			}
 
@@ -164,21 +146,124 @@ public:
 	}
 
 private:
+	void init_stream(istream_type& stream, compression_decoder_properties_interface& props, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>* memoryStreambuf)
+	{
+		// init stream
+		_stream = &stream;
+		_endOfStream = false;
+		_memoryStreambuf = memoryStreambuf;
+
+		// init values
+		_inputBufferSize = _outputBufferSize = 0;
+		_bytesRead = _bytesWritten = 0;
+
+		// init buffers, a reused decoder keeps them
+		deflate_decoder_properties& deflateProps = static_cast<deflate_decoder_properties&>(props);
+		init_allocator(deflateProps.Allocator);
+		init_buffers(deflateProps.BufferCapacity);
+
+		// init inflate, a reused decoder only resets its state
+		if (_zstreamInitialized)
+		{
+			inflateReset(&_zstream);
+		}
+		else
+		{
+			_zstream.zalloc = _allocator != nullptr ? &codec_allocator_interface::zlib_alloc : nullptr;
+			_zstream.zfree = _allocator != nullptr ? &codec_allocator_interface::zlib_free : nullptr;
+			_zstream.opaque = _allocator.Get();
+
+			_zstream.next_in = nullptr;
+			_zstream.avail_in = 0;
+
+			_zstreamInitialized = zlib_suceeded(inflateInit2(&_zstream, -MAX_WBITS));
+		}
+
+		_zstream.next_in = nullptr;
+		_zstream.next_out = nullptr;
+		_zstream.avail_in = 0;
+		_zstream.avail_out = uInt(-1); // force first load of data
+	}
+
+	void init_allocator(const TSharedPtr<codec_allocator_interface>& allocator)
+	{
+		const bool allocatorChanged = allocator != _allocatorSource;
+
+		// the state and the buffers go back to the allocator they come from
+		if (allocatorChanged || (_allocator != nullptr && _allocator->releases_on_reset()))
+		{
+			uninit_zstream();
+			uninit_buffers();
+		}
+
+		if (allocatorChanged)
+		{
+			_allocatorSource = allocator;
+			_allocator = nullptr;
+
+			if (allocator != nullptr)
+			{
+				_allocator = allocator->create_for_codec();
+			}
+		}
+
+		if (_allocator != nullptr)
+		{
+			_allocator->reset();
+		}
+	}
+
+	void init_buffers(size_t bufferCapacity)
+	{
+		if (_bufferCapacity != bufferCapacity)
+		{
+			uninit_buffers();
+			_bufferCapacity = bufferCapacity;
+		}
+
+		// the input buffer is not needed for the in-memory input, but it is kept for the next use
+		if (_inputBuffer == nullptr && _memoryStreambuf == nullptr)
+		{
+			_inputBuffer = codec_allocator_interface::allocate_array<ELEM_TYPE>(_allocator.Get(), _bufferCapacity);
+		}
+
+		if (_outputBuffer == nullptr)
+		{
+			_outputBuffer = codec_allocator_interface::allocate_array<ELEM_TYPE>(_allocator.Get(), _bufferCapacity);
+		}
+	}
+
 	void uninit_buffers()
 	{
 		if (_inputBuffer != nullptr)
 		{
-			delete[] _inputBuffer;
+			codec_allocator_interface::deallocate_array(_allocator.Get(), _inputBuffer);
+			_inputBuffer = nullptr;
 		}
 
 		if (_outputBuffer != nullptr)
 		{
-			delete[] _outputBuffer;
+			codec_allocator_interface::deallocate_array(_allocator.Get(), _outputBuffer);
+			_outputBuffer = nullptr;
 		}
 	}
 
 	void read_next()
 	{
+		if (_memoryStreambuf != nullptr)
+		{
+			// hand the memory to zlib directly, the chunk must fit into avail_in
+			_inputData = _memoryStreambuf->get_read_pointer();
+			_inputBufferSize = std::min(_memoryStreambuf->get_read_available(), static_cast<size_t>(MAX_MEMORY_CHUNK_SIZE));
+			_memoryStreambuf->advance_read_pointer(_inputBufferSize);
+
+			_bytesRead += _inputBufferSize;
+			_endOfStream = _memoryStreambuf->get_read_available() == 0;
+			return;
+		}
+
+		_inputData = _inputBuffer;
+
 		// read next bytes from input stream
 		_stream->read(_inputBuffer, _bufferCapacity);
 
@@ -192,6 +277,15 @@ private:
 		_endOfStream = _inputBufferSize != _bufferCapacity;
 	}
 
+	void uninit_zstream()
+	{
+		if (_zstreamInitialized)
+		{
+			inflateEnd(&_zstream);
+			_zstreamInitialized = false;
+		}
+	}
+
 	bool zlib_suceeded(int errorCode)
 	{
 		// Z_BUF_ERROR just means zlib filled its output buffer without
@@ -201,18 +295,29 @@ private:
 
 	z_stream    _zstream;         // internal zlib structure
 	int         _lastError;       // last error of zlib operation
+	bool        _zstreamInitialized;
+
+	TSharedPtr<codec_allocator_interface> _allocatorSource;   // allocator of the properties
+	TSharedPtr<codec_allocator_interface> _allocator;         // own instance of the allocator
+
+	enum : size_t
+	{
+		MAX_MEMORY_CHUNK_SIZE = 1 << 30
+	};
 
 	istream_type* _stream;
+	mem_streambuf<ELEM_TYPE, TRAITS_TYPE>* _memoryStreambuf; // set if the input is in the memory
 	bool       _endOfStream;
 
 	size_t     _bufferCapacity;
 	size_t     _inputBufferSize;  // how many bytes are read in the input buffer
 	size_t     _outputBufferSize; // how many bytes are written in the output buffer
+	const ELEM_TYPE* _inputData;  // pointer to the input data, either the input buffer or the memory
 	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
 	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
 
-	size_t _bytesRead;
-	size_t _bytesWritten;
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
 };
 
 typedef basic_deflate_decoder<uint8_t, std::char_traits<uint8_t>>  byte_deflate_decoder;
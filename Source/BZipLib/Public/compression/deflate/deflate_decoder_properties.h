@@ -2,6 +2,7 @@
 
 #pragma once
 #include "compression/compression_interface.h"
+#include "compression/codec_allocator.h"
 
 struct deflate_decoder_properties : compression_decoder_properties_interface
 {
@@ -17,4 +18,6 @@ struct deflate_decoder_properties : compression_decoder_properties_interface
 	}
 
 	size_t BufferCapacity;
+
+	TSharedPtr<codec_allocator_interface> Allocator;   //< of the zlib state and the buffers, nullptr for malloc
 };
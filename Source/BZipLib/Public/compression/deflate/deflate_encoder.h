@@ -7,7 +7,15 @@
 
 #include "zlib.h"
 
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
 
 template <typename ELEM_TYPE, typename TRAITS_TYPE>
 class basic_deflate_encoder : public compression_encoder_interface_basic<ELEM_TYPE, TRAITS_TYPE>
@@ -18,23 +26,37 @@ public:
 
 	basic_deflate_encoder()
 		: _lastError(Z_OK)
+		, _zstreamInitialized(false)
 		, _stream(nullptr)
 		, _bufferCapacity(0)
 		, _inputBuffer(nullptr)
 		, _outputBuffer(nullptr)
 		, _bytesRead(0)
 		, _bytesWritten(0)
+		, _compressionLevel(6)
+		, _strategy(Z_DEFAULT_STRATEGY)
+		, _memLevel(8)
+		, _windowBits(MAX_WBITS)
+		, _autoStrategyTolerance(0.0)
+		, _zstreamLevel(0)
+		, _zstreamStrategy(Z_DEFAULT_STRATEGY)
+		, _zstreamMemLevel(8)
+		, _zstreamWindowBits(MAX_WBITS)
+		, _numThreads(1)
+		, _parallelBlockSize(0)
+		, _parallelFinished(false)
+		, _parallelFailed(false)
 	{
 
 	}
 
 	~basic_deflate_encoder()
 	{
-		if (is_init())
-		{
-			deflateEnd(&_zstream);
-			uninit_buffers();
-		}
+		// do not leave workers running on the buffers
+		wait_parallel_blocks(false);
+
+		uninit_zstream();
+		uninit_buffers();
 	}
 
 	void init(ostream_type& stream) override
@@ -51,25 +73,28 @@ public:
 		// init values
 		_bytesRead = _bytesWritten = 0;
 
-		// init buffers
+		// init buffers, a reused encoder keeps them
 		deflate_encoder_properties& deflateProps = static_cast<deflate_encoder_properties&>(props);
-		_bufferCapacity = deflateProps.BufferCapacity;
-
-		uninit_buffers();
-		_inputBuffer = new ELEM_TYPE[_bufferCapacity];
-		_outputBuffer = new ELEM_TYPE[_bufferCapacity];
-
-		// init deflate
-		_zstream.zalloc = nullptr;
-		_zstream.zfree = nullptr;
-		_zstream.opaque = nullptr;
-
-		_zstream.next_in = nullptr;
-		_zstream.next_out = nullptr;
-		_zstream.avail_in = 0;
-		_zstream.avail_out = 0;
-
-		deflateInit2(&_zstream, deflateProps.CompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+		init_allocator(deflateProps.Allocator);
+		init_buffers(deflateProps.BufferCapacity);
+
+		// init parallel compression
+		_compressionLevel = deflateProps.CompressionLevel;
+		_strategy = deflateProps.Strategy;
+		_memLevel = deflateProps.MemLevel;
+		_windowBits = deflateProps.WindowBits;
+		_autoStrategyTolerance = deflateProps.AutoStrategyTolerance;
+		_numThreads = deflateProps.NumThreads > 0 ? deflateProps.NumThreads : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+		_parallelBlockSize = deflateProps.ParallelBlockSize;
+		_parallelFinished = false;
+
+		wait_parallel_blocks(false);
+		_parallelFailed = false;
+		_blockInput.clear();
+		_dictionary.clear();
+
+		// init deflate, the auto strategy is chosen once the first input is known
+		init_zstream(_strategy == deflate_encoder_properties::AUTO_STRATEGY ? Z_DEFAULT_STRATEGY : _strategy);
 	}
 
 	bool is_init() const override
@@ -77,12 +102,12 @@ public:
 		return _stream != nullptr;
 	}
 
-	size_t get_bytes_read() const override
+	uint64_t get_bytes_read() const override
 	{
 		return _bytesRead;
 	}
 
-	size_t get_bytes_written() const override
+	uint64_t get_bytes_written() const override
 	{
 		return _bytesWritten;
 	}
@@ -99,6 +124,22 @@ public:
 
 	void encode_next(size_t length) override
 	{
+		if (_strategy == deflate_encoder_properties::AUTO_STRATEGY)
+		{
+			_strategy = choose_strategy(_inputBuffer, length);
+
+			if (_strategy != _zstreamStrategy && _numThreads <= 1)
+			{
+				init_zstream(_strategy);
+			}
+		}
+
+		if (_numThreads > 1)
+		{
+			encode_next_parallel(length);
+			return;
+		}
+
 		// set the input buffer
 		_zstream.next_in = reinterpret_cast<Bytef*>(_inputBuffer);
 		_zstream.avail_in = static_cast<uInt>(length);
@@ -132,16 +173,391 @@ public:
 	}
 
 private:
+	/**
+	 * \brief Input block compressed on a worker thread, and its compressed output.
+	 */
+	struct parallel_block
+	{
+		parallel_block()
+			: IsLast(false)
+			, Succeeded(false)
+			, IsClaimed(false)
+		{
+
+		}
+
+		/**
+		 * \brief Whether the caller is the one to compress the block, either the pool task or the encoder waiting for it.
+		 */
+		bool claim()
+		{
+			return !IsClaimed.exchange(true);
+		}
+
+		std::vector<ELEM_TYPE> Input;
+		std::vector<ELEM_TYPE> Dictionary;   //< last 32 KB of the previous block
+		std::vector<ELEM_TYPE> Output;
+		bool IsLast;
+		bool Succeeded;
+		std::atomic<bool> IsClaimed;
+		TFuture<void> Done;
+	};
+
+	enum : size_t
+	{
+		DICTIONARY_SIZE = 1 << 15
+	};
+
+	/**
+	 * \brief pigz-style encoding: the input is cut into blocks, which are compressed at the same time,
+	 *        each one primed with the end of the previous block. Every block but the last one ends
+	 *        on a byte boundary by a sync flush, so the blocks concatenate to one deflate stream.
+	 */
+	void encode_next_parallel(size_t length)
+	{
+		if (_parallelFinished)
+		{
+			return;
+		}
+
+		_bytesRead += length;
+
+		bool flush = length < _bufferCapacity;
+
+		ELEM_TYPE* input = _inputBuffer;
+		while (length > 0)
+		{
+			size_t toCopy = std::min(length, _parallelBlockSize - _blockInput.size());
+			_blockInput.insert(_blockInput.end(), input, input + toCopy);
+
+			input += toCopy;
+			length -= toCopy;
+
+			if (_blockInput.size() == _parallelBlockSize)
+			{
+				submit_parallel_block(false);
+			}
+		}
+
+		if (flush)
+		{
+			submit_parallel_block(true);
+			wait_parallel_blocks(true);
+
+			_parallelFinished = true;
+		}
+	}
+
+	void submit_parallel_block(bool isLast)
+	{
+		std::shared_ptr<parallel_block> block = std::make_shared<parallel_block>();
+		block->Input.swap(_blockInput);
+		block->Dictionary = _dictionary;
+		block->IsLast = isLast;
+
+		// the next block continues with the end of this one
+		size_t dictionarySize = std::min<size_t>(block->Input.size(), DICTIONARY_SIZE);
+		_dictionary.assign(block->Input.end() - dictionarySize, block->Input.end());
+
+		_blockInput.reserve(_parallelBlockSize);
+
+		// the task keeps the block alive, it may run only after the encoder has compressed the block itself
+		const int compressionLevel = _compressionLevel;
+		const int strategy = _strategy;
+		const int memLevel = _memLevel;
+		const int windowBits = _windowBits;
+		block->Done = Async(EAsyncExecution::ThreadPool, [block, compressionLevel, strategy, memLevel, windowBits]()
+		{
+			if (block->claim())
+			{
+				block->Succeeded = compress_block(*block, compressionLevel, strategy, memLevel, windowBits);
+			}
+		});
+
+		_pendingBlocks.push_back(block);
+
+		// keep only as many blocks in flight as there are threads
+		while (_pendingBlocks.size() > static_cast<size_t>(_numThreads))
+		{
+			write_front_block(true);
+		}
+	}
+
+	static bool compress_block(parallel_block& block, int compressionLevel, int strategy, int memLevel, int windowBits)
+	{
+		z_stream zstream;
+		zstream.zalloc = nullptr;
+		zstream.zfree = nullptr;
+		zstream.opaque = nullptr;
+
+		if (deflateInit2(&zstream, compressionLevel, Z_DEFLATED, -windowBits, memLevel, strategy) != Z_OK)
+		{
+			return false;
+		}
+
+		if (!block.Dictionary.empty())
+		{
+			deflateSetDictionary(&zstream, reinterpret_cast<const Bytef*>(block.Dictionary.data()), static_cast<uInt>(block.Dictionary.size()));
+		}
+
+		zstream.next_in = reinterpret_cast<Bytef*>(block.Input.data());
+		zstream.avail_in = static_cast<uInt>(block.Input.size());
+
+		// sync flush adds an empty stored block, leave room for it
+		block.Output.resize(deflateBound(&zstream, static_cast<uLong>(block.Input.size())) + 16);
+
+		size_t have = 0;
+		int result;
+		do {
+			if (have == block.Output.size())
+			{
+				block.Output.resize(block.Output.size() * 2);
+			}
+
+			zstream.next_out = reinterpret_cast<Bytef*>(block.Output.data() + have);
+			zstream.avail_out = static_cast<uInt>(block.Output.size() - have);
+
+			result = deflate(&zstream, block.IsLast ? Z_FINISH : Z_SYNC_FLUSH);
+
+			have = block.Output.size() - static_cast<size_t>(zstream.avail_out);
+		} while (zstream.avail_out == 0 || (block.IsLast && result == Z_OK));
+
+		block.Output.resize(have);
+
+		deflateEnd(&zstream);
+		return true;
+	}
+
+	void write_front_block(bool writeOutput)
+	{
+		std::shared_ptr<parallel_block> block = _pendingBlocks.front();
+		_pendingBlocks.pop_front();
+
+		// the task may still be queued behind the tasks of the thread pool, or this very thread
+		// might be one of them, so the block is compressed here rather than waited for
+		if (block->claim())
+		{
+			block->Succeeded = writeOutput && compress_block(*block, _compressionLevel, _strategy, _memLevel, _windowBits);
+		}
+		else
+		{
+			block->Done.Wait();
+		}
+
+		// the task holds the block, the block must not hold the task
+		block->Done = TFuture<void>();
+
+		if (!writeOutput || _parallelFailed)
+		{
+			return;
+		}
+
+		// the blocks after a failed one would not continue its stream, the output is marked bad instead
+		if (!block->Succeeded)
+		{
+			_parallelFailed = true;
+			_lastError = Z_MEM_ERROR;
+			_stream->setstate(std::ios::badbit);
+			return;
+		}
+
+		if (!block->Output.empty())
+		{
+			_stream->write(block->Output.data(), block->Output.size());
+			_bytesWritten += block->Output.size();
+		}
+	}
+
+	void wait_parallel_blocks(bool writeOutput)
+	{
+		while (!_pendingBlocks.empty())
+		{
+			write_front_block(writeOutput);
+		}
+	}
+
+	void init_zstream(int strategy)
+	{
+		// zlib before 1.2.12 cannot change the parameters of a reset stream reliably,
+		// and the window and the memory level are fixed for the life of the stream
+		if (_zstreamInitialized
+			&& (_zstreamLevel != _compressionLevel || _zstreamStrategy != strategy || _zstreamMemLevel != _memLevel || _zstreamWindowBits != _windowBits))
+		{
+			uninit_zstream();
+		}
+
+		// a reused encoder only resets its state
+		if (_zstreamInitialized)
+		{
+			deflateReset(&_zstream);
+		}
+		else
+		{
+			_zstream.zalloc = _allocator != nullptr ? &codec_allocator_interface::zlib_alloc : nullptr;
+			_zstream.zfree = _allocator != nullptr ? &codec_allocator_interface::zlib_free : nullptr;
+			_zstream.opaque = _allocator.Get();
+
+			_zstreamInitialized = zlib_suceeded(deflateInit2(&_zstream, _compressionLevel, Z_DEFLATED, -_windowBits, _memLevel, strategy));
+
+			_zstreamLevel = _compressionLevel;
+			_zstreamStrategy = strategy;
+			_zstreamMemLevel = _memLevel;
+			_zstreamWindowBits = _windowBits;
+		}
+
+		_zstream.next_in = nullptr;
+		_zstream.next_out = nullptr;
+		_zstream.avail_in = 0;
+		_zstream.avail_out = 0;
+	}
+
+	/**
+	 * \brief Picks the fastest strategy which compresses the sample at most AutoStrategyTolerance worse than the default one.
+	 *        Text is left to the default strategy, runs and zeros are tried with Z_RLE,
+	 *        the other binary data with Z_HUFFMAN_ONLY and Z_RLE.
+	 */
+	int choose_strategy(const ELEM_TYPE* data, size_t length) const
+	{
+		const uint8_t* sample = reinterpret_cast<const uint8_t*>(data);
+		const size_t sampleSize = length * sizeof(ELEM_TYPE);
+
+		if (sampleSize == 0)
+		{
+			return Z_DEFAULT_STRATEGY;
+		}
+
+		size_t textBytes = 0;
+		size_t repeatedBytes = 0;
+		for (size_t i = 0; i < sampleSize; i++)
+		{
+			const uint8_t c = sample[i];
+
+			if ((c >= 0x20 && c < 0x7f) || c == '\t' || c == '\n' || c == '\r')
+			{
+				textBytes++;
+			}
+
+			if (i > 0 && c == sample[i - 1])
+			{
+				repeatedBytes++;
+			}
+		}
+
+		// text repeats strings far behind, only the matching of the default strategy finds them
+		if (textBytes >= sampleSize * 95 / 100)
+		{
+			return Z_DEFAULT_STRATEGY;
+		}
+
+		const bool isSparse = repeatedBytes >= sampleSize / 2;
+
+		const size_t defaultSize = get_compressed_size(sample, sampleSize, Z_DEFAULT_STRATEGY);
+		const size_t maximalSize = defaultSize + static_cast<size_t>(static_cast<double>(defaultSize) * _autoStrategyTolerance);
+
+		// fastest first, the huffman coding alone does not shorten the runs
+		if (!isSparse && get_compressed_size(sample, sampleSize, Z_HUFFMAN_ONLY) <= maximalSize)
+		{
+			return Z_HUFFMAN_ONLY;
+		}
+
+		if (get_compressed_size(sample, sampleSize, Z_RLE) <= maximalSize)
+		{
+			return Z_RLE;
+		}
+
+		return Z_DEFAULT_STRATEGY;
+	}
+
+	size_t get_compressed_size(const uint8_t* data, size_t size, int strategy) const
+	{
+		z_stream zstream;
+		zstream.zalloc = nullptr;
+		zstream.zfree = nullptr;
+		zstream.opaque = nullptr;
+
+		if (deflateInit2(&zstream, _compressionLevel, Z_DEFLATED, -_windowBits, _memLevel, strategy) != Z_OK)
+		{
+			return size;
+		}
+
+		std::vector<uint8_t> output(deflateBound(&zstream, static_cast<uLong>(size)));
+
+		zstream.next_in = const_cast<Bytef*>(data);
+		zstream.avail_in = static_cast<uInt>(size);
+		zstream.next_out = output.data();
+		zstream.avail_out = static_cast<uInt>(output.size());
+
+		deflate(&zstream, Z_FINISH);
+
+		const size_t compressedSize = static_cast<size_t>(zstream.total_out);
+		deflateEnd(&zstream);
+
+		return compressedSize;
+	}
+
+	void init_allocator(const TSharedPtr<codec_allocator_interface>& allocator)
+	{
+		const bool allocatorChanged = allocator != _allocatorSource;
+
+		// the state and the buffers go back to the allocator they come from
+		if (allocatorChanged || (_allocator != nullptr && _allocator->releases_on_reset()))
+		{
+			uninit_zstream();
+			uninit_buffers();
+		}
+
+		if (allocatorChanged)
+		{
+			_allocatorSource = allocator;
+			_allocator = nullptr;
+
+			if (allocator != nullptr)
+			{
+				_allocator = allocator->create_for_codec();
+			}
+		}
+
+		if (_allocator != nullptr)
+		{
+			_allocator->reset();
+		}
+	}
+
+	void init_buffers(size_t bufferCapacity)
+	{
+		if (_inputBuffer != nullptr && _bufferCapacity == bufferCapacity)
+		{
+			return;
+		}
+
+		uninit_buffers();
+
+		_bufferCapacity = bufferCapacity;
+		_inputBuffer = codec_allocator_interface::allocate_array<ELEM_TYPE>(_allocator.Get(), _bufferCapacity);
+		_outputBuffer = codec_allocator_interface::allocate_array<ELEM_TYPE>(_allocator.Get(), _bufferCapacity);
+	}
+
 	void uninit_buffers()
 	{
 		if (_inputBuffer != nullptr)
 		{
-			delete[] _inputBuffer;
+			codec_allocator_interface::deallocate_array(_allocator.Get(), _inputBuffer);
+			_inputBuffer = nullptr;
 		}
 
 		if (_outputBuffer != nullptr)
 		{
-			delete[] _outputBuffer;
+			codec_allocator_interface::deallocate_array(_allocator.Get(), _outputBuffer);
+			_outputBuffer = nullptr;
+		}
+	}
+
+	void uninit_zstream()
+	{
+		if (_zstreamInitialized)
+		{
+			deflateEnd(&_zstream);
+			_zstreamInitialized = false;
 		}
 	}
 
@@ -152,6 +568,10 @@ private:
 
 	z_stream    _zstream;         // internal zlib structure
 	int         _lastError;       // last error of zlib operation
+	bool        _zstreamInitialized;
+
+	TSharedPtr<codec_allocator_interface> _allocatorSource;   // allocator of the properties
+	TSharedPtr<codec_allocator_interface> _allocator;         // own instance of the allocator
 
 	ostream_type* _stream;
 
@@ -159,8 +579,28 @@ private:
 	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
 	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
 
-	size_t _bytesRead;
-	size_t _bytesWritten;
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
+
+	int    _compressionLevel;
+	int    _strategy;           // AUTO_STRATEGY until the first input is sampled
+	int    _memLevel;
+	int    _windowBits;
+	double _autoStrategyTolerance;
+
+	int    _zstreamLevel;       // parameters the zlib stream was created with
+	int    _zstreamStrategy;
+	int    _zstreamMemLevel;
+	int    _zstreamWindowBits;
+
+	int    _numThreads;
+	size_t _parallelBlockSize;
+	bool   _parallelFinished;
+	bool   _parallelFailed;     // a block could not be compressed, nothing more is written
+
+	std::vector<ELEM_TYPE> _blockInput;   // input of the block being filled
+	std::vector<ELEM_TYPE> _dictionary;   // end of the last submitted block
+	std::deque<std::shared_ptr<parallel_block>> _pendingBlocks;
 };
 
 typedef basic_deflate_encoder<uint8_t, std::char_traits<uint8_t>>  byte_deflate_encoder;
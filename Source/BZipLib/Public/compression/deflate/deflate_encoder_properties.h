@@ -2,14 +2,26 @@
 
 #pragma once
 #include "compression/compression_interface.h"
+#include "compression/codec_allocator.h"
 
 #include <algorithm>
 
 struct deflate_encoder_properties : compression_encoder_properties_interface
 {
+	enum : int
+	{
+		AUTO_STRATEGY = -1   //< the strategy is chosen by the encoder, see AutoStrategyTolerance
+	};
+
 	deflate_encoder_properties()
 		: BufferCapacity(1 << 15)
 		, CompressionLevel(6)
+		, NumThreads(1)
+		, ParallelBlockSize(1 << 20)
+		, Strategy(0)
+		, MemLevel(8)
+		, WindowBits(15)
+		, AutoStrategyTolerance(0.05)
 	{
 
 	}
@@ -17,8 +29,26 @@ struct deflate_encoder_properties : compression_encoder_properties_interface
 	void normalize() override
 	{
 		CompressionLevel = clamp(0, 9, CompressionLevel);
+		Strategy = clamp(static_cast<int>(AUTO_STRATEGY), 4, Strategy);
+		MemLevel = clamp(1, 9, MemLevel);
+
+		// the raw deflate does not support the window of 256 bytes
+		WindowBits = clamp(9, 15, WindowBits);
+		AutoStrategyTolerance = std::max(0.0, AutoStrategyTolerance);
+		NumThreads = std::max(0, NumThreads);
+
+		// a block has to be larger than the dictionary it passes to the next one
+		ParallelBlockSize = std::max<size_t>(ParallelBlockSize, 1 << 16);
 	}
 
 	size_t BufferCapacity;
 	int    CompressionLevel;
+	int    NumThreads;          //< number of blocks compressed at the same time, 0 to use all the cores
+	size_t ParallelBlockSize;   //< size of the input blocks when NumThreads is not 1
+	int    Strategy;            //< Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED or AUTO_STRATEGY
+	int    MemLevel;            //< memory of the internal compression state, 1 to 9
+	int    WindowBits;          //< base two logarithm of the window size, 9 to 15
+	double AutoStrategyTolerance;   //< how much larger the sample may get with a faster strategy than with the default one
+
+	TSharedPtr<codec_allocator_interface> Allocator;   //< of the zlib state and the buffers, nullptr for malloc
 };
@@ -0,0 +1,270 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include "compression/lzma/lzma_decoder_properties.h"
+
+#include "lzma.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * \brief Decoder of the zip method 14, see basic_lzma_encoder.
+ *        The data may end by the EOS marker, or just by the end of the compressed data.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_lzma_decoder : public compression_decoder_interface_basic<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::istream_type istream_type;
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::ostream_type ostream_type;
+
+	enum : size_t
+	{
+		HEADER_SIZE = 4,
+		MAX_PROPERTIES_SIZE = 5
+	};
+
+	basic_lzma_decoder()
+		: _lzmaStream(LZMA_STREAM_INIT)
+		, _lastError(LZMA_OK)
+		, _stream(nullptr)
+		, _headerRead(false)
+		, _endOfStream(false)
+		, _endOfData(false)
+		, _bufferCapacity(0)
+		, _outputBufferSize(0)
+		, _inputBuffer(nullptr)
+		, _outputBuffer(nullptr)
+		, _bytesRead(0)
+		, _bytesWritten(0)
+	{
+
+	}
+
+	~basic_lzma_decoder()
+	{
+		lzma_end(&_lzmaStream);
+		uninit_buffers();
+	}
+
+	void init(istream_type& stream) override
+	{
+		lzma_decoder_properties props;
+		init(stream, props);
+	}
+
+	void init(istream_type& stream, compression_decoder_properties_interface& props) override
+	{
+		// init stream
+		_stream = &stream;
+		_headerRead = false;
+		_endOfStream = false;
+		_endOfData = false;
+		_lastError = LZMA_OK;
+
+		// init values
+		_outputBufferSize = 0;
+		_bytesRead = _bytesWritten = 0;
+
+		// init buffers, a reused decoder keeps them
+		lzma_decoder_properties& lzmaProps = static_cast<lzma_decoder_properties&>(props);
+
+		if (_inputBuffer == nullptr || _bufferCapacity != lzmaProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = lzmaProps.BufferCapacity;
+			_inputBuffer = new ELEM_TYPE[_bufferCapacity];
+			_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		}
+
+		_lzmaStream.next_in = nullptr;
+		_lzmaStream.avail_in = 0;
+	}
+
+	bool is_init() const override
+	{
+		return (_inputBuffer != nullptr && _outputBuffer != nullptr);
+	}
+
+	uint64_t get_bytes_read() const override
+	{
+		return _bytesRead;
+	}
+
+	uint64_t get_bytes_written() const override
+	{
+		return _bytesWritten;
+	}
+
+	ELEM_TYPE* get_buffer_begin() override
+	{
+		return _outputBuffer;
+	}
+
+	ELEM_TYPE* get_buffer_end() override
+	{
+		return _outputBuffer + _outputBufferSize;
+	}
+
+	size_t decode_next() override
+	{
+		if (!_headerRead && !read_header())
+		{
+			return 0;
+		}
+
+		if (_endOfData)
+		{
+			return 0;
+		}
+
+		// lzma stream output
+		_lzmaStream.next_out = reinterpret_cast<uint8_t*>(_outputBuffer);
+		_lzmaStream.avail_out = _bufferCapacity;
+
+		// keep consuming input until we are able to produce some output
+		while (_lzmaStream.avail_out == _bufferCapacity)
+		{
+			if (_lzmaStream.avail_in == 0 && !_endOfStream)
+			{
+				read_next();
+			}
+
+			// without the EOS marker, the data end with the input
+			lzma_ret result = lzma_code(&_lzmaStream, _endOfStream ? LZMA_FINISH : LZMA_RUN);
+
+			if (result == LZMA_STREAM_END)
+			{
+				_endOfData = true;
+
+				// if we read more than we should, move pointer to the correct position
+				if (_lzmaStream.avail_in > 0)
+				{
+					_stream->clear();
+					_stream->seekg(-static_cast<typename istream_type::off_type>(_lzmaStream.avail_in), std::ios::cur);
+				}
+
+				break;
+			}
+
+			if (result != LZMA_OK)
+			{
+				_lastError = result;
+				_endOfData = true;
+				break;
+			}
+
+			if (_endOfStream && _lzmaStream.avail_in == 0 && _lzmaStream.avail_out == _bufferCapacity)
+			{
+				// no more data to decode
+				_endOfData = true;
+				break;
+			}
+		}
+
+		size_t bytesProcessed = _bufferCapacity - _lzmaStream.avail_out;
+
+		_outputBufferSize = bytesProcessed;
+		_bytesWritten += bytesProcessed;
+
+		// return count of processed bytes from input stream
+		return bytesProcessed;
+	}
+
+private:
+	bool read_header()
+	{
+		_headerRead = true;
+
+		// the version of the LZMA library is not needed, only the properties are
+		uint8_t header[HEADER_SIZE];
+		_stream->read(reinterpret_cast<ELEM_TYPE*>(header), HEADER_SIZE);
+
+		if (static_cast<size_t>(_stream->gcount()) != HEADER_SIZE)
+		{
+			return false;
+		}
+
+		uint16_t propertiesSize = static_cast<uint16_t>(header[2] | (header[3] << 8));
+
+		if (propertiesSize != MAX_PROPERTIES_SIZE)
+		{
+			return false;
+		}
+
+		uint8_t properties[MAX_PROPERTIES_SIZE];
+		_stream->read(reinterpret_cast<ELEM_TYPE*>(properties), propertiesSize);
+		_bytesRead += HEADER_SIZE + static_cast<size_t>(_stream->gcount());
+
+		lzma_filter filters[] = {
+			{ LZMA_FILTER_LZMA1, nullptr },
+			{ LZMA_VLI_UNKNOWN, nullptr }
+		};
+
+		if (static_cast<size_t>(_stream->gcount()) != propertiesSize
+			|| lzma_properties_decode(&filters[0], nullptr, properties, propertiesSize) != LZMA_OK)
+		{
+			return false;
+		}
+
+		_lastError = lzma_raw_decoder(&_lzmaStream, filters);
+
+		// the options are allocated by liblzma
+		free(filters[0].options);
+
+		return _lastError == LZMA_OK;
+	}
+
+	void uninit_buffers()
+	{
+		if (_inputBuffer != nullptr)
+		{
+			delete[] _inputBuffer;
+			_inputBuffer = nullptr;
+		}
+
+		if (_outputBuffer != nullptr)
+		{
+			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
+		}
+	}
+
+	void read_next()
+	{
+		// read next bytes from input stream
+		_stream->read(_inputBuffer, _bufferCapacity);
+
+		_lzmaStream.next_in = reinterpret_cast<const uint8_t*>(_inputBuffer);
+		_lzmaStream.avail_in = static_cast<size_t>(_stream->gcount());
+
+		// increase amount of total read bytes
+		_bytesRead += _lzmaStream.avail_in;
+
+		_endOfStream = _lzmaStream.avail_in != _bufferCapacity;
+	}
+
+	lzma_stream _lzmaStream;     // internal lzma structure
+	lzma_ret    _lastError;      // last error of lzma operation
+
+	istream_type* _stream;
+	bool       _headerRead;
+	bool       _endOfStream;      // the input is read entirely
+	bool       _endOfData;        // the decoding is finished
+
+	size_t     _bufferCapacity;
+	size_t     _outputBufferSize; // how many bytes are written in the output buffer
+	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
+	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
+
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
+};
+
+typedef basic_lzma_decoder<uint8_t, std::char_traits<uint8_t>>  byte_lzma_decoder;
+typedef basic_lzma_decoder<char, std::char_traits<char>>        lzma_decoder;
+typedef basic_lzma_decoder<wchar_t, std::char_traits<wchar_t>>  wlzma_decoder;
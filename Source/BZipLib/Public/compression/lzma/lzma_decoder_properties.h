@@ -0,0 +1,20 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+struct lzma_decoder_properties : compression_decoder_properties_interface
+{
+	lzma_decoder_properties()
+		: BufferCapacity(1 << 17)
+	{
+
+	}
+
+	void normalize() override
+	{
+
+	}
+
+	size_t BufferCapacity;
+};
@@ -0,0 +1,227 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include "compression/lzma/lzma_encoder_properties.h"
+
+#include "lzma.h"
+
+#include <cstdint>
+
+/**
+ * \brief Encoder of the zip method 14: the PKWARE LZMA header (the version of the LZMA library,
+ *        the size of the properties and the properties), followed by the raw LZMA1 data ended by the EOS marker.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_lzma_encoder : public compression_encoder_interface_basic<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::istream_type istream_type;
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::ostream_type ostream_type;
+
+	enum : size_t
+	{
+		HEADER_SIZE = 4,
+		PROPERTIES_SIZE = 5
+	};
+
+	basic_lzma_encoder()
+		: _lzmaStream(LZMA_STREAM_INIT)
+		, _lastError(LZMA_OK)
+		, _stream(nullptr)
+		, _bufferCapacity(0)
+		, _inputBuffer(nullptr)
+		, _outputBuffer(nullptr)
+		, _bytesRead(0)
+		, _bytesWritten(0)
+		, _finished(false)
+	{
+
+	}
+
+	~basic_lzma_encoder()
+	{
+		lzma_end(&_lzmaStream);
+		uninit_buffers();
+	}
+
+	void init(ostream_type& stream) override
+	{
+		lzma_encoder_properties props;
+		init(stream, props);
+	}
+
+	void init(ostream_type& stream, compression_encoder_properties_interface& props) override
+	{
+		// init stream
+		_stream = &stream;
+
+		// init values
+		_bytesRead = _bytesWritten = 0;
+		_finished = false;
+
+		// init buffers, a reused encoder keeps them
+		lzma_encoder_properties& lzmaProps = static_cast<lzma_encoder_properties&>(props);
+
+		if (_inputBuffer == nullptr || _bufferCapacity != lzmaProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = lzmaProps.BufferCapacity;
+			_inputBuffer = new ELEM_TYPE[_bufferCapacity];
+			_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		}
+
+		// init lzma, an initialized stream reuses its memory
+		lzma_options_lzma options;
+		lzma_lzma_preset(&options, static_cast<uint32_t>(lzmaProps.CompressionLevel) | (lzmaProps.Extreme ? LZMA_PRESET_EXTREME : 0));
+
+		if (lzmaProps.DictionarySize != 0)
+		{
+			options.dict_size = lzmaProps.DictionarySize;
+		}
+
+		// the raw LZMA1 encoder does not know the size of the data, it always ends them by the EOS marker
+		lzma_filter filters[] = {
+			{ LZMA_FILTER_LZMA1, &options },
+			{ LZMA_VLI_UNKNOWN, nullptr }
+		};
+
+		if (!lzma_succeeded(lzma_raw_encoder(&_lzmaStream, filters)))
+		{
+			return;
+		}
+
+		write_header(filters[0]);
+	}
+
+	bool is_init() const override
+	{
+		return _stream != nullptr;
+	}
+
+	uint64_t get_bytes_read() const override
+	{
+		return _bytesRead;
+	}
+
+	uint64_t get_bytes_written() const override
+	{
+		return _bytesWritten;
+	}
+
+	ELEM_TYPE* get_buffer_begin() override
+	{
+		return _inputBuffer;
+	}
+
+	ELEM_TYPE* get_buffer_end() override
+	{
+		return _inputBuffer + _bufferCapacity;
+	}
+
+	void encode_next(size_t length) override
+	{
+		// the EOS marker is written already
+		if (_finished || _lastError != LZMA_OK)
+		{
+			return;
+		}
+
+		// set the input buffer
+		_lzmaStream.next_in = reinterpret_cast<const uint8_t*>(_inputBuffer);
+		_lzmaStream.avail_in = length;
+
+		_bytesRead += length;
+
+		bool flush = length < _bufferCapacity;
+
+		// compress data
+		lzma_ret result;
+		do {
+			// lzma stream output
+			_lzmaStream.next_out = reinterpret_cast<uint8_t*>(_outputBuffer);
+			_lzmaStream.avail_out = _bufferCapacity;
+
+			// compress stream
+			result = lzma_code(&_lzmaStream, flush ? LZMA_FINISH : LZMA_RUN);
+
+			size_t have = _bufferCapacity - _lzmaStream.avail_out;
+
+			if (have > 0)
+			{
+				_stream->write(_outputBuffer, have);
+				_bytesWritten += have;
+			}
+		} while (result == LZMA_OK && (_lzmaStream.avail_out == 0 || _lzmaStream.avail_in > 0 || flush));
+
+		if (result != LZMA_STREAM_END)
+		{
+			lzma_succeeded(result);
+		}
+
+		_finished = flush;
+	}
+
+	void sync() override
+	{
+
+	}
+
+private:
+	void write_header(const lzma_filter& filter)
+	{
+		uint8_t header[HEADER_SIZE + PROPERTIES_SIZE] = {
+			LZMA_VERSION_MAJOR, LZMA_VERSION_MINOR,
+			static_cast<uint8_t>(PROPERTIES_SIZE), 0
+		};
+
+		// lc, lp and pb in one byte and the dictionary size
+		if (!lzma_succeeded(lzma_properties_encode(&filter, header + HEADER_SIZE)))
+		{
+			return;
+		}
+
+		_stream->write(reinterpret_cast<const ELEM_TYPE*>(header), sizeof(header));
+		_bytesWritten += sizeof(header);
+	}
+
+	void uninit_buffers()
+	{
+		if (_inputBuffer != nullptr)
+		{
+			delete[] _inputBuffer;
+			_inputBuffer = nullptr;
+		}
+
+		if (_outputBuffer != nullptr)
+		{
+			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
+		}
+	}
+
+	bool lzma_succeeded(lzma_ret errorCode)
+	{
+		return (_lastError = errorCode) == LZMA_OK;
+	}
+
+	lzma_stream _lzmaStream;     // internal lzma structure
+	lzma_ret    _lastError;      // last error of lzma operation
+
+	ostream_type* _stream;
+
+	size_t     _bufferCapacity;
+	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
+	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
+
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
+
+	bool _finished;
+};
+
+typedef basic_lzma_encoder<uint8_t, std::char_traits<uint8_t>>  byte_lzma_encoder;
+typedef basic_lzma_encoder<char, std::char_traits<char>>        lzma_encoder;
+typedef basic_lzma_encoder<wchar_t, std::char_traits<wchar_t>>  wlzma_encoder;
@@ -0,0 +1,31 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include <cstdint>
+
+struct lzma_encoder_properties : compression_encoder_properties_interface
+{
+	lzma_encoder_properties()
+		: BufferCapacity(1 << 17)
+		, CompressionLevel(6)
+		, Extreme(false)
+		, DictionarySize(0)
+	{
+
+	}
+
+	void normalize() override
+	{
+		CompressionLevel = clamp(0, 9, CompressionLevel);
+
+		// the limits of the LZMA1 dictionary, 0 keeps the size of the level
+		DictionarySize = DictionarySize != 0 ? clamp<uint32_t>(1u << 12, 3u << 29, DictionarySize) : 0;
+	}
+
+	size_t   BufferCapacity;
+	int      CompressionLevel;   //< preset of xz utils, 9 is the best
+	bool     Extreme;            //< slower encoding for a slightly better ratio
+	uint32_t DictionarySize;     //< 0 to use the size of the preset, 64 MB at level 9
+};
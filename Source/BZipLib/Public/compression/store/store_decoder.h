@@ -51,12 +51,16 @@ public:
 		_outputBufferSize = 0;
 		_bytesRead = _bytesWritten = 0;
 
-		// init buffers
+		// init buffers, a reused decoder keeps them
 		store_decoder_properties& storeProps = static_cast<store_decoder_properties&>(props);
-		_bufferCapacity = storeProps.BufferCapacity;
 
-		uninit_buffers();
-		_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		if (_outputBuffer == nullptr || _bufferCapacity != storeProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = storeProps.BufferCapacity;
+			_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		}
 	}
 
 	bool is_init() const override
@@ -64,12 +68,12 @@ public:
 		return (_outputBuffer != nullptr);
 	}
 
-	size_t get_bytes_read() const override
+	uint64_t get_bytes_read() const override
 	{
 		return _bytesRead;
 	}
 
-	size_t get_bytes_written() const override
+	uint64_t get_bytes_written() const override
 	{
 		return _bytesWritten;
 	}
@@ -106,6 +110,7 @@ private:
 		if (_outputBuffer != nullptr)
 		{
 			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
 		}
 	}
 
@@ -115,8 +120,8 @@ private:
 	size_t     _outputBufferSize; // how many bytes are written in the output buffer
 	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
 
-	size_t _bytesRead;
-	size_t _bytesWritten;
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
 };
 
 typedef basic_store_decoder<uint8_t, std::char_traits<uint8_t>>  byte_store_decoder;
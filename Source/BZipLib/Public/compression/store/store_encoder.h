@@ -50,13 +50,17 @@ public:
 		// init values
 		_bytesRead = _bytesWritten = 0;
 
-		// init buffers
+		// init buffers, a reused encoder keeps them
 		store_encoder_properties& storeProps = static_cast<store_encoder_properties&>(props);
-		_bufferCapacity = storeProps.BufferCapacity;
 
-		uninit_buffers();
-		_inputBuffer = new ELEM_TYPE[_bufferCapacity];
-		_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		if (_inputBuffer == nullptr || _bufferCapacity != storeProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = storeProps.BufferCapacity;
+			_inputBuffer = new ELEM_TYPE[_bufferCapacity];
+			_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		}
 	}
 
 	bool is_init() const override
@@ -64,12 +68,12 @@ public:
 		return _stream != nullptr;
 	}
 
-	size_t get_bytes_read() const override
+	uint64_t get_bytes_read() const override
 	{
 		return _bytesRead;
 	}
 
-	size_t get_bytes_written() const override
+	uint64_t get_bytes_written() const override
 	{
 		return _bytesWritten;
 	}
@@ -103,11 +107,13 @@ private:
 		if (_inputBuffer != nullptr)
 		{
 			delete[] _inputBuffer;
+			_inputBuffer = nullptr;
 		}
 
 		if (_outputBuffer != nullptr)
 		{
 			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
 		}
 	}
 
@@ -117,8 +123,8 @@ private:
 	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
 	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
 
-	size_t _bytesRead;
-	size_t _bytesWritten;
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
 };
 
 typedef basic_store_encoder<uint8_t, std::char_traits<uint8_t>>  byte_store_encoder;
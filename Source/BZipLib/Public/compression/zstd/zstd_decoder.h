@@ -0,0 +1,224 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include "compression/zstd/zstd_decoder_properties.h"
+
+#include "zstd.h"
+
+#include <cstdint>
+
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_zstd_decoder : public compression_decoder_interface_basic<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::istream_type istream_type;
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::ostream_type ostream_type;
+
+	basic_zstd_decoder()
+		: _dctx(nullptr)
+		, _lastError(0)
+		, _stream(nullptr)
+		, _endOfStream(false)
+		, _endOfFrame(false)
+		, _bufferCapacity(0)
+		, _outputBufferSize(0)
+		, _inputBuffer(nullptr)
+		, _outputBuffer(nullptr)
+		, _bytesRead(0)
+		, _bytesWritten(0)
+	{
+
+	}
+
+	~basic_zstd_decoder()
+	{
+		if (_dctx != nullptr)
+		{
+			ZSTD_freeDCtx(_dctx);
+		}
+
+		uninit_buffers();
+	}
+
+	void init(istream_type& stream) override
+	{
+		zstd_decoder_properties props;
+		init(stream, props);
+	}
+
+	void init(istream_type& stream, compression_decoder_properties_interface& props) override
+	{
+		// init stream
+		_stream = &stream;
+		_endOfStream = false;
+		_endOfFrame = false;
+
+		// init values
+		_outputBufferSize = 0;
+		_bytesRead = _bytesWritten = 0;
+
+		// init buffers, a reused decoder keeps them
+		zstd_decoder_properties& zstdProps = static_cast<zstd_decoder_properties&>(props);
+
+		if (_inputBuffer == nullptr || _bufferCapacity != zstdProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = zstdProps.BufferCapacity;
+			_inputBuffer = new ELEM_TYPE[_bufferCapacity];
+			_outputBuffer = new ELEM_TYPE[_bufferCapacity];
+		}
+
+		_input.src = _inputBuffer;
+		_input.size = 0;
+		_input.pos = 0;
+
+		// init zstd
+		if (_dctx == nullptr)
+		{
+			_dctx = ZSTD_createDCtx();
+		}
+		else
+		{
+			ZSTD_DCtx_reset(_dctx, ZSTD_reset_session_and_parameters);
+		}
+
+		ZSTD_DCtx_setParameter(_dctx, ZSTD_d_windowLogMax, zstdProps.WindowLogMax);
+	}
+
+	bool is_init() const override
+	{
+		return (_inputBuffer != nullptr && _outputBuffer != nullptr);
+	}
+
+	uint64_t get_bytes_read() const override
+	{
+		return _bytesRead;
+	}
+
+	uint64_t get_bytes_written() const override
+	{
+		return _bytesWritten;
+	}
+
+	ELEM_TYPE* get_buffer_begin() override
+	{
+		return _outputBuffer;
+	}
+
+	ELEM_TYPE* get_buffer_end() override
+	{
+		return _outputBuffer + _outputBufferSize;
+	}
+
+	size_t decode_next() override
+	{
+		if (_endOfFrame)
+		{
+			return 0;
+		}
+
+		ZSTD_outBuffer output = { _outputBuffer, _bufferCapacity, 0 };
+
+		// keep consuming input until we are able to produce some output
+		while (output.pos == 0)
+		{
+			// the context may still hold data to flush, when the input is exhausted
+			if (_input.pos == _input.size && !_endOfStream)
+			{
+				read_next();
+			}
+
+			size_t result = ZSTD_decompressStream(_dctx, &output, &_input);
+
+			if (!zstd_succeeded(result))
+			{
+				return 0;
+			}
+
+			if (result == 0)
+			{
+				_endOfFrame = true;
+
+				// if we read more than we should, move pointer to the correct position
+				if (_input.pos < _input.size)
+				{
+					_stream->clear();
+					_stream->seekg(-static_cast<typename istream_type::off_type>(_input.size - _input.pos), std::ios::cur);
+				}
+
+				break;
+			}
+
+			if (_endOfStream && _input.pos == _input.size && output.pos == 0)
+			{
+				// truncated frame
+				return 0;
+			}
+		}
+
+		_outputBufferSize = output.pos;
+		_bytesWritten += output.pos;
+
+		// return count of decompressed bytes
+		return output.pos;
+	}
+
+private:
+	void uninit_buffers()
+	{
+		if (_inputBuffer != nullptr)
+		{
+			delete[] _inputBuffer;
+			_inputBuffer = nullptr;
+		}
+
+		if (_outputBuffer != nullptr)
+		{
+			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
+		}
+	}
+
+	void read_next()
+	{
+		// read next bytes from input stream
+		_stream->read(_inputBuffer, _bufferCapacity);
+
+		_input.size = static_cast<size_t>(_stream->gcount());
+		_input.pos = 0;
+
+		// increase amount of total read bytes
+		_bytesRead += _input.size;
+
+		_endOfStream = _input.size != _bufferCapacity;
+	}
+
+	bool zstd_succeeded(size_t result)
+	{
+		_lastError = result;
+		return !ZSTD_isError(result);
+	}
+
+	ZSTD_DCtx*     _dctx;         // internal zstd context
+	ZSTD_inBuffer  _input;        // unconsumed part of the input buffer
+	size_t         _lastError;    // last result of zstd operation
+
+	istream_type* _stream;
+	bool       _endOfStream;
+	bool       _endOfFrame;
+
+	size_t     _bufferCapacity;
+	size_t     _outputBufferSize; // how many bytes are written in the output buffer
+	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
+	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
+
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
+};
+
+typedef basic_zstd_decoder<uint8_t, std::char_traits<uint8_t>>  byte_zstd_decoder;
+typedef basic_zstd_decoder<char, std::char_traits<char>>        zstd_decoder;
+typedef basic_zstd_decoder<wchar_t, std::char_traits<wchar_t>>  wzstd_decoder;
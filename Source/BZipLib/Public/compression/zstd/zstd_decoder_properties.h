@@ -0,0 +1,24 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include <algorithm>
+
+struct zstd_decoder_properties : compression_decoder_properties_interface
+{
+	zstd_decoder_properties()
+		: BufferCapacity(1 << 17)
+		, WindowLogMax(31)
+	{
+
+	}
+
+	void normalize() override
+	{
+		WindowLogMax = std::min(std::max(WindowLogMax, 10), 31);
+	}
+
+	size_t BufferCapacity;
+	int    WindowLogMax;   //< largest window accepted, which bounds the memory used by the decoding
+};
@@ -0,0 +1,207 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include "compression/zstd/zstd_encoder_properties.h"
+
+#include "zstd.h"
+
+#include "CoreMinimal.h"
+
+#include <cstdint>
+
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_zstd_encoder : public compression_encoder_interface_basic<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::istream_type istream_type;
+	typedef typename compression_interface_basic<ELEM_TYPE, TRAITS_TYPE>::ostream_type ostream_type;
+
+	basic_zstd_encoder()
+		: _cctx(nullptr)
+		, _lastError(0)
+		, _stream(nullptr)
+		, _bufferCapacity(0)
+		, _outputBufferCapacity(0)
+		, _inputBuffer(nullptr)
+		, _outputBuffer(nullptr)
+		, _bytesRead(0)
+		, _bytesWritten(0)
+		, _finished(false)
+	{
+
+	}
+
+	~basic_zstd_encoder()
+	{
+		if (_cctx != nullptr)
+		{
+			ZSTD_freeCCtx(_cctx);
+		}
+
+		uninit_buffers();
+	}
+
+	void init(ostream_type& stream) override
+	{
+		zstd_encoder_properties props;
+		init(stream, props);
+	}
+
+	void init(ostream_type& stream, compression_encoder_properties_interface& props) override
+	{
+		// init stream
+		_stream = &stream;
+
+		// init values
+		_bytesRead = _bytesWritten = 0;
+		_finished = false;
+
+		// init buffers, a reused encoder keeps them
+		zstd_encoder_properties& zstdProps = static_cast<zstd_encoder_properties&>(props);
+		_outputBufferCapacity = ZSTD_CStreamOutSize();
+
+		if (_inputBuffer == nullptr || _bufferCapacity != zstdProps.BufferCapacity)
+		{
+			uninit_buffers();
+
+			_bufferCapacity = zstdProps.BufferCapacity;
+			_inputBuffer = new ELEM_TYPE[_bufferCapacity];
+			_outputBuffer = new ELEM_TYPE[_outputBufferCapacity];
+		}
+
+		// the context is kept between the entries, only its parameters are reset
+		if (_cctx == nullptr)
+		{
+			_cctx = ZSTD_createCCtx();
+		}
+		else
+		{
+			ZSTD_CCtx_reset(_cctx, ZSTD_reset_session_and_parameters);
+		}
+
+		const int numThreads = zstdProps.NumThreads > 0 ? zstdProps.NumThreads : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+
+		ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, zstdProps.CompressionLevel);
+		ZSTD_CCtx_setParameter(_cctx, ZSTD_c_enableLongDistanceMatching, zstdProps.EnableLongDistanceMatching ? 1 : 0);
+		ZSTD_CCtx_setParameter(_cctx, ZSTD_c_windowLog, zstdProps.WindowLog);
+
+		// the zip headers carry the crc32 and the sizes already
+		ZSTD_CCtx_setParameter(_cctx, ZSTD_c_checksumFlag, 0);
+
+		// fails if the library is built without ZSTD_MULTITHREAD, the compression stays single-threaded then
+		if (numThreads > 1)
+		{
+			ZSTD_CCtx_setParameter(_cctx, ZSTD_c_nbWorkers, numThreads);
+		}
+	}
+
+	bool is_init() const override
+	{
+		return _stream != nullptr;
+	}
+
+	uint64_t get_bytes_read() const override
+	{
+		return _bytesRead;
+	}
+
+	uint64_t get_bytes_written() const override
+	{
+		return _bytesWritten;
+	}
+
+	ELEM_TYPE* get_buffer_begin() override
+	{
+		return _inputBuffer;
+	}
+
+	ELEM_TYPE* get_buffer_end() override
+	{
+		return _inputBuffer + _bufferCapacity;
+	}
+
+	void encode_next(size_t length) override
+	{
+		// the frame is closed, further flushes must not start a new one
+		if (_finished)
+		{
+			return;
+		}
+
+		_bytesRead += length;
+
+		bool flush = length < _bufferCapacity;
+		ZSTD_EndDirective directive = flush ? ZSTD_e_end : ZSTD_e_continue;
+
+		ZSTD_inBuffer input = { _inputBuffer, length, 0 };
+
+		// compress data, with workers the input might not be taken at once
+		size_t remaining;
+		do {
+			ZSTD_outBuffer output = { _outputBuffer, _outputBufferCapacity, 0 };
+
+			remaining = ZSTD_compressStream2(_cctx, &output, &input, directive);
+
+			if (!zstd_succeeded(remaining))
+			{
+				break;
+			}
+
+			if (output.pos > 0)
+			{
+				_stream->write(_outputBuffer, output.pos);
+				_bytesWritten += output.pos;
+			}
+		} while (flush ? remaining != 0 : input.pos < input.size);
+
+		_finished = flush;
+	}
+
+	void sync() override
+	{
+
+	}
+
+private:
+	void uninit_buffers()
+	{
+		if (_inputBuffer != nullptr)
+		{
+			delete[] _inputBuffer;
+			_inputBuffer = nullptr;
+		}
+
+		if (_outputBuffer != nullptr)
+		{
+			delete[] _outputBuffer;
+			_outputBuffer = nullptr;
+		}
+	}
+
+	bool zstd_succeeded(size_t result)
+	{
+		_lastError = result;
+		return !ZSTD_isError(result);
+	}
+
+	ZSTD_CCtx* _cctx;            // internal zstd context
+	size_t     _lastError;       // last result of zstd operation
+
+	ostream_type* _stream;
+
+	size_t     _bufferCapacity;
+	size_t     _outputBufferCapacity;
+	ELEM_TYPE* _inputBuffer;      // pointer to the start of the input buffer
+	ELEM_TYPE* _outputBuffer;     // pointer to the start of the output buffer
+
+	uint64_t _bytesRead;
+	uint64_t _bytesWritten;
+
+	bool _finished;
+};
+
+typedef basic_zstd_encoder<uint8_t, std::char_traits<uint8_t>>  byte_zstd_encoder;
+typedef basic_zstd_encoder<char, std::char_traits<char>>        zstd_encoder;
+typedef basic_zstd_encoder<wchar_t, std::char_traits<wchar_t>>  wzstd_encoder;
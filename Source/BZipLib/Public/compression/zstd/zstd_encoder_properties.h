@@ -0,0 +1,32 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "compression/compression_interface.h"
+
+#include <algorithm>
+
+struct zstd_encoder_properties : compression_encoder_properties_interface
+{
+	zstd_encoder_properties()
+		: BufferCapacity(1 << 17)
+		, CompressionLevel(3)
+		, EnableLongDistanceMatching(false)
+		, WindowLog(0)
+		, NumThreads(1)
+	{
+
+	}
+
+	void normalize() override
+	{
+		CompressionLevel = clamp(-7, 22, CompressionLevel);
+		WindowLog = WindowLog != 0 ? clamp(10, 31, WindowLog) : 0;
+		NumThreads = std::max(0, NumThreads);
+	}
+
+	size_t BufferCapacity;
+	int    CompressionLevel;             //< negative levels are faster than 1, 22 is the best
+	bool   EnableLongDistanceMatching;   //< finds matches far back in the window, good for large repetitive data
+	int    WindowLog;                    //< log2 of the window size, 0 to let the level (or the long distance matching) choose
+	int    NumThreads;                   //< number of threads compressing one entry, 0 to use all the cores
+};
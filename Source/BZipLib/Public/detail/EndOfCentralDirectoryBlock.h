@@ -43,6 +43,7 @@ namespace detail {
 		friend class ::BZipArchiveEntry;
 
 		bool Deserialize(std::istream& stream);
+		bool Deserialize(const uint8_t*& data, const uint8_t* end);
 		void Serialize(std::ostream& stream);
 	};
 
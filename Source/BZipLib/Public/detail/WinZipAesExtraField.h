@@ -0,0 +1,58 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "detail/ZipGenericExtraField.h"
+
+#include <vector>
+#include <cstdint>
+
+class BZipArchiveEntry;
+struct ZipMethodResolver;
+
+namespace detail {
+
+	/**
+	 * \brief The WinZip AES extra field (tag 0x9901).
+	 *        An AES encrypted entry stores the compression method 99 in its headers,
+	 *        the real compression method and the key strength are kept in this field.
+	 */
+	struct WinZipAesExtraField
+	{
+		enum : uint16_t
+		{
+			TagConstant = 0x9901,
+			CompressionMethodConstant = 99,
+			VendorIdConstant = 0x4541,   // "AE"
+			VendorVersionAE1 = 1,
+			VendorVersionAE2 = 2,
+			VersionNeededToExtract = 51
+		};
+
+		enum : size_t
+		{
+			DATA_SIZE = 7
+		};
+
+		uint16_t VendorVersion;
+		uint16_t VendorId;
+		uint8_t  Strength;            //< 1, 2 or 3 for AES-128, AES-192 or AES-256
+		uint16_t CompressionMethod;   //< the real compression method
+
+		WinZipAesExtraField();
+
+		size_t GetKeyLength() const
+		{
+			return (Strength >= 1 && Strength <= 3) ? 8 + 8 * static_cast<size_t>(Strength) : 0;
+		}
+
+	private:
+		friend class ::BZipArchiveEntry;
+		friend struct ::ZipMethodResolver;
+
+		bool Deserialize(const std::vector<ZipGenericExtraField>& extraFields);
+
+		// replaces the AES extra field in the list, removes it if the field is not used
+		void Serialize(std::vector<ZipGenericExtraField>& extraFields, bool isUsed);
+	};
+
+}
@@ -0,0 +1,77 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstdint>
+#include <iostream>
+
+class BZipArchive;
+
+namespace detail {
+
+	/**
+	 * \brief The ZIP64 end of central directory locator.
+	 *        Stored right before the end of central directory record, it points to the ZIP64 end of central directory record.
+	 */
+	struct Zip64EndOfCentralDirectoryLocator
+	{
+		enum : size_t
+		{
+			SIZE_IN_BYTES = 20
+		};
+
+		enum : uint32_t
+		{
+			SignatureConstant = 0x07064b50
+		};
+
+		uint32_t Signature;
+		uint32_t NumberOfTheDiskWithTheStartOfTheZip64EndOfCentralDirectory;
+		uint64_t RelativeOffsetOfTheZip64EndOfCentralDirectoryRecord;
+		uint32_t TotalNumberOfDisks;
+
+		Zip64EndOfCentralDirectoryLocator();
+
+	private:
+		friend class ::BZipArchive;
+
+		bool Deserialize(const uint8_t*& data, const uint8_t* end);
+		void Serialize(std::ostream& stream);
+	};
+
+	/**
+	 * \brief The ZIP64 end of central directory record.
+	 *        Holds the 64-bit counterparts of the entry counts, the size and the offset of the central directory.
+	 */
+	struct Zip64EndOfCentralDirectoryBlock
+	{
+		enum : size_t
+		{
+			SIZE_IN_BYTES = 56
+		};
+
+		enum : uint32_t
+		{
+			SignatureConstant = 0x06064b50
+		};
+
+		uint32_t Signature;
+		uint64_t SizeOfZip64EndOfCentralDirectoryRecord;
+		uint16_t VersionMadeBy;
+		uint16_t VersionNeededToExtract;
+		uint32_t NumberOfThisDisk;
+		uint32_t NumberOfTheDiskWithTheStartOfTheCentralDirectory;
+		uint64_t NumberOfEntriesInTheCentralDirectoryOnThisDisk;
+		uint64_t NumberOfEntriesInTheCentralDirectory;
+		uint64_t SizeOfCentralDirectory;
+		uint64_t OffsetOfStartOfCentralDirectoryWithRespectToTheStartingDiskNumber;
+
+		Zip64EndOfCentralDirectoryBlock();
+
+	private:
+		friend class ::BZipArchive;
+
+		bool Deserialize(const uint8_t*& data, const uint8_t* end);
+		void Serialize(std::ostream& stream);
+	};
+
+}
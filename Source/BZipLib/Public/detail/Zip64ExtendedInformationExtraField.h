@@ -0,0 +1,50 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "detail/ZipGenericExtraField.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace detail {
+
+	/**
+	 * \brief The ZIP64 extended information extra field (tag 0x0001).
+	 *        It carries the 64-bit values of the header fields which are saturated (0xFFFFFFFF or 0xFFFF),
+	 *        in the fixed order below, but only those which are saturated.
+	 */
+	struct Zip64ExtendedInformationExtraField
+	{
+		enum : uint16_t
+		{
+			TagConstant = 0x0001
+		};
+
+		static const uint32_t SaturatedValue32 = 0xffffffff;
+		static const uint16_t SaturatedValue16 = 0xffff;
+
+		uint64_t UncompressedSize;
+		uint64_t CompressedSize;
+		uint64_t RelativeOffsetOfLocalHeader;
+		uint32_t DiskStartNumber;
+
+		Zip64ExtendedInformationExtraField();
+
+		static uint32_t Saturate32(uint64_t value)
+		{
+			return value < SaturatedValue32 ? static_cast<uint32_t>(value) : SaturatedValue32;
+		}
+
+	private:
+		friend struct ZipLocalFileHeader;
+		friend struct ZipCentralDirectoryFileHeader;
+
+		bool Deserialize(const std::vector<ZipGenericExtraField>& extraFields,
+			bool hasUncompressedSize, bool hasCompressedSize, bool hasRelativeOffsetOfLocalHeader, bool hasDiskStartNumber);
+
+		// replaces the ZIP64 extra field in the list, removes it if no value is needed
+		void Serialize(std::vector<ZipGenericExtraField>& extraFields,
+			bool hasUncompressedSize, bool hasCompressedSize, bool hasRelativeOffsetOfLocalHeader, bool hasDiskStartNumber);
+	};
+
+}
@@ -52,6 +52,11 @@ namespace detail {
 		std::vector<ZipGenericExtraField> ExtraFields;
 		std::string FileComment;
 
+		// true sizes and offset, the 32-bit fields of the base are saturated when they are stored in the ZIP64 extra field
+		uint64_t CompressedSize64;
+		uint64_t UncompressedSize64;
+		uint64_t RelativeOffsetOfLocalHeader64;
+
 		ZipCentralDirectoryFileHeader();
 
 	private:
@@ -61,7 +66,10 @@ namespace detail {
 		void SyncWithLocalFileHeader(ZipLocalFileHeader& lfh);
 
 		bool Deserialize(std::istream& stream);
+		bool Deserialize(const uint8_t*& data, const uint8_t* end);
 		void Serialize(std::ostream& stream);
+
+		void ReadZip64ExtendedInformation();
 	};
 
 }
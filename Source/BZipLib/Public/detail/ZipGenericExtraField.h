@@ -23,6 +23,7 @@ namespace detail {
 		friend struct ZipCentralDirectoryFileHeader;
 
 		bool Deserialize(std::istream& stream, std::istream::pos_type extraFieldEnd);
+		bool Deserialize(const uint8_t*& data, const uint8_t* extraFieldEnd);
 		void Serialize(std::ostream& stream);
 	};
 
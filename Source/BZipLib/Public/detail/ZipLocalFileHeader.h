@@ -44,6 +44,14 @@ namespace detail {
 		std::string Filename;
 		std::vector<ZipGenericExtraField> ExtraFields;
 
+		// true sizes, the 32-bit fields of the base are saturated when they are stored in the ZIP64 extra field
+		uint64_t CompressedSize64;
+		uint64_t UncompressedSize64;
+
+		// stores both sizes in the ZIP64 extra field and in the data descriptor as 64-bit values,
+		// must not change between the serialization of the header and its rewrite
+		bool UseZip64;
+
 		ZipLocalFileHeader();
 
 	private:
@@ -52,8 +60,11 @@ namespace detail {
 		void SyncWithCentralDirectoryFileHeader(ZipCentralDirectoryFileHeader& cdfh);
 
 		bool Deserialize(std::istream& stream);
+		bool Deserialize(const uint8_t*& data, const uint8_t* end);
 		void Serialize(std::ostream& stream);
 
+		void ReadZip64ExtendedInformation();
+
 		void DeserializeAsDataDescriptor(std::istream& stream);
 		void SerializeAsDataDescriptor(std::ostream& stream);
 	};
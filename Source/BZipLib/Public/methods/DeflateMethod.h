@@ -35,12 +35,60 @@ public:
 		Best = L9
 	};
 
+	enum class Strategy : int
+	{
+		Default = Z_DEFAULT_STRATEGY,
+		Filtered = Z_FILTERED,           //< small values with a somewhat random distribution
+		HuffmanOnly = Z_HUFFMAN_ONLY,    //< no string matching, the fastest
+		Rle = Z_RLE,                     //< matches of runs only, fast on sparse data, heightmaps and voxels
+		Fixed = Z_FIXED,                 //< no dynamic Huffman codes
+
+		/**
+		 * The encoder samples the first buffer of every entry and picks the fastest strategy
+		 * which compresses it at most AutoStrategyTolerance worse than the default strategy.
+		 */
+		Auto = deflate_encoder_properties::AUTO_STRATEGY
+	};
+
 	size_t GetBufferCapacity() const { return _encoderProps.BufferCapacity; }
 	void SetBufferCapacity(size_t bufferCapacity) { _encoderProps.BufferCapacity = bufferCapacity; }
 
 	CompressionLevel GetCompressionLevel() const { return static_cast<CompressionLevel>(_encoderProps.CompressionLevel); }
 	void SetCompressionLevel(CompressionLevel compressionLevel) { _encoderProps.CompressionLevel = static_cast<int>(compressionLevel); }
 
+	/**
+	 * \brief Number of threads compressing a single entry, 0 to use all the cores.
+	 *        With more than one thread, the input is compressed in blocks of ParallelBlockSize bytes,
+	 *        which are joined into one standard deflate stream.
+	 */
+	int GetNumThreads() const { return _encoderProps.NumThreads; }
+	void SetNumThreads(int numThreads) { _encoderProps.NumThreads = numThreads; }
+
+	size_t GetParallelBlockSize() const { return _encoderProps.ParallelBlockSize; }
+	void SetParallelBlockSize(size_t parallelBlockSize) { _encoderProps.ParallelBlockSize = parallelBlockSize; }
+
+	Strategy GetStrategy() const { return static_cast<Strategy>(_encoderProps.Strategy); }
+	void SetStrategy(Strategy strategy) { _encoderProps.Strategy = static_cast<int>(strategy); }
+
+	/**
+	 * \brief Allowed size increase of the sample for the Auto strategy, 0.05 accepts 5% larger output.
+	 */
+	double GetAutoStrategyTolerance() const { return _encoderProps.AutoStrategyTolerance; }
+	void SetAutoStrategyTolerance(double tolerance) { _encoderProps.AutoStrategyTolerance = tolerance; }
+
+	/**
+	 * \brief Memory of the compression state, from 1 (least memory, slow) to 9, 8 by default.
+	 */
+	int GetMemLevel() const { return _encoderProps.MemLevel; }
+	void SetMemLevel(int memLevel) { _encoderProps.MemLevel = memLevel; }
+
+	/**
+	 * \brief Base two logarithm of the window size, from 9 to 15. A smaller window needs less memory,
+	 *        but finds fewer matches.
+	 */
+	int GetWindowBits() const { return _encoderProps.WindowBits; }
+	void SetWindowBits(int windowBits) { _encoderProps.WindowBits = windowBits; }
+
 private:
 	deflate_encoder_properties _encoderProps;
 	deflate_decoder_properties _decoderProps;
@@ -30,6 +30,20 @@
     return MakeShareable<method_class>(new method_class());                     \
   }                                                                             \
                                                                                 \
+  TSharedPtr<ICompressionMethod> Clone() const override                         \
+  {                                                                             \
+    Ptr result = Create();                                                      \
+    result->CopyProperties(*this);                                              \
+    return result;                                                              \
+  }                                                                             \
+                                                                                \
+  void CopyProperties(const ICompressionMethod& other) override                 \
+  {                                                                             \
+    const method_class& source = static_cast<const method_class&>(other);       \
+    encoder_props_member = source.encoder_props_member;                         \
+    decoder_props_member = source.decoder_props_member;                         \
+  }                                                                             \
+                                                                                \
   compression_encoder_properties_interface& GetEncoderProperties() override     \
   {                                                                             \
     encoder_props_member.normalize();                                           \
@@ -82,11 +96,32 @@ public:
 	encoder_t GetEncoder() const { return _encoder; }
 	decoder_t GetDecoder() const { return _decoder; }
 
+	/**
+	 * \brief Whether a stream still refers to the encoder or to the decoder of this instance.
+	 */
+	bool IsCodecInUse() const { return !_encoder.IsUnique() || !_decoder.IsUnique(); }
+
 	virtual compression_encoder_properties_interface& GetEncoderProperties() = 0;
 	virtual compression_decoder_properties_interface& GetDecoderProperties() = 0;
 
 	virtual ~ICompressionMethod() {}
 
+	/**
+	 * \brief Creates a new instance with the same properties, but its own encoder and decoder,
+	 *        so it can be used at the same time as this one.
+	 */
+	virtual TSharedPtr<ICompressionMethod> Clone() const = 0;
+
+	/**
+	 * \brief Copies the properties of the other instance of the same class, the encoder and the decoder are kept.
+	 */
+	virtual void CopyProperties(const ICompressionMethod& other) = 0;
+
+	/**
+	 * \brief Bits 1 and 2 of the general purpose flag, whose meaning depends on the method.
+	 */
+	virtual uint16_t GetGeneralPurposeBitFlag() const { return 0; }
+
 	virtual const ZipMethodDescriptor& GetZipMethodDescriptor() const = 0;
 	static const ZipMethodDescriptor& GetZipMethodDescriptorStatic()
 	{
@@ -0,0 +1,65 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "methods/ICompressionMethod.h"
+#include "compression/lzma/lzma_encoder.h"
+#include "compression/lzma/lzma_decoder.h"
+
+#include <memory>
+
+/**
+ * \brief LZMA compression (method 14), for the archives where the size matters much more than the speed.
+ *        The data always end by the EOS marker, which is announced by bit 1 of the general purpose flag.
+ */
+class LzmaMethod : public ICompressionMethod
+{
+public:
+	ZIP_METHOD_CLASS_PROLOGUE(
+		LzmaMethod,
+		lzma_encoder, lzma_decoder,
+		_encoderProps, _decoderProps,
+		/* CompressionMethod */ 14,
+		/* VersionNeededToExtract */ 63
+	);
+
+	static const uint16_t EndOfStreamMarkerFlag = 2;
+
+	enum class CompressionLevel : int
+	{
+		L1 = 1,
+		L2 = 2,
+		L3 = 3,
+		L4 = 4,
+		L5 = 5,
+		L6 = 6,
+		L7 = 7,
+		L8 = 8,
+		L9 = 9,
+
+		Fastest = L1,
+		Default = L6,
+		Best = L9
+	};
+
+	uint16_t GetGeneralPurposeBitFlag() const override { return EndOfStreamMarkerFlag; }
+
+	size_t GetBufferCapacity() const { return _encoderProps.BufferCapacity; }
+	void SetBufferCapacity(size_t bufferCapacity) { _encoderProps.BufferCapacity = bufferCapacity; _decoderProps.BufferCapacity = bufferCapacity; }
+
+	CompressionLevel GetCompressionLevel() const { return static_cast<CompressionLevel>(_encoderProps.CompressionLevel); }
+	void SetCompressionLevel(CompressionLevel compressionLevel) { _encoderProps.CompressionLevel = static_cast<int>(compressionLevel); }
+
+	bool GetExtreme() const { return _encoderProps.Extreme; }
+	void SetExtreme(bool extreme) { _encoderProps.Extreme = extreme; }
+
+	/**
+	 * \brief Size of the dictionary in bytes, 0 to use the size of the level.
+	 *        The decompression needs about as much memory.
+	 */
+	uint32_t GetDictionarySize() const { return _encoderProps.DictionarySize; }
+	void SetDictionarySize(uint32_t dictionarySize) { _encoderProps.DictionarySize = dictionarySize; }
+
+private:
+	lzma_encoder_properties _encoderProps;
+	lzma_decoder_properties _decoderProps;
+};
@@ -0,0 +1,96 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "methods/ICompressionMethod.h"
+#include "methods/ZipMethodResolver.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Per-thread pool of compression methods. A method whose encoder and decoder are not used
+ *        by any stream anymore is handed out again, so their buffers and codec state (zlib, zstd, lzma)
+ *        are reset instead of allocated and initialized for every entry.
+ */
+struct ZipMethodPool
+{
+	/**
+	 * \brief Like ZipMethodResolver::GetZipMethodInstance, with the default properties of the method.
+	 */
+	static TSharedPtr<ICompressionMethod> GetZipMethodInstance(uint16_t compressionMethod)
+	{
+		TSharedPtr<ICompressionMethod> result = FindUnused([compressionMethod](const ICompressionMethod& method)
+		{
+			return method.GetZipMethodDescriptor().GetCompressionMethod() == compressionMethod;
+		});
+
+		if (result != nullptr)
+		{
+			result->CopyProperties(*ZipMethodResolver::GetZipMethodInstance(compressionMethod));
+			return result;
+		}
+
+		return Add(ZipMethodResolver::GetZipMethodInstance(compressionMethod));
+	}
+
+	/**
+	 * \brief Like ICompressionMethod::Clone, with the properties of the given method.
+	 */
+	static TSharedPtr<ICompressionMethod> Clone(const ICompressionMethod& source)
+	{
+		// every method class has its own compression method id, CopyProperties relies on the same class
+		const uint16_t compressionMethod = source.GetZipMethodDescriptor().GetCompressionMethod();
+
+		TSharedPtr<ICompressionMethod> result = FindUnused([compressionMethod](const ICompressionMethod& method)
+		{
+			return method.GetZipMethodDescriptor().GetCompressionMethod() == compressionMethod;
+		});
+
+		if (result != nullptr)
+		{
+			result->CopyProperties(source);
+			return result;
+		}
+
+		return Add(source.Clone());
+	}
+
+private:
+	enum : size_t
+	{
+		MAX_POOLED_METHODS = 8
+	};
+
+	static std::vector<TSharedPtr<ICompressionMethod>>& GetPool()
+	{
+		static thread_local std::vector<TSharedPtr<ICompressionMethod>> pool;
+		return pool;
+	}
+
+	template <typename PREDICATE>
+	static TSharedPtr<ICompressionMethod> FindUnused(PREDICATE predicate)
+	{
+		for (TSharedPtr<ICompressionMethod>& method : GetPool())
+		{
+			// only the pool refers to the method, and no stream to its encoder or decoder
+			if (method.IsUnique() && !method->IsCodecInUse() && predicate(*method))
+			{
+				return method;
+			}
+		}
+
+		return TSharedPtr<ICompressionMethod>();
+	}
+
+	static TSharedPtr<ICompressionMethod> Add(const TSharedPtr<ICompressionMethod>& method)
+	{
+		std::vector<TSharedPtr<ICompressionMethod>>& pool = GetPool();
+
+		if (method != nullptr && pool.size() < MAX_POOLED_METHODS)
+		{
+			pool.push_back(method);
+		}
+
+		return method;
+	}
+};
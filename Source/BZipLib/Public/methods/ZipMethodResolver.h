@@ -3,14 +3,34 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <vector>
 #include "methods/ICompressionMethod.h"
+#include "detail/WinZipAesExtraField.h"
 
 #include "methods/StoreMethod.h"
 #include "methods/DeflateMethod.h"
 
+#if WITH_ZSTD
+#include "methods/ZstdMethod.h"
+#define ZIP_METHOD_ZSTD           \
+  ZIP_METHOD_ADD(ZstdMethod);
+#else
+#define ZIP_METHOD_ZSTD
+#endif
+
+#if WITH_LZMA
+#include "methods/LzmaMethod.h"
+#define ZIP_METHOD_LZMA           \
+  ZIP_METHOD_ADD(LzmaMethod);
+#else
+#define ZIP_METHOD_LZMA
+#endif
+
 #define ZIP_METHOD_TABLE          \
   ZIP_METHOD_ADD(StoreMethod);    \
-  ZIP_METHOD_ADD(DeflateMethod);
+  ZIP_METHOD_ADD(DeflateMethod);  \
+  ZIP_METHOD_ZSTD                 \
+  ZIP_METHOD_LZMA
 
 #define ZIP_METHOD_ADD(method_class)                                                            \
   if (compressionMethod == method_class::GetZipMethodDescriptorStatic().GetCompressionMethod()) \
@@ -23,6 +43,27 @@ struct ZipMethodResolver
 		ZIP_METHOD_TABLE;
 		return TSharedPtr<ICompressionMethod>();
 	}
+
+	/**
+	 * \brief Resolves the method of an entry by its header. The AES encrypted entries store
+	 *        the method 99 in the header, their real method is taken from the WinZip AES extra field.
+	 */
+	static TSharedPtr<ICompressionMethod> GetZipMethodInstance(uint16_t compressionMethod, const std::vector<detail::ZipGenericExtraField>& extraFields)
+	{
+		if (compressionMethod == detail::WinZipAesExtraField::CompressionMethodConstant)
+		{
+			detail::WinZipAesExtraField aesExtraField;
+
+			if (!aesExtraField.Deserialize(extraFields))
+			{
+				return TSharedPtr<ICompressionMethod>();
+			}
+
+			compressionMethod = aesExtraField.CompressionMethod;
+		}
+
+		return GetZipMethodInstance(compressionMethod);
+	}
 };
 
 #undef ZIP_METHOD
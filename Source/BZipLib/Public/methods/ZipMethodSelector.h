@@ -0,0 +1,82 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "methods/ICompressionMethod.h"
+#include "methods/DeflateMethod.h"
+#include "methods/StoreMethod.h"
+
+#include <istream>
+
+/**
+ * \brief Picks the compression method of a file, so the data which are compressed already
+ *        (images, audio, video, archives) are stored instead of being compressed again.
+ *        The extension of the file is looked up first, when it has no policy, the beginning
+ *        of the data is sampled: its entropy is measured and it is compressed by the fastest deflate.
+ */
+class BZIPLIB_API ZipMethodSelector
+{
+public:
+	enum class ExtensionPolicy
+	{
+		Sample,     //< decided by the sample of the data
+		Compress,   //< always the compression method
+		Store       //< always stored
+	};
+
+	/**
+	 * \brief Creates the selector with the policies of the common compressed formats.
+	 *
+	 * \param method     The compression method of the data which compress well.
+	 * \param fastMethod (Optional) The method of the data which compress only a bit, the fastest deflate by default.
+	 */
+	explicit ZipMethodSelector(TSharedPtr<ICompressionMethod> method = DeflateMethod::Create(), TSharedPtr<ICompressionMethod> fastMethod = nullptr);
+
+	/**
+	 * \brief Sets the policy of the files with the given extension, without the dot, case insensitive.
+	 */
+	void SetExtensionPolicy(const FString& extension, ExtensionPolicy policy);
+	ExtensionPolicy GetExtensionPolicy(const FString& fileName) const;
+
+	/**
+	 * \brief Returns the method to compress the file with. The sampled bytes are read from the current
+	 *        position of the stream, which is restored afterwards. A stream which cannot seek is not sampled.
+	 */
+	TSharedPtr<ICompressionMethod> SelectMethod(const FString& fileName, std::istream& stream) const;
+
+	/**
+	 * \brief Returns the method picked by the name of the file alone, the compression method when the data would be sampled.
+	 */
+	TSharedPtr<ICompressionMethod> SelectMethod(const FString& fileName) const;
+
+	/**
+	 * \brief Whether the method of the file depends on the sample of its data.
+	 */
+	bool NeedsSample(const FString& fileName) const;
+
+	/**
+	 * \brief Number of bytes sampled from the beginning of the data.
+	 */
+	size_t SampleSize;
+
+	/**
+	 * \brief Data with more bits of entropy per byte are stored without the trial compression.
+	 */
+	double MaxEntropy;
+
+	/**
+	 * \brief Compressed to uncompressed size ratios of the sample. Above StoreRatio the data are stored,
+	 *        above FastRatio they are compressed by the fast method.
+	 */
+	double StoreRatio;
+	double FastRatio;
+
+private:
+	TSharedPtr<ICompressionMethod> _method;
+	TSharedPtr<ICompressionMethod> _fastMethod;
+	TSharedPtr<ICompressionMethod> _storeMethod;
+
+	TMap<FString, ExtensionPolicy> _extensionPolicies;
+};
@@ -0,0 +1,71 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include "methods/ICompressionMethod.h"
+#include "compression/zstd/zstd_encoder.h"
+#include "compression/zstd/zstd_decoder.h"
+
+#include <memory>
+
+/**
+ * \brief Zstandard compression (method 93 of the APPNOTE 6.3.7).
+ *        It decompresses much faster than deflate with better ratios, but only some zip tools can extract it.
+ */
+class ZstdMethod : public ICompressionMethod
+{
+public:
+	ZIP_METHOD_CLASS_PROLOGUE(
+		ZstdMethod,
+		zstd_encoder, zstd_decoder,
+		_encoderProps, _decoderProps,
+		/* CompressionMethod */ 93,
+		/* VersionNeededToExtract */ 63
+	);
+
+	enum class CompressionLevel : int
+	{
+		L1 = 1,
+		L3 = 3,
+		L6 = 6,
+		L9 = 9,
+		L12 = 12,
+		L15 = 15,
+		L19 = 19,
+		L22 = 22,
+
+		Fastest = L1,
+		Default = L3,
+		Best = L19,
+		Ultra = L22
+	};
+
+	size_t GetBufferCapacity() const { return _encoderProps.BufferCapacity; }
+	void SetBufferCapacity(size_t bufferCapacity) { _encoderProps.BufferCapacity = bufferCapacity; _decoderProps.BufferCapacity = bufferCapacity; }
+
+	CompressionLevel GetCompressionLevel() const { return static_cast<CompressionLevel>(_encoderProps.CompressionLevel); }
+	void SetCompressionLevel(CompressionLevel compressionLevel) { _encoderProps.CompressionLevel = static_cast<int>(compressionLevel); }
+
+	/**
+	 * \brief Long distance matching finds the repetitions far back in a large window (128 MB by default).
+	 *        The window log above 27 needs the same or larger WindowLogMax by the decompression.
+	 */
+	bool GetLongDistanceMatching() const { return _encoderProps.EnableLongDistanceMatching; }
+	void SetLongDistanceMatching(bool enable) { _encoderProps.EnableLongDistanceMatching = enable; }
+
+	int GetWindowLog() const { return _encoderProps.WindowLog; }
+	void SetWindowLog(int windowLog) { _encoderProps.WindowLog = windowLog; }
+
+	int GetWindowLogMax() const { return _decoderProps.WindowLogMax; }
+	void SetWindowLogMax(int windowLogMax) { _decoderProps.WindowLogMax = windowLogMax; }
+
+	/**
+	 * \brief Number of threads compressing a single entry, 0 to use all the cores.
+	 *        The zstd library has to be built with ZSTD_MULTITHREAD, otherwise it compresses by one thread.
+	 */
+	int GetNumThreads() const { return _encoderProps.NumThreads; }
+	void SetNumThreads(int numThreads) { _encoderProps.NumThreads = numThreads; }
+
+private:
+	zstd_encoder_properties _encoderProps;
+	zstd_decoder_properties _decoderProps;
+};
@@ -37,6 +37,13 @@ public:
 
     }
 
+    basic_compression_decoder_stream(icompression_decoder_ptr_type compressionDecoder, compression_decoder_properties_interface& props, istream_type& stream, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& memoryStreambuf)
+        : std::basic_istream<ELEM_TYPE, TRAITS_TYPE>(&_compressionDecoderStreambuf)
+        , _compressionDecoderStreambuf(compressionDecoder, props, stream, memoryStreambuf)
+    {
+
+    }
+
     bool init(icompression_decoder_ptr_type compressionDecoder, istream_type& stream)
     {
         return _compressionDecoderStreambuf.init(compressionDecoder, stream);
@@ -52,12 +59,12 @@ public:
         return _compressionDecoderStreambuf.is_init();
     }
 
-    size_t get_bytes_read() const
+    uint64_t get_bytes_read() const
     {
         return _compressionDecoderStreambuf.get_bytes_read();
     }
 
-    size_t get_bytes_written() const
+    uint64_t get_bytes_written() const
     {
         return _compressionDecoderStreambuf.get_bytes_written();
     }
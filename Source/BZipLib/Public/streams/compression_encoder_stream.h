@@ -52,12 +52,12 @@ public:
         return _compressionEncoderStreambuf.is_init();
     }
 
-    size_t get_bytes_read() const
+    uint64_t get_bytes_read() const
     {
         return _compressionEncoderStreambuf.get_bytes_read();
     }
 
-    size_t get_bytes_written() const
+    uint64_t get_bytes_written() const
     {
         return _compressionEncoderStreambuf.get_bytes_written();
     }
@@ -30,7 +30,7 @@ public:
         _crc32Streambuf.init(stream);
     }
 
-    size_t get_bytes_read() const
+    uint64_t get_bytes_read() const
     {
         return _crc32Streambuf.get_bytes_read();
     }
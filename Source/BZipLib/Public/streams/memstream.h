@@ -30,6 +30,11 @@ public:
 
     }
 
+    mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& get_mem_streambuf()
+    {
+        return _memStreambuf;
+    }
+
 private:
     mem_streambuf<ELEM_TYPE, TRAITS_TYPE> _memStreambuf;
 };
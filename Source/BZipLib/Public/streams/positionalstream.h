@@ -0,0 +1,48 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <istream>
+#include "streams/streambuffs/positional_streambuf.h"
+
+/**
+ * \brief Basic input positional stream. Creates a virtual stream over a range of a positional reader.
+ *        Unlike the substream, it does not touch any shared stream position,
+ *        so any number of these streams can read the same source from different threads.
+ *        Supports seeking within the range.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_ipositionalstream : public std::basic_istream<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+    basic_ipositionalstream()
+        : std::basic_istream<ELEM_TYPE, TRAITS_TYPE>(&_positionalStreambuf)
+    {
+
+    }
+
+    basic_ipositionalstream(positional_reader& reader, uint64_t startOffset, uint64_t length)
+        : std::basic_istream<ELEM_TYPE, TRAITS_TYPE>(&_positionalStreambuf)
+        , _positionalStreambuf(reader, startOffset, length)
+    {
+
+    }
+
+    void init(positional_reader& reader, uint64_t startOffset, uint64_t length)
+    {
+        _positionalStreambuf.init(reader, startOffset, length);
+    }
+
+    bool is_init() const
+    {
+        return _positionalStreambuf.is_init();
+    }
+
+private:
+    positional_streambuf<ELEM_TYPE, TRAITS_TYPE> _positionalStreambuf;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef basic_ipositionalstream<uint8_t, std::char_traits<uint8_t>>  byte_ipositionalstream;
+typedef basic_ipositionalstream<char, std::char_traits<char>>        ipositionalstream;
+typedef basic_ipositionalstream<wchar_t, std::char_traits<wchar_t>>  wipositionalstream;
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstring>
 
 /**
  * \brief Deserializes the basic input type. Deserializes floating number from its binary representation.
@@ -102,3 +104,70 @@ void serialize(std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>& stream, const VECTOR_
 
     stream.write(reinterpret_cast<const ELEM_TYPE*>(&value[0]), value.size());
 }
+
+/**
+ * \brief Deserializes the basic input type from the memory buffer.
+ *
+ * \tparam  RETURN_TYPE  Type of the value to be deserialized.
+ * \param   [in,out] data The current position in the buffer, advanced past the value on success.
+ * \param   end           The end of the buffer.
+ * \param   [out] out     The deserialized value.
+ *
+ * \return  true if the buffer contained enough bytes, false if not.
+ */
+template <typename RETURN_TYPE>
+bool deserialize(const uint8_t*& data, const uint8_t* end, RETURN_TYPE& out)
+{
+    if (static_cast<size_t>(end - data) < sizeof(RETURN_TYPE))
+    {
+        return false;
+    }
+
+    memcpy(&out, data, sizeof(RETURN_TYPE));
+    data += sizeof(RETURN_TYPE);
+    return true;
+}
+
+/**
+ * \brief Deserializes the string from the memory buffer.
+ *
+ * \param   [in,out] data The current position in the buffer, advanced past the string on success.
+ * \param   end           The end of the buffer.
+ * \param   [out] out     The deserialized string.
+ * \param   length        The expected length of the string.
+ *
+ * \return  true if the buffer contained enough bytes, false if not.
+ */
+inline bool deserialize(const uint8_t*& data, const uint8_t* end, std::string& out, size_t length)
+{
+    if (static_cast<size_t>(end - data) < length)
+    {
+        return false;
+    }
+
+    out.assign(reinterpret_cast<const char*>(data), length);
+    data += length;
+    return true;
+}
+
+/**
+ * \brief Deserializes the byte vector from the memory buffer.
+ *
+ * \param   [in,out] data The current position in the buffer, advanced past the vector on success.
+ * \param   end           The end of the buffer.
+ * \param   [out] out     The deserialized vector.
+ * \param   length        The expected amount of elements in the serialized vector.
+ *
+ * \return  true if the buffer contained enough bytes, false if not.
+ */
+inline bool deserialize(const uint8_t*& data, const uint8_t* end, std::vector<uint8_t>& out, size_t length)
+{
+    if (static_cast<size_t>(end - data) < length)
+    {
+        return false;
+    }
+
+    out.assign(data, data + length);
+    data += length;
+    return true;
+}
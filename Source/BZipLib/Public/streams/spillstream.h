@@ -0,0 +1,59 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <iostream>
+#include <string>
+#include "streams/streambuffs/spill_streambuf.h"
+
+/**
+ * \brief Basic spill stream. Stores the written data in the memory until they exceed the given limit,
+ *        or the optional budget shared with other spill streams is exhausted,
+ *        then continues in the spill file, which may be shared with other spill streams.
+ *        The written data can be read back, seeking is supported for reading.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_spillstream : public std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+    basic_spillstream()
+        : std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>(&_spillStreambuf)
+    {
+
+    }
+
+    basic_spillstream(size_t memoryLimit, std::shared_ptr<spill_file> spillFile, spill_budget* budget = nullptr)
+        : std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>(&_spillStreambuf)
+        , _spillStreambuf(memoryLimit, std::move(spillFile), budget)
+    {
+
+    }
+
+    void init(size_t memoryLimit, std::shared_ptr<spill_file> spillFile, spill_budget* budget = nullptr)
+    {
+        _spillStreambuf.init(memoryLimit, std::move(spillFile), budget);
+    }
+
+    bool is_spilled() const
+    {
+        return _spillStreambuf.is_spilled();
+    }
+
+    uint64_t size() const
+    {
+        return _spillStreambuf.size();
+    }
+
+    void truncate(uint64_t size)
+    {
+        _spillStreambuf.truncate(size);
+    }
+
+private:
+    spill_streambuf<ELEM_TYPE, TRAITS_TYPE> _spillStreambuf;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef basic_spillstream<uint8_t, std::char_traits<uint8_t>>  byte_spillstream;
+typedef basic_spillstream<char, std::char_traits<char>>        spillstream;
+typedef basic_spillstream<wchar_t, std::char_traits<wchar_t>>  wspillstream;
@@ -41,6 +41,11 @@ public:
 		init(compressionDecoder, stream);
 	}
 
+	compression_decoder_streambuf(icompression_decoder_ptr_type compressionDecoder, compression_decoder_properties_interface& props, istream_type& stream, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& memoryStreambuf)
+	{
+		init(compressionDecoder, props, stream, memoryStreambuf);
+	}
+
 	void init(icompression_decoder_ptr_type compressionDecoder, istream_type& stream)
 	{
 		_compressionDecoder = compressionDecoder;
@@ -63,17 +68,31 @@ public:
 		this->setg(_compressionDecoder->get_buffer_end(), _compressionDecoder->get_buffer_end(), _compressionDecoder->get_buffer_end());
 	}
 
+	/**
+	 * \brief Initializes the decoder with the input held by the memory stream buffer of the stream.
+	 */
+	void init(icompression_decoder_ptr_type compressionDecoder, compression_decoder_properties_interface& props, istream_type& stream, mem_streambuf<ELEM_TYPE, TRAITS_TYPE>& memoryStreambuf)
+	{
+		_compressionDecoder = compressionDecoder;
+
+		// compression decoder init
+		_compressionDecoder->init_in_memory(stream, props, memoryStreambuf);
+
+		// set stream buffer
+		this->setg(_compressionDecoder->get_buffer_end(), _compressionDecoder->get_buffer_end(), _compressionDecoder->get_buffer_end());
+	}
+
 	bool is_init() const
 	{
 		return _compressionDecoder->is_init();
 	}
 
-	size_t get_bytes_read() const
+	uint64_t get_bytes_read() const
 	{
 		return _compressionDecoder->get_bytes_read();
 	}
 
-	size_t get_bytes_written() const
+	uint64_t get_bytes_written() const
 	{
 		return _compressionDecoder->get_bytes_written();
 	}
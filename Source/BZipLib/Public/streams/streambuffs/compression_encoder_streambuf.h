@@ -75,12 +75,12 @@ public:
 		return _compressionEncoder->is_init();
 	}
 
-	size_t get_bytes_read() const
+	uint64_t get_bytes_read() const
 	{
 		return _compressionEncoder->get_bytes_read();
 	}
 
-	size_t get_bytes_written() const
+	uint64_t get_bytes_written() const
 	{
 		return _compressionEncoder->get_bytes_written();
 	}
@@ -3,9 +3,11 @@
 #pragma once
 #include <streambuf>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 #include "streams/substream.h"
-#include "zlib.h"
+#include "utils/crc32_utils.h"
 
 template <typename ELEM_TYPE, typename TRAITS_TYPE>
 class crc32_streambuf : public std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>
@@ -20,8 +22,7 @@ public:
 	typedef typename base_type::off_type  off_type;
 
 	crc32_streambuf()
-		: _internalBufferPosition(_internalBuffer + INTERNAL_BUFFER_SIZE)
-		, _internalBufferEnd(_internalBuffer + INTERNAL_BUFFER_SIZE)
+		: _checksumPosition(_internalBuffer + INTERNAL_BUFFER_SIZE)
 		, _inputStream(nullptr)
 		, _bytesRead(0)
 		, _crc32(0)
@@ -41,6 +42,7 @@ public:
 
 		ELEM_TYPE* endOfBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
 		this->setg(endOfBuffer, endOfBuffer, endOfBuffer);
+		_checksumPosition = endOfBuffer;
 	}
 
 	bool is_init() const
@@ -48,13 +50,16 @@ public:
 		return (_inputStream != nullptr);
 	}
 
-	size_t get_bytes_read() const
+	uint64_t get_bytes_read() const
 	{
 		return _bytesRead;
 	}
 
 	uint32_t get_crc32() const
 	{
+		// crc32 represents the checksum of what really has been read,
+		// the buffered bytes are added lazily as the reading goes on
+		this->update_crc32();
 		return _crc32;
 	}
 
@@ -62,15 +67,17 @@ protected:
 	int_type underflow() override
 	{
 		// buffer exhausted
-		if (this->gptr() >= _internalBufferEnd)
+		if (this->gptr() >= this->egptr())
 		{
+			this->update_crc32();
+
 			_inputStream->read(_internalBuffer, static_cast<std::streamsize>(INTERNAL_BUFFER_SIZE));
 			size_t n = static_cast<size_t>(_inputStream->gcount());
 
 			_bytesRead += n;
 
-			_internalBufferPosition = _internalBuffer;
-			_internalBufferEnd = _internalBuffer + n;
+			this->setg(_internalBuffer, _internalBuffer, _internalBuffer + n);
+			_checksumPosition = _internalBuffer;
 
 			if (n == 0)
 			{
@@ -78,16 +85,51 @@ protected:
 			}
 		}
 
-		// set buffer pointers, increment current position
-		ELEM_TYPE* base = _internalBufferPosition++;
+		return traits_type::to_int_type(*this->gptr());
+	}
 
-		// setting all pointers to the same position forces calling of this method each time,
-		// so crc32 really represents the checksum of what really has been read
-		this->setg(base, base, base + 1);
+	std::streamsize xsgetn(char_type* s, std::streamsize n) override
+	{
+		std::streamsize total = 0;
 
-		_crc32 = crc32(_crc32, reinterpret_cast<Bytef*>(this->gptr()), static_cast<uInt>(sizeof(ELEM_TYPE)));
+		while (total < n)
+		{
+			std::streamsize available = static_cast<std::streamsize>(this->egptr() - this->gptr());
 
-		return traits_type::to_int_type(*this->gptr());
+			if (available > 0)
+			{
+				// serve what is buffered
+				std::streamsize toCopy = std::min(available, n - total);
+				std::memcpy(s + total, this->gptr(), static_cast<size_t>(toCopy) * sizeof(ELEM_TYPE));
+
+				this->gbump(static_cast<int>(toCopy));
+				total += toCopy;
+			}
+			else if (n - total >= static_cast<std::streamsize>(INTERNAL_BUFFER_SIZE))
+			{
+				// large reads bypass the internal buffer
+				this->update_crc32();
+
+				_inputStream->read(s + total, n - total);
+				size_t read = static_cast<size_t>(_inputStream->gcount());
+
+				if (read == 0)
+				{
+					break;
+				}
+
+				_bytesRead += read;
+				_crc32 = utils::crc32::update(_crc32, s + total, read * sizeof(ELEM_TYPE));
+
+				total += static_cast<std::streamsize>(read);
+			}
+			else if (traits_type::eq_int_type(this->underflow(), traits_type::eof()))
+			{
+				break;
+			}
+		}
+
+		return total;
 	}
 
 private:
@@ -96,11 +138,19 @@ private:
 		INTERNAL_BUFFER_SIZE = 1 << 15
 	};
 
+	void update_crc32() const
+	{
+		if (this->gptr() > _checksumPosition)
+		{
+			_crc32 = utils::crc32::update(_crc32, _checksumPosition, static_cast<size_t>(this->gptr() - _checksumPosition) * sizeof(ELEM_TYPE));
+			_checksumPosition = this->gptr();
+		}
+	}
+
 	ELEM_TYPE  _internalBuffer[INTERNAL_BUFFER_SIZE];
-	ELEM_TYPE* _internalBufferPosition;
-	ELEM_TYPE* _internalBufferEnd;
+	mutable ELEM_TYPE* _checksumPosition;   // start of the consumed bytes which are not in the checksum yet
 
 	std::basic_istream<ELEM_TYPE, TRAITS_TYPE>* _inputStream;
-	size_t _bytesRead;
-	uint32_t _crc32;
+	uint64_t _bytesRead;
+	mutable uint32_t _crc32;
 };
@@ -25,6 +25,26 @@ public:
 		this->setp(buffer, buffer, endOfBuffer);
 	}
 
+	/**
+	 * \brief Direct access to the unread part of the buffer.
+	 *        Lets the consumers read the memory in place instead of copying it out.
+	 */
+	const ELEM_TYPE* get_read_pointer() const
+	{
+		return this->gptr();
+	}
+
+	size_t get_read_available() const
+	{
+		return static_cast<size_t>(this->egptr() - this->gptr());
+	}
+
+	void advance_read_pointer(size_t count)
+	{
+		assert(count <= get_read_available());
+		this->setg(this->eback(), this->gptr() + count, this->egptr());
+	}
+
 protected:
 	int_type underflow() override
 	{
@@ -68,8 +88,8 @@ protected:
 			// position of read buffer
 			if (which & std::ios::in)
 			{
-				// move gptr to the right position
-				this->gbump(static_cast<int>(this->eback() - this->gptr() + pos));
+				// move gptr to the right position, gbump is limited to int
+				this->setg(this->eback(), this->eback() + static_cast<off_type>(pos), this->egptr());
 
 				if (which & std::ios::out)
 				{
@@ -118,8 +138,8 @@ protected:
 
 			if (off >= 0 && off <= off_type(this->egptr() - this->eback()))
 			{
-				// move gptr to the right position
-				this->gbump(static_cast<int>(this->eback() - this->gptr() + off));
+				// move gptr to the right position, gbump is limited to int
+				this->setg(this->eback(), this->eback() + off, this->egptr());
 				if (which & std::ios::out)
 				{
 					// change write position to match
@@ -0,0 +1,170 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <streambuf>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+
+/**
+ * \brief Source of positional reads, which neither depend on nor change any shared stream position.
+ *        Implementations must be safe to call from multiple threads at the same time.
+ */
+class positional_reader
+{
+public:
+	virtual ~positional_reader() { }
+
+	/**
+	 * \brief Reads up to size bytes at the absolute offset.
+	 *
+	 * \return The number of bytes read, 0 at the end of the source or on failure.
+	 */
+	virtual size_t read_at(uint64_t offset, void* buffer, size_t size) = 0;
+};
+
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class positional_streambuf : public std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE> base_type;
+	typedef typename std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>::traits_type traits_type;
+
+	typedef typename base_type::char_type char_type;
+	typedef typename base_type::int_type  int_type;
+	typedef typename base_type::pos_type  pos_type;
+	typedef typename base_type::off_type  off_type;
+
+	positional_streambuf()
+		: _internalBuffer(nullptr)
+		, _reader(nullptr)
+		, _startPosition(0)
+		, _currentPosition(0)
+		, _endPosition(0)
+	{
+
+	}
+
+	positional_streambuf(positional_reader& reader, uint64_t startOffset, uint64_t length)
+		: positional_streambuf()
+	{
+		init(reader, startOffset, length);
+	}
+
+	void init(positional_reader& reader, uint64_t startOffset, uint64_t length)
+	{
+		_reader = &reader;
+		_startPosition = startOffset;
+		_currentPosition = startOffset;
+		_endPosition = startOffset + std::min(length, std::numeric_limits<uint64_t>::max() - startOffset);
+
+		if (_internalBuffer == nullptr)
+		{
+			_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		}
+
+		// set stream buffer
+		ELEM_TYPE* endOfOutputBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
+		this->setg(endOfOutputBuffer, endOfOutputBuffer, endOfOutputBuffer);
+	}
+
+	bool is_init() const
+	{
+		return (_reader != nullptr && _internalBuffer != nullptr);
+	}
+
+	virtual ~positional_streambuf()
+	{
+		if (_internalBuffer != nullptr)
+		{
+			delete[] _internalBuffer;
+		}
+	}
+
+protected:
+	int_type underflow() override
+	{
+		// buffer exhausted
+		if (this->gptr() >= this->egptr())
+		{
+			ELEM_TYPE* base = _internalBuffer;
+
+			const uint64_t remaining = (_endPosition - _currentPosition) / sizeof(ELEM_TYPE);
+			const size_t toRead = static_cast<size_t>(std::min<uint64_t>(INTERNAL_BUFFER_SIZE, remaining));
+
+			size_t n = toRead > 0
+				? _reader->read_at(_currentPosition, _internalBuffer, toRead * sizeof(ELEM_TYPE)) / sizeof(ELEM_TYPE)
+				: 0;
+
+			_currentPosition += n * sizeof(ELEM_TYPE);
+
+			if (n == 0)
+			{
+				return traits_type::eof();
+			}
+
+			// set buffer pointers
+			this->setg(base, base, base + n);
+		}
+
+		return traits_type::to_int_type(*this->gptr());
+	}
+
+	pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which = std::ios::in) override
+	{
+		if (!(which & std::ios::in))
+		{
+			return pos_type(off_type(-1));
+		}
+
+		// position of the next character to be read, relative to the start
+		const off_type bufferedElements = static_cast<off_type>(this->egptr() - this->gptr());
+		const off_type current = static_cast<off_type>((_currentPosition - _startPosition) / sizeof(ELEM_TYPE)) - bufferedElements;
+		const off_type length = static_cast<off_type>((_endPosition - _startPosition) / sizeof(ELEM_TYPE));
+
+		off_type target = off;
+		if (dir == std::ios::cur)
+		{
+			target += current;
+		}
+		else if (dir == std::ios::end)
+		{
+			target += length;
+		}
+
+		return seekpos(pos_type(target), which);
+	}
+
+	pos_type seekpos(pos_type pos, std::ios::openmode which = std::ios::in) override
+	{
+		const off_type target = static_cast<off_type>(pos);
+		const off_type length = static_cast<off_type>((_endPosition - _startPosition) / sizeof(ELEM_TYPE));
+
+		if (!(which & std::ios::in) || target < 0 || target > length)
+		{
+			return pos_type(off_type(-1));
+		}
+
+		// drop the buffer, the next read starts at the target
+		_currentPosition = _startPosition + static_cast<uint64_t>(target) * sizeof(ELEM_TYPE);
+
+		ELEM_TYPE* endOfOutputBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
+		this->setg(endOfOutputBuffer, endOfOutputBuffer, endOfOutputBuffer);
+
+		return pos;
+	}
+
+private:
+	enum : size_t
+	{
+		INTERNAL_BUFFER_SIZE = 1 << 15
+	};
+
+	ELEM_TYPE* _internalBuffer;
+
+	positional_reader* _reader;
+	uint64_t _startPosition;
+	uint64_t _currentPosition;
+	uint64_t _endPosition;
+};
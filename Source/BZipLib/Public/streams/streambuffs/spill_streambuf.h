@@ -0,0 +1,589 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <streambuf>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <algorithm>
+
+/**
+ * \brief Memory shared by several spill stream buffers.
+ *        A stream buffer moves its data to its spill file once the budget cannot hold its next segment.
+ */
+class spill_budget
+{
+public:
+	explicit spill_budget(uint64_t limit)
+		: _limit(limit)
+		, _used(0)
+	{
+
+	}
+
+	void set_limit(uint64_t limit)
+	{
+		_limit = limit;
+	}
+
+	uint64_t get_limit() const
+	{
+		return _limit;
+	}
+
+	uint64_t get_used() const
+	{
+		return _used;
+	}
+
+	bool try_reserve(uint64_t size)
+	{
+		uint64_t used = _used;
+
+		do {
+			if (used + size > _limit)
+			{
+				return false;
+			}
+		} while (!_used.compare_exchange_weak(used, used + size));
+
+		return true;
+	}
+
+	void reserve(uint64_t size)
+	{
+		_used += size;
+	}
+
+	void release(uint64_t size)
+	{
+		_used -= size;
+	}
+
+private:
+	std::atomic<uint64_t> _limit;
+	std::atomic<uint64_t> _used;
+};
+
+/**
+ * \brief Temporary file shared by several spill stream buffers, which keep their data in fixed slots of it.
+ *        The path is made only when the first slot is taken, and the file is deleted once no slot is in use,
+ *        so the stream buffers hold a single file descriptor, and none while their data fit in the memory.
+ */
+class spill_file
+{
+public:
+	typedef std::function<std::string()> path_function;
+
+	enum : size_t
+	{
+		SLOT_SIZE = 1 << 16
+	};
+
+	explicit spill_file(path_function makePath)
+		: _makePath(std::move(makePath))
+		, _nextSlot(0)
+		, _slotsInUse(0)
+	{
+
+	}
+
+	spill_file(const spill_file&) = delete;
+	spill_file& operator=(const spill_file&) = delete;
+
+	~spill_file()
+	{
+		this->close();
+	}
+
+	/**
+	 * \brief Path of the file, empty while it does not exist.
+	 */
+	std::string get_path() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _file.is_open() ? _path : std::string();
+	}
+
+	uint64_t get_slots_in_use() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _slotsInUse;
+	}
+
+	/**
+	 * \brief Takes a free slot, the file is created if it does not exist yet.
+	 *
+	 * \return false if the file cannot be created.
+	 */
+	bool allocate(uint64_t& slot)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!_file.is_open())
+		{
+			_path = _makePath();
+			_file.open(_path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+
+			if (!_file.is_open())
+			{
+				return false;
+			}
+		}
+
+		if (!_freeSlots.empty())
+		{
+			slot = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+		else
+		{
+			slot = _nextSlot++;
+		}
+
+		_slotsInUse++;
+		return true;
+	}
+
+	void release(uint64_t slot)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_freeSlots.push_back(slot);
+
+		if (--_slotsInUse == 0)
+		{
+			this->close();
+		}
+	}
+
+	bool write(uint64_t slot, size_t offset, const char* data, size_t length)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_file.clear();
+		_file.seekp(static_cast<std::streamoff>(slot * SLOT_SIZE + offset), std::ios::beg);
+		_file.write(data, static_cast<std::streamsize>(length));
+
+		return !_file.fail();
+	}
+
+	size_t read(uint64_t slot, size_t offset, char* data, size_t length)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_file.clear();
+		_file.seekg(static_cast<std::streamoff>(slot * SLOT_SIZE + offset), std::ios::beg);
+		_file.read(data, static_cast<std::streamsize>(length));
+
+		return static_cast<size_t>(_file.gcount());
+	}
+
+private:
+	void close()
+	{
+		if (_file.is_open())
+		{
+			_file.close();
+			std::remove(_path.c_str());
+		}
+
+		_freeSlots.clear();
+		_nextSlot = 0;
+	}
+
+	path_function _makePath;
+	std::string _path;
+	std::fstream _file;
+	std::vector<uint64_t> _freeSlots;
+	mutable std::mutex _mutex;
+
+	uint64_t _nextSlot;
+	uint64_t _slotsInUse;
+};
+
+/**
+ * \brief Stream buffer which keeps the written data in the memory up to the given limit,
+ *        and moves them to a spill file once the limit is exceeded.
+ *        The memory is allocated in fixed segments, which are never reallocated,
+ *        and which may be reserved from a budget shared with other stream buffers.
+ *        Once spilled, every segment takes a slot of the spill file, which may be shared with other stream buffers too.
+ *        The data can be read back (and the read position seeked) at any time.
+ *        The slots are released with the stream buffer.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class spill_streambuf : public std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE> base_type;
+	typedef typename std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>::traits_type traits_type;
+
+	typedef typename base_type::char_type char_type;
+	typedef typename base_type::int_type  int_type;
+	typedef typename base_type::pos_type  pos_type;
+	typedef typename base_type::off_type  off_type;
+
+	spill_streambuf()
+		: _budget(nullptr)
+		, _memoryLimit(0)
+		, _size(0)
+		, _readPosition(0)
+		, _spilled(false)
+	{
+
+	}
+
+	spill_streambuf(size_t memoryLimit, std::shared_ptr<spill_file> spillFile, spill_budget* budget = nullptr)
+		: spill_streambuf()
+	{
+		init(memoryLimit, std::move(spillFile), budget);
+	}
+
+	/**
+	 * \brief Without the spill file, the data stay in the memory whatever the limit.
+	 */
+	void init(size_t memoryLimit, std::shared_ptr<spill_file> spillFile, spill_budget* budget = nullptr)
+	{
+		_memoryLimit = memoryLimit;
+		_spillFile = std::move(spillFile);
+		_budget = budget;
+	}
+
+	bool is_spilled() const
+	{
+		return _spilled;
+	}
+
+	uint64_t size() const
+	{
+		return _size;
+	}
+
+	/**
+	 * \brief Drops the data after the given size, the next writes continue from there.
+	 */
+	void truncate(uint64_t size)
+	{
+		this->release_get_area();
+
+		if (size >= _size)
+		{
+			return;
+		}
+
+		_size = size;
+
+		this->release_segments(segments_for(_size));
+		this->release_slots(segments_for(_size));
+
+		_readPosition = std::min(_readPosition, _size);
+	}
+
+	virtual ~spill_streambuf()
+	{
+		this->release_segments(0);
+		this->release_slots(0);
+	}
+
+protected:
+	int_type overflow(int_type c = traits_type::eof()) override
+	{
+		if (traits_type::eq_int_type(c, traits_type::eof()))
+		{
+			return traits_type::not_eof(c);
+		}
+
+		ELEM_TYPE e = traits_type::to_char_type(c);
+		return xsputn(&e, 1) == 1 ? c : traits_type::eof();
+	}
+
+	std::streamsize xsputn(const ELEM_TYPE* s, std::streamsize n) override
+	{
+		// the get area may point into the memory, which is about to change
+		this->release_get_area();
+
+		if (!_spilled && !this->reserve_segments(_size + static_cast<uint64_t>(n)))
+		{
+			// if the file cannot be created, keep going in the memory
+			if (!this->spill(_size + static_cast<uint64_t>(n)))
+			{
+				this->reserve_segments(_size + static_cast<uint64_t>(n), true);
+			}
+		}
+
+		std::streamsize written = 0;
+
+		while (written < n)
+		{
+			const uint64_t position = _size + static_cast<uint64_t>(written);
+			const size_t offset = static_cast<size_t>(position % SEGMENT_SIZE);
+			const size_t length = static_cast<size_t>(std::min<uint64_t>(SEGMENT_SIZE - offset, static_cast<uint64_t>(n - written)));
+			const size_t index = static_cast<size_t>(position / SEGMENT_SIZE);
+
+			if (_spilled)
+			{
+				if (!this->reserve_slots(position + length)
+					|| !_spillFile->write(_slots[index], offset * sizeof(ELEM_TYPE), reinterpret_cast<const char*>(s + written), length * sizeof(ELEM_TYPE)))
+				{
+					break;
+				}
+			}
+			else
+			{
+				std::copy(s + written, s + written + length, _segments[index].get() + offset);
+			}
+
+			written += static_cast<std::streamsize>(length);
+		}
+
+		_size += static_cast<uint64_t>(written);
+		return written;
+	}
+
+	int_type underflow() override
+	{
+		// buffer exhausted
+		if (this->gptr() >= this->egptr())
+		{
+			this->release_get_area();
+
+			if (_readPosition >= _size)
+			{
+				return traits_type::eof();
+			}
+
+			if (!_spilled)
+			{
+				// the get area ends with the segment
+				const uint64_t segmentStart = _readPosition - _readPosition % SEGMENT_SIZE;
+				const size_t segmentSize = static_cast<size_t>(std::min<uint64_t>(SEGMENT_SIZE, _size - segmentStart));
+
+				ELEM_TYPE* base = _segments[static_cast<size_t>(segmentStart / SEGMENT_SIZE)].get();
+				this->setg(base, base + (_readPosition - segmentStart), base + segmentSize);
+				_readPosition = segmentStart + segmentSize;
+			}
+			else
+			{
+				// a read never crosses the end of a slot
+				const size_t offset = static_cast<size_t>(_readPosition % SEGMENT_SIZE);
+				const size_t length = static_cast<size_t>(std::min<uint64_t>(std::min<size_t>(INTERNAL_BUFFER_SIZE, SEGMENT_SIZE - offset), _size - _readPosition));
+
+				_readBuffer.resize(INTERNAL_BUFFER_SIZE);
+
+				size_t n = _spillFile->read(_slots[static_cast<size_t>(_readPosition / SEGMENT_SIZE)], offset * sizeof(ELEM_TYPE), reinterpret_cast<char*>(_readBuffer.data()), length * sizeof(ELEM_TYPE)) / sizeof(ELEM_TYPE);
+
+				if (n == 0)
+				{
+					return traits_type::eof();
+				}
+
+				ELEM_TYPE* base = _readBuffer.data();
+				this->setg(base, base, base + n);
+				_readPosition += n;
+			}
+		}
+
+		return traits_type::to_int_type(*this->gptr());
+	}
+
+	pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which = std::ios::in) override
+	{
+		if (which & std::ios::out)
+		{
+			// writes always append, only the position can be told
+			return (off == 0 && dir != std::ios::beg) ? pos_type(static_cast<off_type>(_size)) : pos_type(off_type(-1));
+		}
+
+		const off_type current = static_cast<off_type>(_readPosition) - static_cast<off_type>(this->egptr() - this->gptr());
+
+		off_type target = off;
+		if (dir == std::ios::cur)
+		{
+			target += current;
+		}
+		else if (dir == std::ios::end)
+		{
+			target += static_cast<off_type>(_size);
+		}
+
+		return seekpos(pos_type(target), which);
+	}
+
+	pos_type seekpos(pos_type pos, std::ios::openmode which = std::ios::in) override
+	{
+		const off_type target = static_cast<off_type>(pos);
+
+		if ((which & std::ios::out) || target < 0 || static_cast<uint64_t>(target) > _size)
+		{
+			return pos_type(off_type(-1));
+		}
+
+		this->setg(nullptr, nullptr, nullptr);
+		_readPosition = static_cast<uint64_t>(target);
+
+		return pos;
+	}
+
+private:
+	enum : size_t
+	{
+		INTERNAL_BUFFER_SIZE = 1 << 15,
+		SEGMENT_SIZE = spill_file::SLOT_SIZE / sizeof(ELEM_TYPE)
+	};
+
+	static size_t segments_for(uint64_t size)
+	{
+		return static_cast<size_t>((size + SEGMENT_SIZE - 1) / SEGMENT_SIZE);
+	}
+
+	/**
+	 * \brief Allocates the segments holding the data up to the given size,
+	 *        fails when they exceed the limit of the stream buffer or the budget, unless forced.
+	 */
+	bool reserve_segments(uint64_t size, bool force = false)
+	{
+		const size_t count = segments_for(size);
+
+		if (count <= _segments.size())
+		{
+			return true;
+		}
+
+		const uint64_t bytes = static_cast<uint64_t>(count - _segments.size()) * SEGMENT_SIZE * sizeof(ELEM_TYPE);
+
+		if (!force)
+		{
+			if (size > _memoryLimit
+				|| (_budget != nullptr && !_budget->try_reserve(bytes)))
+			{
+				return false;
+			}
+		}
+		else if (_budget != nullptr)
+		{
+			_budget->reserve(bytes);
+		}
+
+		while (_segments.size() < count)
+		{
+			_segments.emplace_back(new ELEM_TYPE[SEGMENT_SIZE]);
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Frees the segments after the given count and returns them to the budget.
+	 */
+	void release_segments(size_t count)
+	{
+		if (count >= _segments.size())
+		{
+			return;
+		}
+
+		if (_budget != nullptr)
+		{
+			_budget->release(static_cast<uint64_t>(_segments.size() - count) * SEGMENT_SIZE * sizeof(ELEM_TYPE));
+		}
+
+		_segments.resize(count);
+	}
+
+	/**
+	 * \brief Takes the slots of the spill file holding the data up to the given size.
+	 */
+	bool reserve_slots(uint64_t size)
+	{
+		const size_t count = segments_for(size);
+
+		while (_slots.size() < count)
+		{
+			uint64_t slot;
+
+			if (!_spillFile->allocate(slot))
+			{
+				return false;
+			}
+
+			_slots.push_back(slot);
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Returns the slots after the given count to the spill file.
+	 */
+	void release_slots(size_t count)
+	{
+		for (size_t i = count; i < _slots.size(); i++)
+		{
+			_spillFile->release(_slots[i]);
+		}
+
+		if (count < _slots.size())
+		{
+			_slots.resize(count);
+		}
+	}
+
+	void release_get_area()
+	{
+		// remember where the reading stopped
+		_readPosition -= static_cast<uint64_t>(this->egptr() - this->gptr());
+		this->setg(nullptr, nullptr, nullptr);
+	}
+
+	/**
+	 * \brief Moves the data to the spill file, with the slots for the data up to the given size.
+	 */
+	bool spill(uint64_t size)
+	{
+		if (_spillFile == nullptr)
+		{
+			return false;
+		}
+
+		if (!this->reserve_slots(size))
+		{
+			this->release_slots(0);
+			return false;
+		}
+
+		for (size_t i = 0; i < _segments.size(); i++)
+		{
+			const uint64_t segmentStart = static_cast<uint64_t>(i) * SEGMENT_SIZE;
+			const size_t length = static_cast<size_t>(std::min<uint64_t>(SEGMENT_SIZE, _size - segmentStart));
+
+			if (!_spillFile->write(_slots[i], 0, reinterpret_cast<const char*>(_segments[i].get()), length * sizeof(ELEM_TYPE)))
+			{
+				this->release_slots(0);
+				return false;
+			}
+		}
+
+		// release the memory
+		this->release_segments(0);
+
+		_spilled = true;
+		return true;
+	}
+
+	std::vector<std::unique_ptr<ELEM_TYPE[]>> _segments;
+	std::vector<ELEM_TYPE> _readBuffer;
+	std::vector<uint64_t> _slots;              //< of the spill file, one for each segment once spilled
+	std::shared_ptr<spill_file> _spillFile;    //< may be shared with other stream buffers, optional
+	spill_budget* _budget;                     //< shared with other stream buffers, optional
+
+	size_t _memoryLimit;
+	uint64_t _size;
+	uint64_t _readPosition;   //< position of the end of the get area
+	bool _spilled;
+};
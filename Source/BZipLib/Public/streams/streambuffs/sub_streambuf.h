@@ -4,6 +4,8 @@
 #include <streambuf>
 #include <istream>
 #include <cstdint>
+#include <algorithm>
+#include <limits>
 
 template <typename ELEM_TYPE, typename TRAITS_TYPE>
 class sub_streambuf : public std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>
@@ -18,7 +20,8 @@ public:
 	typedef typename base_type::off_type  off_type;
 
 	sub_streambuf()
-		: _inputStream(nullptr)
+		: _internalBuffer(nullptr)
+		, _inputStream(nullptr)
 		, _startPosition(0)
 		, _currentPosition(0)
 		, _endPosition(0)
@@ -26,19 +29,25 @@ public:
 
 	}
 
-	sub_streambuf(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, size_t length)
+	sub_streambuf(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, uint64_t length)
 		: sub_streambuf()
 	{
 		init(input, startOffset, length);
 	}
 
-	void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, size_t length)
+	void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, uint64_t length)
 	{
+		const uint64_t maxLength = static_cast<uint64_t>(std::numeric_limits<std::streamoff>::max() - static_cast<std::streamoff>(startOffset));
+
 		_inputStream = &input;
 		_startPosition = startOffset;
 		_currentPosition = startOffset;
-		_endPosition = startOffset + static_cast<pos_type>(length);
-		_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		_endPosition = startOffset + static_cast<off_type>(std::min(length, maxLength));
+
+		if (_internalBuffer == nullptr)
+		{
+			_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		}
 
 		// set stream buffer
 		ELEM_TYPE* endOfOutputBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
@@ -66,8 +75,10 @@ protected:
 		{
 			ELEM_TYPE* base = _internalBuffer;
 
+			const uint64_t remaining = static_cast<uint64_t>(static_cast<std::streamoff>(_endPosition - _currentPosition));
+
 			_inputStream->seekg(_currentPosition, std::ios::beg);
-			_inputStream->read(_internalBuffer, std::min(static_cast<size_t>(INTERNAL_BUFFER_SIZE), static_cast<size_t>(_endPosition - _currentPosition)));
+			_inputStream->read(_internalBuffer, static_cast<std::streamsize>(std::min<uint64_t>(INTERNAL_BUFFER_SIZE, remaining)));
 			size_t n = static_cast<size_t>(_inputStream->gcount());
 
 			_currentPosition += n;
@@ -0,0 +1,510 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <streambuf>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+#include "utils/aes_utils.h"
+#include "utils/sha1_utils.h"
+
+/**
+ * \brief Stream buffer of the WinZip AES encryption (AE-1/AE-2).
+ *        The encrypted data are the salt, the password verifier, the data encrypted by AES-CTR
+ *        and the authentication code, which is HMAC-SHA1 of the encrypted data.
+ *        The authentication is computed in the same pass as the encryption.
+ *        When reading, the last decrypted data are passed on only if the authentication code matches,
+ *        otherwise the stream ends early and has_failed_authentication() tells why.
+ */
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class zip_aes_streambuf : public std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	typedef std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE> base_type;
+	typedef typename std::basic_streambuf<ELEM_TYPE, TRAITS_TYPE>::traits_type traits_type;
+
+	typedef typename base_type::char_type char_type;
+	typedef typename base_type::int_type  int_type;
+	typedef typename base_type::pos_type  pos_type;
+	typedef typename base_type::off_type  off_type;
+
+	enum : size_t
+	{
+		PASSWORD_VERIFIER_SIZE = 2,
+		AUTHENTICATION_CODE_SIZE = 10,
+		KEY_DERIVATION_ITERATIONS = 1000
+	};
+
+	/**
+	 * \brief Size of the salt for the given key length, in bytes.
+	 */
+	static size_t get_salt_size(size_t keyLength)
+	{
+		return keyLength / 2;
+	}
+
+	/**
+	 * \brief Number of bytes the encryption adds to the data.
+	 */
+	static size_t get_overhead(size_t keyLength)
+	{
+		return get_salt_size(keyLength) + PASSWORD_VERIFIER_SIZE + AUTHENTICATION_CODE_SIZE;
+	}
+
+	zip_aes_streambuf()
+		: _internalBuffer(nullptr)
+		, _inputStream(nullptr)
+		, _outputStream(nullptr)
+		, _keyLength(0)
+		, _remainingLength(0)
+		, _headerDone(false)
+		, _finished(false)
+		, _hasCorrectPassword(false)
+		, _isVerified(false)
+		, _isAuthentic(false)
+	{
+		static_assert(sizeof(ELEM_TYPE) == 1, "size of ELEM_TYPE must be 1");
+	}
+
+	zip_aes_streambuf(std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength)
+		: zip_aes_streambuf()
+	{
+		init(stream, password, keyLength);
+	}
+
+	zip_aes_streambuf(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength, uint64_t encryptedLength)
+		: zip_aes_streambuf()
+	{
+		init(stream, password, keyLength, encryptedLength);
+	}
+
+	~zip_aes_streambuf()
+	{
+		if (_outputStream != nullptr)
+		{
+			finish();
+		}
+
+		if (_internalBuffer != nullptr)
+		{
+			delete[] _internalBuffer;
+		}
+	}
+
+	/**
+	 * \brief Initializes the encryption into the stream. A random salt is generated.
+	 */
+	void init(std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength)
+	{
+		_inputStream = nullptr;
+		_outputStream = &stream;
+
+		init_internal(password, keyLength);
+
+		std::random_device randomDevice;
+		for (size_t i = 0; i < get_salt_size(keyLength); i++)
+		{
+			_salt[i] = uint8_t(randomDevice());
+		}
+
+		derive_keys();
+
+		this->setp(_internalBuffer, _internalBuffer + INTERNAL_BUFFER_SIZE);
+	}
+
+	/**
+	 * \brief Initializes the decryption of the stream. The encrypted length includes the salt, the verifier and the authentication code.
+	 *        The call to prepare_for_decryption() is needed before reading.
+	 */
+	void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength, uint64_t encryptedLength)
+	{
+		_inputStream = &stream;
+		_outputStream = nullptr;
+
+		init_internal(password, keyLength);
+
+		_remainingLength = encryptedLength >= get_overhead(keyLength) ? encryptedLength - get_overhead(keyLength) : 0;
+		this->setp(nullptr, nullptr);
+	}
+
+	bool is_init() const
+	{
+		return (_inputStream != nullptr || _outputStream != nullptr);
+	}
+
+	bool has_correct_password() const
+	{
+		return _hasCorrectPassword;
+	}
+
+	/**
+	 * \brief Query if the authentication code matched, known once all the data have been read.
+	 */
+	bool is_authentic() const
+	{
+		return _isAuthentic;
+	}
+
+	/**
+	 * \brief Query if the authentication code did not match, the stream ended before its last data then.
+	 */
+	bool has_failed_authentication() const
+	{
+		return _isVerified && !_isAuthentic;
+	}
+
+	/**
+	 * \brief Skips the encrypted data not read yet and tells if the authentication code matched.
+	 */
+	bool authenticate()
+	{
+		if (_inputStream == nullptr || !_headerDone || !_hasCorrectPassword)
+		{
+			return false;
+		}
+
+		while (!_isVerified)
+		{
+			read_and_decrypt(_internalBuffer, INTERNAL_BUFFER_SIZE);
+		}
+
+		ELEM_TYPE* endOfInternalBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
+		this->setg(endOfInternalBuffer, endOfInternalBuffer, endOfInternalBuffer);
+
+		return _isAuthentic;
+	}
+
+	bool prepare_for_decryption()
+	{
+		if (_inputStream == nullptr)
+		{
+			return false;
+		}
+
+		const size_t saltSize = get_salt_size(_keyLength);
+		uint8_t storedVerifier[PASSWORD_VERIFIER_SIZE];
+
+		_inputStream->read(reinterpret_cast<ELEM_TYPE*>(_salt), static_cast<std::streamsize>(saltSize));
+		_inputStream->read(reinterpret_cast<ELEM_TYPE*>(storedVerifier), PASSWORD_VERIFIER_SIZE);
+
+		if (!*_inputStream)
+		{
+			return false;
+		}
+
+		derive_keys();
+
+		_headerDone = true;
+		_hasCorrectPassword = (memcmp(storedVerifier, _passwordVerifier, PASSWORD_VERIFIER_SIZE) == 0);
+
+		return _hasCorrectPassword;
+	}
+
+	/**
+	 * \brief Encrypts the rest of the data and writes the authentication code. Called by the destructor, if not before.
+	 */
+	void finish()
+	{
+		if (_outputStream == nullptr || _finished)
+		{
+			return;
+		}
+
+		flush_put_area();
+
+		uint8_t authenticationCode[utils::hmac_sha1::DIGEST_SIZE];
+		_hmac.final(authenticationCode);
+		_outputStream->write(reinterpret_cast<ELEM_TYPE*>(authenticationCode), AUTHENTICATION_CODE_SIZE);
+
+		_finished = true;
+		this->setp(nullptr, nullptr);
+	}
+
+protected:
+	int_type overflow(int_type c = traits_type::eof()) override
+	{
+		if (_finished)
+		{
+			return traits_type::eof();
+		}
+
+		bool is_eof = traits_type::eq_int_type(c, traits_type::eof());
+
+		// put area is full, encrypt it
+		flush_put_area();
+
+		if (!is_eof)
+		{
+			*this->pptr() = traits_type::to_char_type(c);
+			this->pbump(1);
+
+			return c;
+		}
+
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char_type* s, std::streamsize n) override
+	{
+		if (_finished)
+		{
+			return 0;
+		}
+
+		if (n < static_cast<std::streamsize>(this->epptr() - this->pptr()))
+		{
+			// small writes are collected in the put area
+			memcpy(this->pptr(), s, static_cast<size_t>(n));
+			this->pbump(static_cast<int>(n));
+
+			return n;
+		}
+
+		// large writes are encrypted straight from the source
+		flush_put_area();
+
+		std::streamsize written = 0;
+		while (written < n)
+		{
+			size_t length = static_cast<size_t>(std::min<std::streamsize>(n - written, INTERNAL_BUFFER_SIZE));
+
+			encrypt_and_write(reinterpret_cast<const uint8_t*>(s + written), length);
+			written += static_cast<std::streamsize>(length);
+		}
+
+		return n;
+	}
+
+	int_type underflow() override
+	{
+		if (!_headerDone || !_hasCorrectPassword)
+		{
+			return traits_type::eof();
+		}
+
+		// buffer exhausted
+		if (this->gptr() >= this->egptr())
+		{
+			size_t n = read_and_decrypt(_internalBuffer, INTERNAL_BUFFER_SIZE);
+
+			if (n == 0)
+			{
+				return traits_type::eof();
+			}
+
+			this->setg(_internalBuffer, _internalBuffer, _internalBuffer + n);
+		}
+
+		return traits_type::to_int_type(*this->gptr());
+	}
+
+	std::streamsize xsgetn(char_type* s, std::streamsize n) override
+	{
+		std::streamsize total = 0;
+
+		while (total < n)
+		{
+			std::streamsize available = static_cast<std::streamsize>(this->egptr() - this->gptr());
+
+			if (available > 0)
+			{
+				// serve what is decrypted already
+				std::streamsize toCopy = std::min(available, n - total);
+				memcpy(s + total, this->gptr(), static_cast<size_t>(toCopy));
+
+				this->gbump(static_cast<int>(toCopy));
+				total += toCopy;
+			}
+			else if (n - total >= static_cast<std::streamsize>(INTERNAL_BUFFER_SIZE))
+			{
+				// large reads are decrypted in place
+				if (!_headerDone || !_hasCorrectPassword)
+				{
+					break;
+				}
+
+				size_t read = read_and_decrypt(s + total, static_cast<size_t>(n - total));
+
+				if (read == 0)
+				{
+					break;
+				}
+
+				total += static_cast<std::streamsize>(read);
+			}
+			else if (traits_type::eq_int_type(this->underflow(), traits_type::eof()))
+			{
+				break;
+			}
+		}
+
+		return total;
+	}
+
+	int sync() override
+	{
+		if (_outputStream == nullptr)
+		{
+			return 0;
+		}
+
+		if (!_finished)
+		{
+			flush_put_area();
+		}
+
+		return _outputStream->rdbuf()->pubsync();
+	}
+
+private:
+	enum : size_t
+	{
+		INTERNAL_BUFFER_SIZE = 1 << 15,
+		MAX_KEY_LENGTH = 32
+	};
+
+	void init_internal(const ELEM_TYPE* password, size_t keyLength)
+	{
+		assert(password != nullptr);
+		assert(keyLength == 16 || keyLength == 24 || keyLength == 32);
+
+		_password = reinterpret_cast<const char*>(password);
+		_keyLength = keyLength;
+
+		_headerDone = false;
+		_finished = false;
+		_hasCorrectPassword = false;
+		_isVerified = false;
+		_isAuthentic = false;
+		_remainingLength = 0;
+
+		if (_internalBuffer == nullptr)
+		{
+			_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		}
+
+		ELEM_TYPE* endOfInternalBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
+		this->setg(endOfInternalBuffer, endOfInternalBuffer, endOfInternalBuffer);
+	}
+
+	void derive_keys()
+	{
+		// PBKDF2 gives the encryption key, the authentication key and the password verifier
+		uint8_t derivedKeys[2 * MAX_KEY_LENGTH + PASSWORD_VERIFIER_SIZE];
+		utils::hmac_sha1::pbkdf2(_password.data(), _password.size(), _salt, get_salt_size(_keyLength),
+			KEY_DERIVATION_ITERATIONS, derivedKeys, 2 * _keyLength + PASSWORD_VERIFIER_SIZE);
+
+		_aes.init(derivedKeys, _keyLength);
+		_hmac.init(derivedKeys + _keyLength, _keyLength);
+		memcpy(_passwordVerifier, derivedKeys + 2 * _keyLength, PASSWORD_VERIFIER_SIZE);
+
+		// the password is not needed anymore
+		std::fill(_password.begin(), _password.end(), '\0');
+		_password.clear();
+	}
+
+	void write_header()
+	{
+		if (!_headerDone)
+		{
+			_outputStream->write(reinterpret_cast<ELEM_TYPE*>(_salt), static_cast<std::streamsize>(get_salt_size(_keyLength)));
+			_outputStream->write(reinterpret_cast<ELEM_TYPE*>(_passwordVerifier), PASSWORD_VERIFIER_SIZE);
+			_headerDone = true;
+		}
+	}
+
+	void encrypt_and_write(const uint8_t* data, size_t length)
+	{
+		write_header();
+
+		uint8_t* encrypted = reinterpret_cast<uint8_t*>(_internalBuffer);
+		_aes.transform(data, encrypted, length);
+		_hmac.update(encrypted, length);
+
+		_outputStream->write(_internalBuffer, static_cast<std::streamsize>(length));
+	}
+
+	void flush_put_area()
+	{
+		write_header();
+
+		size_t length = static_cast<size_t>(this->pptr() - this->pbase());
+
+		if (length > 0)
+		{
+			encrypt_and_write(reinterpret_cast<const uint8_t*>(_internalBuffer), length);
+		}
+
+		this->setp(_internalBuffer, _internalBuffer + INTERNAL_BUFFER_SIZE);
+	}
+
+	size_t read_and_decrypt(ELEM_TYPE* buffer, size_t length)
+	{
+		length = static_cast<size_t>(std::min<uint64_t>(length, _remainingLength));
+		size_t n = 0;
+
+		if (length > 0)
+		{
+			_inputStream->read(buffer, static_cast<std::streamsize>(length));
+			n = static_cast<size_t>(_inputStream->gcount());
+
+			uint8_t* data = reinterpret_cast<uint8_t*>(buffer);
+			_hmac.update(data, n);
+			_aes.transform(data, data, n);
+
+			_remainingLength = n < length ? 0 : _remainingLength - n;
+		}
+
+		if (_remainingLength == 0 && !_isVerified)
+		{
+			verify_authentication_code();
+
+			// the data which do not match the authentication code are not passed on
+			if (!_isAuthentic)
+			{
+				return 0;
+			}
+		}
+
+		return n;
+	}
+
+	void verify_authentication_code()
+	{
+		uint8_t storedCode[AUTHENTICATION_CODE_SIZE];
+		_inputStream->read(reinterpret_cast<ELEM_TYPE*>(storedCode), AUTHENTICATION_CODE_SIZE);
+
+		uint8_t computedCode[utils::hmac_sha1::DIGEST_SIZE];
+		_hmac.final(computedCode);
+
+		_isAuthentic = static_cast<size_t>(_inputStream->gcount()) == AUTHENTICATION_CODE_SIZE
+			&& memcmp(storedCode, computedCode, AUTHENTICATION_CODE_SIZE) == 0;
+		_isVerified = true;
+	}
+
+	ELEM_TYPE* _internalBuffer;
+
+	std::basic_istream<ELEM_TYPE, TRAITS_TYPE>* _inputStream;
+	std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>* _outputStream;
+
+	std::string _password;       //< kept only until the keys are derived
+
+	utils::aes_ctr _aes;
+	utils::hmac_sha1 _hmac;
+
+	uint8_t _salt[MAX_KEY_LENGTH / 2];
+	uint8_t _passwordVerifier[PASSWORD_VERIFIER_SIZE];
+	size_t _keyLength;
+	uint64_t _remainingLength;   //< encrypted data left to read, without the authentication code
+
+	bool _headerDone;            //< salt and verifier written or read
+	bool _finished;
+	bool _hasCorrectPassword;
+	bool _isVerified;            //< the authentication code has been read and compared
+	bool _isAuthentic;
+};
@@ -7,6 +7,8 @@
 #include <chrono>
 #include <random>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 #include "zlib.h"
 
@@ -49,6 +51,12 @@ public:
 
 	~zip_crypto_streambuf()
 	{
+		// encrypt what is left in the put area
+		if (_outputStream != nullptr)
+		{
+			flush_put_area();
+		}
+
 		if (_internalBuffer != nullptr)
 		{
 			delete[] _internalBuffer;
@@ -111,23 +119,46 @@ protected:
 	{
 		bool is_eof = traits_type::eq_int_type(c, traits_type::eof());
 
-		// buffering would be great, maybe?
+		// put area is full (or not set yet), encrypt it
+		flush_put_area();
+
 		if (!is_eof)
 		{
-			if (!_encryptionHeaderWritten)
-			{
-				finish_encryption_header();
-				_outputStream->write(reinterpret_cast<ELEM_TYPE*>(&_encryptionHeader), sizeof(_encryptionHeader));
-				_encryptionHeaderWritten = true;
-			}
+			*this->pptr() = traits_type::to_char_type(c);
+			this->pbump(1);
 
-			uint8_t encryptedByte = encrypt_byte(uint8_t(c));
-			_outputStream->write(reinterpret_cast<ELEM_TYPE*>(&encryptedByte), sizeof(encryptedByte));
+			return c;
+		}
+
+		return traits_type::not_eof(c);
+	}
 
-			return encryptedByte;
+	std::streamsize xsputn(const char_type* s, std::streamsize n) override
+	{
+		if (n < static_cast<std::streamsize>(this->epptr() - this->pptr()))
+		{
+			// small writes are collected in the put area
+			std::memcpy(this->pptr(), s, static_cast<size_t>(n));
+			this->pbump(static_cast<int>(n));
+
+			return n;
+		}
+
+		// large writes are encrypted straight from the source
+		flush_put_area();
+
+		std::streamsize written = 0;
+		while (written < n)
+		{
+			size_t length = static_cast<size_t>(std::min<std::streamsize>(n - written, INTERNAL_BUFFER_SIZE));
+
+			encrypt_buffer(s + written, _internalBuffer, length);
+			_outputStream->write(_internalBuffer, static_cast<std::streamsize>(length));
+
+			written += static_cast<std::streamsize>(length);
 		}
 
-		return traits_type::eof();
+		return n;
 	}
 
 	int_type underflow() override
@@ -161,15 +192,80 @@ protected:
 		return traits_type::to_int_type(*this->gptr());
 	}
 
+	std::streamsize xsgetn(char_type* s, std::streamsize n) override
+	{
+		if (!_encryptionHeaderRead)
+		{
+			return 0;
+		}
+
+		std::streamsize total = 0;
+
+		while (total < n)
+		{
+			std::streamsize available = static_cast<std::streamsize>(this->egptr() - this->gptr());
+
+			if (available > 0)
+			{
+				// serve what is decrypted already
+				std::streamsize toCopy = std::min(available, n - total);
+				std::memcpy(s + total, this->gptr(), static_cast<size_t>(toCopy));
+
+				this->gbump(static_cast<int>(toCopy));
+				total += toCopy;
+			}
+			else if (n - total >= static_cast<std::streamsize>(INTERNAL_BUFFER_SIZE))
+			{
+				// large reads are decrypted in place
+				_inputStream->read(s + total, n - total);
+				size_t read = static_cast<size_t>(_inputStream->gcount());
+
+				if (read == 0)
+				{
+					break;
+				}
+
+				decrypt_buffer(s + total, read);
+				total += static_cast<std::streamsize>(read);
+			}
+			else if (traits_type::eq_int_type(this->underflow(), traits_type::eof()))
+			{
+				break;
+			}
+		}
+
+		return total;
+	}
+
 	int sync() override
 	{
+		if (_outputStream == nullptr)
+		{
+			return 0;
+		}
+
+		flush_put_area();
 		return _outputStream->rdbuf()->pubsync();
 	}
 
 private:
-	static uint32_t crc32_byte(uint32_t prevCrc32, uint8_t c)
+	static uint32_t crc32_byte(const z_crc_t* crcTable, uint32_t prevCrc32, uint8_t c)
+	{
+		return uint32_t(crcTable[(prevCrc32 ^ c) & 0xff] ^ (prevCrc32 >> 8));
+	}
+
+	static void update_keys(const z_crc_t* crcTable, uint32_t& key0, uint32_t& key1, uint32_t& key2, uint8_t c)
+	{
+		key0 = crc32_byte(crcTable, key0, c);
+		key1 = (key1 + (key0 & 0x000000ff)) * 0x08088405 + 1;
+		key2 = crc32_byte(crcTable, key2, uint8_t(key1 >> 24));
+	}
+
+	static uint8_t get_magic_byte(uint32_t key2)
 	{
-		return uint32_t(get_crc_table()[(prevCrc32 ^ c) & 0xff] ^ (prevCrc32 >> 8));
+		// widen before multiplying, uint16_t operands would be promoted to (overflowing) int
+		uint32_t t = (key2 & 0xFFFF) | 2;
+		return uint8_t((t * (t ^ 1)) >> 8);
 	}
 
 	bool init_internal(const ELEM_TYPE* password)
@@ -193,11 +289,25 @@ private:
 		_encryptionHeader.u32[1] = generator();
 		_encryptionHeader.u32[2] = generator();
 
-		// set stream buffer
-		_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		// set stream buffer, it serves as the get area for decryption
+		// and as the put area for encryption
+		if (_internalBuffer == nullptr)
+		{
+			_internalBuffer = new ELEM_TYPE[INTERNAL_BUFFER_SIZE];
+		}
+
 		ELEM_TYPE* endOfInternalBuffer = _internalBuffer + INTERNAL_BUFFER_SIZE;
 		this->setg(endOfInternalBuffer, endOfInternalBuffer, endOfInternalBuffer);
 
+		if (_outputStream != nullptr)
+		{
+			this->setp(_internalBuffer, endOfInternalBuffer);
+		}
+		else
+		{
+			this->setp(nullptr, nullptr);
+		}
+
 		return true;
 	}
 
@@ -241,24 +351,84 @@ private:
 
 	void decrypt_internal_buffer(size_t length)
 	{
+		decrypt_buffer(_internalBuffer, length);
+	}
+
+	/**
+	 * \brief Encrypts length bytes of input into output, the keys are kept in locals during the loop.
+	 */
+	void encrypt_buffer(const ELEM_TYPE* input, ELEM_TYPE* output, size_t length)
+	{
+		const z_crc_t* crcTable = get_crc_table();
+		uint32_t key0 = _keys.u32[0];
+		uint32_t key1 = _keys.u32[1];
+		uint32_t key2 = _keys.u32[2];
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			uint8_t c = uint8_t(input[i]);
+			output[i] = ELEM_TYPE(c ^ get_magic_byte(key2));
+			update_keys(crcTable, key0, key1, key2, c);
+		}
+
+		_keys.u32[0] = key0;
+		_keys.u32[1] = key1;
+		_keys.u32[2] = key2;
+	}
+
+	/**
+	 * \brief Decrypts length bytes in place, the keys are kept in locals during the loop.
+	 */
+	void decrypt_buffer(ELEM_TYPE* buffer, size_t length)
+	{
+		const z_crc_t* crcTable = get_crc_table();
+		uint32_t key0 = _keys.u32[0];
+		uint32_t key1 = _keys.u32[1];
+		uint32_t key2 = _keys.u32[2];
+
 		for (size_t i = 0; i < length; ++i)
 		{
-			_internalBuffer[i] = decrypt_byte(_internalBuffer[i]);
+			uint8_t c = uint8_t(uint8_t(buffer[i]) ^ get_magic_byte(key2));
+			buffer[i] = ELEM_TYPE(c);
+			update_keys(crcTable, key0, key1, key2, c);
+		}
+
+		_keys.u32[0] = key0;
+		_keys.u32[1] = key1;
+		_keys.u32[2] = key2;
+	}
+
+	/**
+	 * \brief Writes the encryption header if it is not written yet, then encrypts and writes the put area.
+	 */
+	void flush_put_area()
+	{
+		if (!_encryptionHeaderWritten)
+		{
+			finish_encryption_header();
+			_outputStream->write(reinterpret_cast<ELEM_TYPE*>(&_encryptionHeader), sizeof(_encryptionHeader));
+			_encryptionHeaderWritten = true;
+		}
+
+		size_t length = static_cast<size_t>(this->pptr() - this->pbase());
+
+		if (length > 0)
+		{
+			encrypt_buffer(_internalBuffer, _internalBuffer, length);
+			_outputStream->write(_internalBuffer, static_cast<std::streamsize>(length));
 		}
+
+		this->setp(_internalBuffer, _internalBuffer + INTERNAL_BUFFER_SIZE);
 	}
 
 	void update_keys(uint8_t c)
 	{
-		_keys.u32[0] = crc32_byte(_keys.u32[0], c);
-		_keys.u32[1] = _keys.u32[1] + uint8_t(_keys.u32[0] & 0x000000ff);
-		_keys.u32[1] = _keys.u32[1] * 0x08088405 + 1;
-		_keys.u32[2] = crc32_byte(_keys.u32[2], _keys.u32[1] >> 24);
+		update_keys(get_crc_table(), _keys.u32[0], _keys.u32[1], _keys.u32[2], c);
 	}
 
 	uint8_t get_magic_byte() const
 	{
-		uint16_t t = uint16_t(uint16_t(_keys.u32[2] & 0xFFFF) | 2);
-		return uint8_t((t * (t ^ 1)) >> 8);
+		return get_magic_byte(_keys.u32[2]);
 	}
 
 	union encryption_header
@@ -22,12 +22,12 @@ public:
 
     basic_isubstream(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset = 0)
         : std::basic_istream<ELEM_TYPE, TRAITS_TYPE>(&_subStreambuf)
-        , _subStreambuf(input, startOffset, static_cast<size_t>(-1))
+        , _subStreambuf(input, startOffset, static_cast<uint64_t>(-1))
     {
 
     }
 
-    basic_isubstream(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, size_t length)
+    basic_isubstream(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, uint64_t length)
         : std::basic_istream<ELEM_TYPE, TRAITS_TYPE>(&_subStreambuf)
         , _subStreambuf(input, startOffset, length)
     {
@@ -36,10 +36,10 @@ public:
 
     void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset = 0)
     {
-        _subStreambuf.init(input, startOffset, static_cast<size_t>(-1));
+        _subStreambuf.init(input, startOffset, static_cast<uint64_t>(-1));
     }
 
-    void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, size_t length)
+    void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& input, pos_type startOffset, uint64_t length)
     {
         _subStreambuf.init(input, startOffset, length);
     }
@@ -0,0 +1,88 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <iostream>
+#include "streams/streambuffs/zip_aes_streambuf.h"
+
+template <typename ELEM_TYPE, typename TRAITS_TYPE>
+class basic_zip_aesstream : public std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>
+{
+public:
+	basic_zip_aesstream()
+		: std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>(&_zipAesStreambuf)
+	{
+
+	}
+
+	basic_zip_aesstream(std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength)
+		: std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>(&_zipAesStreambuf)
+		, _zipAesStreambuf(stream, password, keyLength)
+	{
+
+	}
+
+	basic_zip_aesstream(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength, uint64_t encryptedLength)
+		: std::basic_iostream<ELEM_TYPE, TRAITS_TYPE>(&_zipAesStreambuf)
+		, _zipAesStreambuf(stream, password, keyLength, encryptedLength)
+	{
+
+	}
+
+	void init(std::basic_ostream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength)
+	{
+		_zipAesStreambuf.init(stream, password, keyLength);
+	}
+
+	void init(std::basic_istream<ELEM_TYPE, TRAITS_TYPE>& stream, const ELEM_TYPE* password, size_t keyLength, uint64_t encryptedLength)
+	{
+		_zipAesStreambuf.init(stream, password, keyLength, encryptedLength);
+	}
+
+	bool is_init() const
+	{
+		return _zipAesStreambuf.is_init();
+	}
+
+	bool has_correct_password() const
+	{
+		return _zipAesStreambuf.has_correct_password();
+	}
+
+	bool is_authentic() const
+	{
+		return _zipAesStreambuf.is_authentic();
+	}
+
+	bool has_failed_authentication() const
+	{
+		return _zipAesStreambuf.has_failed_authentication();
+	}
+
+	bool authenticate()
+	{
+		return _zipAesStreambuf.authenticate();
+	}
+
+	bool prepare_for_decryption()
+	{
+		return _zipAesStreambuf.prepare_for_decryption();
+	}
+
+	void finish()
+	{
+		_zipAesStreambuf.finish();
+	}
+
+	static size_t get_overhead(size_t keyLength)
+	{
+		return zip_aes_streambuf<ELEM_TYPE, TRAITS_TYPE>::get_overhead(keyLength);
+	}
+
+private:
+	zip_aes_streambuf<ELEM_TYPE, TRAITS_TYPE> _zipAesStreambuf;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef basic_zip_aesstream<uint8_t, std::char_traits<uint8_t>>  byte_zip_aesstream;
+typedef basic_zip_aesstream<char, std::char_traits<char>>        zip_aesstream;
@@ -0,0 +1,45 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+	/**
+	 * \brief AES (128, 192 or 256-bit key) in the counter mode of WinZip AES:
+	 *        the counter is a 128-bit little-endian number, the first block uses 1.
+	 *        Encryption and decryption are the same operation. AES-NI is used when the CPU has it.
+	 */
+	class aes_ctr {
+
+	public:
+		enum : size_t
+		{
+			BLOCK_SIZE = 16
+		};
+
+		aes_ctr();
+
+		/**
+		 * \brief Expands the key and resets the counter. The key length is 16, 24 or 32 bytes.
+		 */
+		void init(const uint8_t* key, size_t keyLength);
+
+		/**
+		 * \brief XORs length bytes of input with the key stream into output, continuing where the previous call ended.
+		 *        The input and the output may be the same buffer.
+		 */
+		void transform(const uint8_t* input, uint8_t* output, size_t length);
+
+	private:
+		void generate_key_stream(uint8_t* keyStream, size_t blocks);
+
+		uint8_t  _roundKeys[BLOCK_SIZE * 15];
+		int      _rounds;
+		bool     _useAesNi;
+
+		uint64_t _counter;                   //< last used counter value
+		uint8_t  _keyStream[BLOCK_SIZE];     //< key stream of the last block
+		size_t   _keyStreamPosition;         //< used bytes of _keyStream
+	};
+}
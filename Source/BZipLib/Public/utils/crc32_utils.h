@@ -0,0 +1,27 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+	/**
+	 * \brief CRC-32 (ISO-HDLC, as used by zip and zlib) over whole buffers.
+	 *        The kernel is picked once at runtime: carry-less multiplication folding on x86 with PCLMULQDQ,
+	 *        the CRC32 instructions on ARMv8, otherwise slicing-by-8 tables.
+	 */
+	class crc32 {
+
+	public:
+		/**
+		 * \brief Continues the checksum prevCrc32 (0 for a new one) with the given data.
+		 */
+		static uint32_t update(uint32_t prevCrc32, const void* data, size_t length);
+
+		/**
+		 * \brief Combines the checksums of two consecutive pieces of data, computed separately,
+		 *        into the checksum of their concatenation. length2 is the length of the second piece.
+		 */
+		static uint32_t combine(uint32_t crc1, uint32_t crc2, uint64_t length2);
+	};
+}
@@ -0,0 +1,60 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+	/**
+	 * \brief Incremental SHA-1. The state can be copied, which lets HMAC reuse its precomputed pads.
+	 */
+	class sha1 {
+
+	public:
+		enum : size_t
+		{
+			BLOCK_SIZE = 64,
+			DIGEST_SIZE = 20
+		};
+
+		sha1();
+
+		void reset();
+		void update(const void* data, size_t length);
+		void final(uint8_t digest[DIGEST_SIZE]);
+
+	private:
+		void transform(const uint8_t* block);
+
+		uint32_t _state[5];
+		uint64_t _length;
+		uint8_t _buffer[BLOCK_SIZE];
+		size_t _bufferLength;
+	};
+
+	/**
+	 * \brief Incremental HMAC-SHA1.
+	 */
+	class hmac_sha1 {
+
+	public:
+		enum : size_t
+		{
+			DIGEST_SIZE = sha1::DIGEST_SIZE
+		};
+
+		void init(const void* key, size_t keyLength);
+		void update(const void* data, size_t length);
+		void final(uint8_t digest[DIGEST_SIZE]);
+
+		/**
+		 * \brief Derives a key from the password by PBKDF2 (RFC 2898) with HMAC-SHA1.
+		 */
+		static void pbkdf2(const void* password, size_t passwordLength, const void* salt, size_t saltLength,
+			uint32_t iterations, uint8_t* key, size_t keyLength);
+
+	private:
+		sha1 _inner;
+		sha1 _outer;   //< already fed by the outer pad
+	};
+}
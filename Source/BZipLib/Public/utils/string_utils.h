@@ -0,0 +1,45 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace utils {
+	class string {
+
+	public:
+		/**
+		 * \brief Normalizes the UTF-8 entry name the same way as BZipArchiveEntry::SetFullName does:
+		 *        backslashes become slashes, leading slashes are removed and repeated slashes are collapsed.
+		 */
+		static std::string normalize_entry_name(const char* name);
+
+		static size_t hash_entry_name(const std::string& name, bool ignoreCase);
+
+		/**
+		 * \brief Hashes the raw (not yet normalized) UTF-8 entry name as if it was normalized first.
+		 *        The result is equal to hash_entry_name(normalize_entry_name(name), ignoreCase).
+		 */
+		static size_t hash_entry_name(const char* name, size_t length, bool ignoreCase);
+		static bool equals_entry_name(const std::string& lhs, const std::string& rhs, bool ignoreCase);
+	};
+
+	/**
+	 * \brief Hasher of the normalized UTF-8 entry names. Case folding is ASCII only.
+	 */
+	struct entry_name_hash
+	{
+		explicit entry_name_hash(bool ignoreCase = true) : IgnoreCase(ignoreCase) { }
+		size_t operator()(const std::string& name) const { return string::hash_entry_name(name, IgnoreCase); }
+
+		bool IgnoreCase;
+	};
+
+	struct entry_name_equal
+	{
+		explicit entry_name_equal(bool ignoreCase = true) : IgnoreCase(ignoreCase) { }
+		bool operator()(const std::string& lhs, const std::string& rhs) const { return string::equals_entry_name(lhs, rhs, IgnoreCase); }
+
+		bool IgnoreCase;
+	};
+}
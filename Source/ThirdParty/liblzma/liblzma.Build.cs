@@ -0,0 +1,37 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+using UnrealBuildTool;
+using System.IO;
+
+/// <summary>
+/// liblzma of xz utils (https://tukaani.org/xz/), used by LzmaMethod.
+/// The library is vendored as its headers (lzma.h and the lzma/ directory) in include/ and a static library
+/// in lib/(Platform)/. Without them, the plugin builds with WITH_LZMA=0 and the method is not available.
+/// Vendored: liblzma 5.4.1 for Linux x86_64, the position independent static library of the Debian liblzma-dev
+/// 5.4.1-1 package, liblzma itself is in the public domain (COPYING).
+/// Other platforms need the static library built from the same release, liblzma.lib of the xz CMake build on Win64.
+/// </summary>
+public class liblzma : ModuleRules
+{
+	public liblzma(ReadOnlyTargetRules Target) : base(Target)
+	{
+		Type = ModuleType.External;
+
+		string IncludePath = Path.Combine(ModuleDirectory, "include");
+		string LibraryPath = Path.Combine(ModuleDirectory, "lib", Target.Platform.ToString());
+		string LibraryFile = Path.Combine(LibraryPath, Target.Platform == UnrealTargetPlatform.Win64 ? "liblzma.lib" : "liblzma.a");
+
+		bool bHasLzma = File.Exists(Path.Combine(IncludePath, "lzma.h")) && File.Exists(LibraryFile);
+
+		if (bHasLzma)
+		{
+			PublicSystemIncludePaths.Add(IncludePath);
+			PublicAdditionalLibraries.Add(LibraryFile);
+
+			// the static library exports no dllimport symbols
+			PublicDefinitions.Add("LZMA_API_STATIC");
+		}
+
+		PublicDefinitions.Add("WITH_LZMA=" + (bHasLzma ? "1" : "0"));
+	}
+}
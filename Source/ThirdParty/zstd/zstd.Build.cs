@@ -0,0 +1,34 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+using UnrealBuildTool;
+using System.IO;
+
+/// <summary>
+/// Zstandard (https://github.com/facebook/zstd), used by ZstdMethod.
+/// The library is vendored as the zstd.h header in include/ and a static library built with ZSTD_MULTITHREAD
+/// in lib/(Platform)/. Without them, the plugin builds with WITH_ZSTD=0 and the method is not available.
+/// Vendored: zstd 1.5.7 for Linux x86_64, the .c and .S files of lib/common, lib/compress and lib/decompress built by
+/// gcc -O3 -fPIC -fvisibility=hidden -DZSTD_MULTITHREAD -DXXH_NAMESPACE=ZSTD_ into libzstd.a.
+/// Other platforms need the library built the same way, zstd_static.lib of the zstd CMake build on Win64.
+/// </summary>
+public class zstd : ModuleRules
+{
+	public zstd(ReadOnlyTargetRules Target) : base(Target)
+	{
+		Type = ModuleType.External;
+
+		string IncludePath = Path.Combine(ModuleDirectory, "include");
+		string LibraryPath = Path.Combine(ModuleDirectory, "lib", Target.Platform.ToString());
+		string LibraryFile = Path.Combine(LibraryPath, Target.Platform == UnrealTargetPlatform.Win64 ? "zstd_static.lib" : "libzstd.a");
+
+		bool bHasZstd = File.Exists(Path.Combine(IncludePath, "zstd.h")) && File.Exists(LibraryFile);
+
+		if (bHasZstd)
+		{
+			PublicSystemIncludePaths.Add(IncludePath);
+			PublicAdditionalLibraries.Add(LibraryFile);
+		}
+
+		PublicDefinitions.Add("WITH_ZSTD=" + (bHasZstd ? "1" : "0"));
+	}
+}
@@ -0,0 +1,80 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/crc32_utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+	/**
+	 * \brief The former kernel of crc32_streambuf, one table lookup per byte.
+	 */
+	uint32_t crc32_bytewise(uint32_t crc, const uint8_t* data, size_t length)
+	{
+		static uint32_t table[256];
+		static bool initialized = false;
+
+		if (!initialized)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					value = (value & 1) ? (value >> 1) ^ 0xedb88320 : (value >> 1);
+				}
+
+				table[i] = value;
+			}
+
+			initialized = true;
+		}
+
+		crc = ~crc;
+		while (length-- > 0)
+		{
+			crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xff];
+		}
+
+		return ~crc;
+	}
+
+	template <typename Function>
+	void measure(const char* name, const std::vector<uint8_t>& data, int repeats, Function function)
+	{
+		uint32_t crc = 0;
+
+		// warm up the caches and the tables
+		crc = function(crc, data.data(), data.size());
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < repeats; i++)
+		{
+			crc = function(crc, data.data(), data.size());
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		const double gigabytes = static_cast<double>(data.size()) * repeats / 1e9;
+		printf("%-12s %8.2f GB/s  (crc %08x)\n", name, gigabytes / elapsed.count(), crc);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const size_t megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 256;
+
+	std::vector<uint8_t> data(megabytes << 20);
+	uint32_t x = 1;
+	for (auto& byte : data)
+	{
+		x = x * 1103515245 + 12345;
+		byte = static_cast<uint8_t>(x >> 24);
+	}
+
+	measure("bytewise", data, 2, &crc32_bytewise);
+	measure("crc32", data, 8, &utils::crc32::update);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "test.h"
+#include "utils/crc32_utils.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+	uint32_t crc32_bitwise(const uint8_t* data, size_t length)
+	{
+		uint32_t crc = ~0u;
+
+		while (length-- > 0)
+		{
+			crc ^= *data++;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : (crc >> 1);
+			}
+		}
+
+		return ~crc;
+	}
+}
+
+int main()
+{
+	const char* check = "123456789";
+	TEST_CHECK(utils::crc32::update(0, check, strlen(check)) == 0xcbf43926);
+	TEST_CHECK(utils::crc32::update(0, nullptr, 0) == 0);
+
+	std::vector<uint8_t> data(100000);
+	uint32_t x = 1;
+	for (auto& byte : data)
+	{
+		x = x * 1103515245 + 12345;
+		byte = static_cast<uint8_t>(x >> 24);
+	}
+
+	// every length around the 8, 16 and 64 byte blocks of the kernels, at unaligned starts
+	for (size_t offset = 0; offset < 8; offset++)
+	{
+		for (size_t length = 0; length < 300; length++)
+		{
+			TEST_CHECK(utils::crc32::update(0, data.data() + offset, length) == crc32_bitwise(data.data() + offset, length));
+		}
+	}
+
+	const uint32_t whole = crc32_bitwise(data.data(), data.size());
+	TEST_CHECK(utils::crc32::update(0, data.data(), data.size()) == whole);
+
+	// continued and combined in pieces
+	for (size_t split : { size_t(1), size_t(63), size_t(4096), size_t(99999) })
+	{
+		const uint32_t first = utils::crc32::update(0, data.data(), split);
+		const uint32_t second = utils::crc32::update(0, data.data() + split, data.size() - split);
+
+		TEST_CHECK(utils::crc32::update(first, data.data() + split, data.size() - split) == whole);
+		TEST_CHECK(utils::crc32::combine(first, second, data.size() - split) == whole);
+	}
+
+	return test::result("crc32");
+}
@@ -0,0 +1,78 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "utils/aes_utils.h"
+#include "utils/sha1_utils.h"
+#include "zlib.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+	template <typename Function>
+	double seconds(Function function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void print(const char* name, size_t bytes, double elapsed)
+	{
+		printf("%-22s %8.3f GB/s\n", name, static_cast<double>(bytes) / 1e9 / elapsed);
+	}
+}
+
+/**
+ * \brief Compares the stages an AES entry passes: the key derivation once per entry,
+ *        then deflate, AES-CTR and HMAC-SHA1 over the data. The encryption runs on one thread,
+ *        next to the serial HMAC, and pays off to parallelize only if it is the slowest stage.
+ */
+int main(int argc, char** argv)
+{
+	const size_t megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 64;
+
+	// compressible text-like data, deflate runs at its usual speed
+	std::vector<uint8_t> data(megabytes << 20);
+	uint32_t x = 1;
+	for (auto& byte : data)
+	{
+		x = x * 1103515245 + 12345;
+		byte = static_cast<uint8_t>('a' + (x >> 24) % 16);
+	}
+
+	std::vector<uint8_t> output(data.size());
+	const uint8_t key[32] = { 1, 2, 3 };
+	const uint8_t salt[16] = { 4, 5, 6 };
+
+	const int entries = 100;
+	uint8_t derivedKeys[66];
+	double elapsed = seconds([&]()
+	{
+		for (int i = 0; i < entries; i++)
+		{
+			utils::hmac_sha1::pbkdf2("password", 8, salt, sizeof(salt), 1000, derivedKeys, sizeof(derivedKeys));
+		}
+	});
+	printf("%-22s %8.3f ms per entry\n", "pbkdf2 (1000, AES-256)", elapsed * 1000 / entries);
+
+	utils::aes_ctr aes;
+	aes.init(key, 32);
+	print("aes-256-ctr", data.size(), seconds([&]() { aes.transform(data.data(), output.data(), data.size()); }));
+
+	utils::hmac_sha1 hmac;
+	hmac.init(key, 32);
+	uint8_t digest[utils::hmac_sha1::DIGEST_SIZE];
+	print("hmac-sha1", data.size(), seconds([&]() { hmac.update(data.data(), data.size()); hmac.final(digest); }));
+
+	uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+	std::vector<uint8_t> compressed(compressedSize);
+	print("deflate (level 6)", data.size(), seconds([&]()
+	{
+		compress2(compressed.data(), &compressedSize, data.data(), static_cast<uLong>(data.size()), 6);
+	}));
+
+	return 0;
+}
@@ -0,0 +1,182 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "test.h"
+#include "streams/zip_aesstream.h"
+#include "streams/zip_cryptostream.h"
+
+#include <sstream>
+#include <string>
+
+namespace {
+	std::string make_data(size_t size)
+	{
+		std::string data(size, '\0');
+		uint32_t x = static_cast<uint32_t>(size);
+		for (auto& c : data)
+		{
+			x = x * 1103515245 + 12345;
+			c = static_cast<char>(x >> 24);
+		}
+
+		return data;
+	}
+
+	std::string aes_encrypt(const std::string& data, const char* password, size_t keyLength)
+	{
+		std::ostringstream output(std::ios::binary);
+		{
+			zip_aesstream aes(output, password, keyLength);
+			aes.write(data.data(), static_cast<std::streamsize>(data.size()));
+			aes.finish();
+		}
+
+		return output.str();
+	}
+
+	/**
+	 * \brief Decrypts in reads of the given size, returns false if the password is wrong.
+	 */
+	bool aes_decrypt(const std::string& encrypted, const char* password, size_t keyLength, size_t readSize, std::string& data, bool& isAuthentic)
+	{
+		std::istringstream input(encrypted, std::ios::binary);
+		zip_aesstream aes(input, password, keyLength, encrypted.size());
+
+		if (!aes.prepare_for_decryption())
+		{
+			return false;
+		}
+
+		std::string buffer(readSize, '\0');
+		data.clear();
+		while (aes.read(&buffer[0], static_cast<std::streamsize>(buffer.size())), aes.gcount() > 0)
+		{
+			data.append(buffer.data(), static_cast<size_t>(aes.gcount()));
+		}
+
+		isAuthentic = aes.authenticate();
+		TEST_CHECK(isAuthentic == !aes.has_failed_authentication());
+		return true;
+	}
+
+	void test_aes()
+	{
+		for (size_t keyLength : { size_t(16), size_t(24), size_t(32) })
+		{
+			const size_t overhead = zip_aesstream::get_overhead(keyLength);
+
+			// empty, smaller than and spanning the internal buffer, read by small and by large reads
+			for (size_t size : { size_t(0), size_t(1), size_t(1000), size_t(100000) })
+			{
+				const std::string data = make_data(size);
+				const std::string encrypted = aes_encrypt(data, "secret", keyLength);
+				TEST_CHECK(encrypted.size() == size + overhead);
+
+				for (size_t readSize : { size_t(7), size_t(1 << 16) })
+				{
+					std::string decrypted;
+					bool isAuthentic = false;
+
+					TEST_CHECK(aes_decrypt(encrypted, "secret", keyLength, readSize, decrypted, isAuthentic));
+					TEST_CHECK(isAuthentic);
+					TEST_CHECK(decrypted == data);
+				}
+
+				std::string decrypted;
+				bool isAuthentic = false;
+				TEST_CHECK(!aes_decrypt(encrypted, "wrong", keyLength, 7, decrypted, isAuthentic));
+
+				// a changed byte of the data or of the authentication code, the last data are not passed on
+				for (size_t offset : { overhead - 10 + size / 2, encrypted.size() - 1 })
+				{
+					if (size == 0 && offset != encrypted.size() - 1)
+					{
+						continue;
+					}
+
+					std::string tampered = encrypted;
+					tampered[offset] ^= 1;
+
+					for (size_t readSize : { size_t(7), size_t(1 << 16) })
+					{
+						TEST_CHECK(aes_decrypt(tampered, "secret", keyLength, readSize, decrypted, isAuthentic));
+						TEST_CHECK(!isAuthentic);
+						TEST_CHECK(decrypted.size() < data.size() || data.empty());
+					}
+				}
+
+				// authenticated without reading the data
+				{
+					std::istringstream input(encrypted, std::ios::binary);
+					zip_aesstream aes(input, "secret", keyLength, encrypted.size());
+					TEST_CHECK(aes.prepare_for_decryption());
+					TEST_CHECK(aes.authenticate());
+				}
+
+				// truncated
+				if (size > 0)
+				{
+					TEST_CHECK(aes_decrypt(encrypted.substr(0, encrypted.size() - 1), "secret", keyLength, 7, decrypted, isAuthentic));
+					TEST_CHECK(!isAuthentic);
+				}
+			}
+		}
+	}
+
+	void test_zip_crypto()
+	{
+		for (size_t size : { size_t(0), size_t(1), size_t(100000) })
+		{
+			const std::string data = make_data(size);
+			const uint8_t finalByte = 0x5a;
+
+			std::ostringstream output(std::ios::binary);
+			{
+				zip_cryptostream crypto(output, "secret");
+				crypto.set_final_byte(finalByte);
+				crypto.write(data.data(), static_cast<std::streamsize>(data.size()));
+				crypto.flush();
+			}
+
+			const std::string encrypted = output.str();
+			TEST_CHECK(encrypted.size() == size + 12);
+
+			for (const char* password : { "secret", "wrong" })
+			{
+				std::istringstream input(encrypted, std::ios::binary);
+				zip_cryptostream crypto(input, password);
+				crypto.set_final_byte(finalByte);
+
+				const bool hasCorrectPassword = crypto.prepare_for_decryption();
+				std::string decrypted;
+
+				if (hasCorrectPassword)
+				{
+					char buffer[4096];
+					while (crypto.read(buffer, sizeof(buffer)), crypto.gcount() > 0)
+					{
+						decrypted.append(buffer, static_cast<size_t>(crypto.gcount()));
+					}
+				}
+
+				if (strcmp(password, "secret") == 0)
+				{
+					TEST_CHECK(hasCorrectPassword);
+					TEST_CHECK(decrypted == data);
+				}
+				else
+				{
+					// the one byte check of the header passes for 1 in 256 wrong passwords
+					TEST_CHECK(!hasCorrectPassword || decrypted != data || data.empty());
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	test_aes();
+	test_zip_crypto();
+
+	return test::result("encryption");
+}
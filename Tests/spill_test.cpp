@@ -0,0 +1,313 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#include "test.h"
+#include "streams/spillstream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	std::string make_data(size_t size, uint32_t seed)
+	{
+		std::string data(size, '\0');
+		uint32_t x = seed;
+		for (auto& c : data)
+		{
+			x = x * 1103515245 + 12345;
+			c = static_cast<char>(x >> 24);
+		}
+
+		return data;
+	}
+
+	bool file_exists(const std::string& path)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	/**
+	 * \brief Spill file in the working directory, which counts the paths it makes.
+	 */
+	std::shared_ptr<spill_file> make_spill_file(int& pathsMade, const char* directory = ".")
+	{
+		return std::make_shared<spill_file>([&pathsMade, directory]()
+		{
+			return std::string(directory) + "/spill_test_" + std::to_string(pathsMade++) + ".tmp";
+		});
+	}
+
+	/**
+	 * \brief Writes in pieces of varying sizes, so they cross the segments at various offsets.
+	 */
+	void write(spillstream& stream, const std::string& data)
+	{
+		for (size_t offset = 0, piece = 1; offset < data.size(); offset += piece, piece = piece * 3 + 7)
+		{
+			piece = std::min(piece, data.size() - offset);
+			stream.write(data.data() + offset, static_cast<std::streamsize>(piece));
+		}
+	}
+
+	std::string read(spillstream& stream, uint64_t position = 0)
+	{
+		stream.clear();
+		stream.seekg(static_cast<std::streamoff>(position));
+
+		std::string result;
+		char buffer[10000];
+		while (stream.read(buffer, sizeof(buffer)), stream.gcount() > 0)
+		{
+			result.append(buffer, static_cast<size_t>(stream.gcount()));
+		}
+
+		// the end of the data is reached, the stream is written to again
+		stream.clear();
+		return result;
+	}
+
+	void test_memory()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade);
+		const std::string data = make_data(200000, 1);
+
+		spillstream stream(1 << 20, file);
+		write(stream, data);
+
+		// nothing spills, no file is made
+		TEST_CHECK(!stream.is_spilled());
+		TEST_CHECK(stream.size() == data.size());
+		TEST_CHECK(read(stream) == data);
+		TEST_CHECK(read(stream, 123456) == data.substr(123456));
+		TEST_CHECK(pathsMade == 0);
+		TEST_CHECK(file->get_path().empty());
+
+		// without a spill file, the data stay in the memory whatever the limit
+		spillstream unlimited(0, nullptr);
+		write(unlimited, data);
+		TEST_CHECK(!unlimited.is_spilled());
+		TEST_CHECK(read(unlimited) == data);
+	}
+
+	void test_spill()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade);
+		const std::string data = make_data(300000, 2);
+		std::string path;
+
+		{
+			spillstream stream(100000, file);
+			write(stream, data);
+
+			TEST_CHECK(stream.is_spilled());
+			TEST_CHECK(stream.size() == data.size());
+			TEST_CHECK(pathsMade == 1);
+
+			path = file->get_path();
+			TEST_CHECK(file_exists(path));
+			TEST_CHECK(file->get_slots_in_use() == (data.size() + spill_file::SLOT_SIZE - 1) / spill_file::SLOT_SIZE);
+
+			TEST_CHECK(read(stream) == data);
+			TEST_CHECK(read(stream, 65535) == data.substr(65535));
+			TEST_CHECK(read(stream, data.size()).empty());
+
+			// the slots after the new size are returned, the writes continue from there
+			stream.truncate(70000);
+			TEST_CHECK(stream.size() == 70000);
+			TEST_CHECK(file->get_slots_in_use() == 2);
+
+			const std::string tail = make_data(100000, 3);
+			write(stream, tail);
+			TEST_CHECK(read(stream) == data.substr(0, 70000) + tail);
+
+			stream.truncate(0);
+			TEST_CHECK(read(stream).empty());
+		}
+
+		// the file is deleted once no slot is in use
+		TEST_CHECK(file->get_slots_in_use() == 0);
+		TEST_CHECK(file->get_path().empty());
+		TEST_CHECK(!file_exists(path));
+
+		// and made again at a new path by the next spill
+		{
+			spillstream stream(0, file);
+			write(stream, data);
+			TEST_CHECK(stream.is_spilled());
+			TEST_CHECK(read(stream) == data);
+			TEST_CHECK(pathsMade == 2);
+		}
+
+		TEST_CHECK(file->get_path().empty());
+	}
+
+	void test_shared_file()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade);
+
+		std::vector<std::string> data;
+		std::vector<std::unique_ptr<spillstream>> streams;
+
+		for (uint32_t i = 0; i < 5; i++)
+		{
+			data.push_back(make_data(150000 + i * 10000, 10 + i));
+			streams.emplace_back(new spillstream(0, file));
+		}
+
+		// the slots of the streams interleave in the file
+		for (size_t offset = 0; offset < data.back().size(); offset += 40000)
+		{
+			for (size_t i = 0; i < streams.size(); i++)
+			{
+				if (offset < data[i].size())
+				{
+					streams[i]->write(data[i].data() + offset, static_cast<std::streamsize>(std::min<size_t>(40000, data[i].size() - offset)));
+				}
+			}
+		}
+
+		const std::string path = file->get_path();
+		TEST_CHECK(pathsMade == 1);
+
+		for (size_t i = 0; i < streams.size(); i++)
+		{
+			TEST_CHECK(streams[i]->is_spilled());
+			TEST_CHECK(read(*streams[i]) == data[i]);
+		}
+
+		// the freed slots are taken again, the file does not grow
+		streams[1]->truncate(0);
+		const uint64_t slotsInUse = file->get_slots_in_use();
+		write(*streams[1], data[1]);
+		TEST_CHECK(file->get_slots_in_use() == slotsInUse + (data[1].size() + spill_file::SLOT_SIZE - 1) / spill_file::SLOT_SIZE);
+		TEST_CHECK(read(*streams[1]) == data[1]);
+		TEST_CHECK(read(*streams[0]) == data[0]);
+
+		streams.clear();
+		TEST_CHECK(!file_exists(path));
+	}
+
+	void test_budget()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade);
+		spill_budget budget(4 * spill_file::SLOT_SIZE);
+
+		const std::string data = make_data(200000, 4);
+
+		{
+			// the first stream takes the budget, the second one has to spill
+			spillstream first(std::numeric_limits<size_t>::max(), file, &budget);
+			write(first, data);
+			TEST_CHECK(!first.is_spilled());
+			TEST_CHECK(budget.get_used() == 4 * spill_file::SLOT_SIZE);
+
+			spillstream second(std::numeric_limits<size_t>::max(), file, &budget);
+			write(second, data);
+			TEST_CHECK(second.is_spilled());
+			TEST_CHECK(budget.get_used() == 4 * spill_file::SLOT_SIZE);
+
+			TEST_CHECK(read(first) == data);
+			TEST_CHECK(read(second) == data);
+
+			// the segments dropped by a truncation are returned to the budget
+			first.truncate(1);
+			TEST_CHECK(budget.get_used() == spill_file::SLOT_SIZE);
+
+			spillstream third(std::numeric_limits<size_t>::max(), file, &budget);
+			write(third, data.substr(0, 150000));
+			TEST_CHECK(!third.is_spilled());
+			TEST_CHECK(budget.get_used() == 4 * spill_file::SLOT_SIZE);
+			TEST_CHECK(read(third) == data.substr(0, 150000));
+		}
+
+		TEST_CHECK(budget.get_used() == 0);
+		TEST_CHECK(pathsMade == 1);
+
+		// a spill is taken back from the budget, which never exceeds its limit
+		budget.set_limit(0);
+		{
+			spillstream stream(std::numeric_limits<size_t>::max(), file, &budget);
+			write(stream, data);
+			TEST_CHECK(stream.is_spilled());
+			TEST_CHECK(budget.get_used() == 0);
+			TEST_CHECK(read(stream) == data);
+		}
+	}
+
+	void test_failing_file()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade, "./spill_test_missing_directory");
+		const std::string data = make_data(200000, 5);
+
+		// if the file cannot be created, the data stay in the memory
+		spillstream stream(1000, file);
+		write(stream, data);
+
+		TEST_CHECK(!stream.is_spilled());
+		TEST_CHECK(stream.good());
+		TEST_CHECK(pathsMade > 0);
+		TEST_CHECK(read(stream) == data);
+		TEST_CHECK(file->get_slots_in_use() == 0);
+	}
+
+	void test_threads()
+	{
+		int pathsMade = 0;
+		auto file = make_spill_file(pathsMade);
+		std::vector<std::thread> threads;
+		std::vector<int> isIntact(8, 0);
+
+		for (uint32_t i = 0; i < isIntact.size(); i++)
+		{
+			threads.emplace_back([&file, &isIntact, i]()
+			{
+				const std::string data = make_data(500000 + i * 1000, 20 + i);
+
+				spillstream stream(50000, file);
+				write(stream, data);
+				isIntact[i] = stream.is_spilled() && read(stream) == data;
+			});
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (int intact : isIntact)
+		{
+			TEST_CHECK(intact);
+		}
+
+		TEST_CHECK(file->get_slots_in_use() == 0);
+	}
+}
+
+int main()
+{
+	test_memory();
+	test_spill();
+	test_shared_file();
+	test_budget();
+	test_failing_file();
+	test_threads();
+
+	return test::result("spill");
+}
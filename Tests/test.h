@@ -0,0 +1,31 @@
+/// MIT License, Copyright Burak Kara, burak@burak.io, https://en.wikipedia.org/wiki/MIT_License
+
+#pragma once
+#include <cstdio>
+
+/**
+ * \brief Minimal checks of the standalone tests, a test returns the number of the failed checks from main.
+ */
+namespace test {
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	inline int result(const char* name)
+	{
+		printf("%s: %s\n", name, failures() == 0 ? "OK" : "FAILED");
+		return failures() == 0 ? 0 : 1;
+	}
+}
+
+#define TEST_CHECK(condition)                                                          \
+	do                                                                                 \
+	{                                                                                  \
+		if (!(condition))                                                              \
+		{                                                                              \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);       \
+			test::failures()++;                                                        \
+		}                                                                              \
+	} while (false)